@@ -0,0 +1,19 @@
+// closestSegmentAvx2.cpp
+//
+// The AVX2 instance of the closest segment kernel.  This file is
+// built with -mavx2 -mfma, so it must only be called when
+// cpuHasAVX2().
+
+
+#include "closestSegmentKernel.h"
+
+
+int nearestSegmentArraysAVX2( const SegmentArrays &a, float px, float py, float &dist2 )
+
+{
+#ifdef HAVE_AVX2
+  return nearestSegmentArrays<SimdAVX2>( a, px, py, dist2 );
+#else
+  return nearestSegmentArraysSSE2( a, px, py, dist2 );
+#endif
+}
@@ -0,0 +1,130 @@
+// closestSegmentKernel.h
+//
+// SIMD search for the segment closest to a point, over segments
+// stored as a structure of arrays.  Like landerBatchKernel.h, this is
+// compiled for SSE2 (in landscape.cpp) and AVX2 (in
+// closestSegmentAvx2.cpp), so it only includes headers that are safe
+// in either file.
+
+
+#ifndef CLOSESTSEGMENTKERNEL_H
+#define CLOSESTSEGMENTKERNEL_H
+
+
+#include "simd.h"
+
+
+// Segment i runs from (x0[i],y0[i]) to (x0[i]+dx[i],y0[i]+dy[i]).
+// invLen2[i] is 1/(dx^2+dy^2), or 0 for a segment of zero length.
+// The arrays are padded to a multiple of 8 with segments far away.
+
+struct SegmentArrays {
+  const float *x0, *y0;
+  const float *dx, *dy;
+  const float *invLen2;
+  int          n;
+};
+
+
+// Distances from the point (x,y) to the WIDTH segments starting at
+// 'i', and keep the closer of those and 'best' (with their segment
+// numbers in 'bestSeg').
+
+template <class S>
+inline void nearestSegmentStep( const SegmentArrays &a, int i, typename S::F x, typename S::F y,
+                                typename S::F &best, typename S::I &bestSeg )
+
+{
+  typedef typename S::F F;
+
+  F dx = S::load( a.dx + i );
+  F dy = S::load( a.dy + i );
+  F ex = S::sub( x, S::load( a.x0 + i ) ); // point relative to segment tail
+  F ey = S::sub( y, S::load( a.y0 + i ) );
+
+  // Projection parameter, clamped to the segment
+
+  F t = S::mul( S::fmadd( ex, dx, S::mul( ey, dy ) ), S::load( a.invLen2 + i ) );
+  t = S::min( S::max( t, S::set1( 0 ) ), S::set1( 1 ) );
+
+  // Vector from the point to the closest point on the segment
+
+  F rx = S::sub( S::mul( t, dx ), ex );
+  F ry = S::sub( S::mul( t, dy ), ey );
+
+  F d2 = S::fmadd( rx, rx, S::mul( ry, ry ) );
+
+  F closer = S::lt( d2, best );
+  best    = S::min( d2, best );
+  bestSeg = S::asI( S::select( closer, S::asF( S::addi( S::iota(), S::set1i( i ) ) ), S::asF( bestSeg ) ) );
+}
+
+
+// Return the segment closest to (px,py) and its squared distance in
+// 'dist2'.
+//
+// Four independent sets of lanes each keep the closest of every
+// 4*WIDTH'th segment, so that the loop is not limited by the latency
+// of the compare and select, and then all lanes are reduced at the
+// end (ties go to the lower index, as in a scalar scan).
+
+template <class S>
+int nearestSegmentArrays( const SegmentArrays &a, float px, float py, float &dist2 )
+
+{
+  typedef typename S::F F;
+  typedef typename S::I I;
+
+  const F x = S::set1( px );
+  const F y = S::set1( py );
+
+  F best[4];
+  I bestSeg[4];
+
+  for (int k=0; k<4; k++) {
+    best[k]    = S::set1( 3.0e38f );
+    bestSeg[k] = S::set1i( -1 );
+  }
+
+  int i;
+
+  for (i=0; i+4*S::WIDTH<=a.n; i+=4*S::WIDTH) {
+    nearestSegmentStep<S>( a, i,            x, y, best[0], bestSeg[0] );
+    nearestSegmentStep<S>( a, i+S::WIDTH,   x, y, best[1], bestSeg[1] );
+    nearestSegmentStep<S>( a, i+2*S::WIDTH, x, y, best[2], bestSeg[2] );
+    nearestSegmentStep<S>( a, i+3*S::WIDTH, x, y, best[3], bestSeg[3] );
+  }
+
+  for ( ; i<a.n; i+=S::WIDTH)
+    nearestSegmentStep<S>( a, i, x, y, best[0], bestSeg[0] );
+
+  // Horizontal minimum over all lanes
+
+  float laneDist2[4*S::WIDTH];
+  int   laneSeg[4*S::WIDTH];
+
+  for (int k=0; k<4; k++) {
+    S::store( laneDist2 + k*S::WIDTH, best[k] );
+    S::storei( laneSeg + k*S::WIDTH, bestSeg[k] );
+  }
+
+  int result = -1;
+  dist2 = 3.0e38f;
+
+  for (int l=0; l<4*S::WIDTH; l++)
+    if (laneDist2[l] < dist2 || laneDist2[l] == dist2 && laneSeg[l] < result) {
+      dist2  = laneDist2[l];
+      result = laneSeg[l];
+    }
+
+  return result;
+}
+
+
+// Entry points for each instruction set
+
+int nearestSegmentArraysSSE2( const SegmentArrays &a, float px, float py, float &dist2 );
+int nearestSegmentArraysAVX2( const SegmentArrays &a, float px, float py, float &dist2 );
+
+
+#endif
@@ -0,0 +1,312 @@
+// collision.cpp
+
+
+#include "collision.h"
+
+
+#define MAX_OUTLINE_VERTS 512	// more than the lander model has
+
+
+static float cross( float ax, float ay, float bx, float by )
+
+{
+  return ax * by - ay * bx;
+}
+
+
+// If the ray p + s*d (s in [0,1]) crosses the segment from a to b at
+// some s < 'fraction', set 'fraction' to s
+
+static void rayVsSegment( vec3 p, vec3 d, vec3 a, vec3 b, float &fraction )
+
+{
+  float ex = b.x - a.x;
+  float ey = b.y - a.y;
+
+  float denom = cross( d.x, d.y, ex, ey );
+
+  if (denom == 0)		// parallel; the end points are tested separately
+    return;
+
+  float s = cross( a.x - p.x, a.y - p.y, ex, ey ) / denom;
+  float u = cross( a.x - p.x, a.y - p.y, d.x, d.y ) / denom;
+
+  if (s >= 0 && s < fraction && u >= 0 && u <= 1)
+    fraction = s;
+}
+
+
+// The outline in world coordinates, and its bounds
+
+static int placeOutline( const vector<float> &outline, vec3 position, float orientation, vec3 *verts,
+                         float &minX, float &minY, float &maxX, float &maxY )
+
+{
+  float c = cos( orientation );
+  float s = sin( orientation );
+
+  int numVerts = 0;
+
+  minX = minY = MAXFLOAT;
+  maxX = maxY = -MAXFLOAT;
+
+  for (int i=0; outline[i] != -1 && numVerts < MAX_OUTLINE_VERTS; i+=2) {
+
+    vec3 v( position.x + c * outline[i] - s * outline[i+1],
+            position.y + s * outline[i] + c * outline[i+1], 0 );
+
+    verts[numVerts++] = v;
+
+    minX = min( minX, v.x );
+    maxX = max( maxX, v.x );
+    minY = min( minY, v.y );
+    maxY = max( maxY, v.y );
+  }
+
+  return numVerts;
+}
+
+
+// Sweep test against one landscape segment.  A lander vertex may hit
+// the segment, or a segment end may hit a lander segment (tested as a
+// ray from the segment end in the opposite direction).
+
+struct SweepVisitor {
+  Landscape *landscape;
+  vec3      *verts;
+  int        numVerts;
+  vec3       displacement;
+  float      first;		// earliest contact so far
+
+  void operator()( int i ) {
+
+    vec3 a = landscape->vertex( i );
+    vec3 b = landscape->vertex( i+1 );
+    vec3 back = -1 * displacement;
+
+    for (int j=0; j<numVerts; j++)
+      rayVsSegment( verts[j], displacement, a, b, first );
+
+    for (int j=0; j<numVerts; j+=2) {
+      rayVsSegment( a, back, verts[j], verts[j+1], first );
+      rayVsSegment( b, back, verts[j], verts[j+1], first );
+    }
+  }
+};
+
+
+bool sweepOutline( Landscape *landscape, const vector<float> &outline,
+                   vec3 position, float orientation, vec3 displacement, float &fraction )
+
+{
+  vec3  verts[ MAX_OUTLINE_VERTS ];
+  float minX, minY, maxX, maxY;
+
+  SweepVisitor sweep;
+
+  sweep.landscape    = landscape;
+  sweep.verts        = verts;
+  sweep.numVerts     = placeOutline( outline, position, orientation, verts, minX, minY, maxX, maxY );
+  sweep.displacement = displacement;
+  sweep.first        = MAXFLOAT;
+
+  // The bounds of the sweep are those of the outline at both ends
+
+  landscape->forSegmentsInBox( min( minX, minX + displacement.x ), min( minY, minY + displacement.y ),
+                               max( maxX, maxX + displacement.x ), max( maxY, maxY + displacement.y ),
+                               sweep );
+
+  if (sweep.first > 1)
+    return false;
+
+  fraction = sweep.first;
+  return true;
+}
+
+
+// True if the segments p0-p1 and q0-q1 intersect (or touch)
+
+static bool segmentsCross( vec3 p0, vec3 p1, vec3 q0, vec3 q1 )
+
+{
+  if (max( p0.x, p1.x ) < min( q0.x, q1.x ) || min( p0.x, p1.x ) > max( q0.x, q1.x ) ||
+      max( p0.y, p1.y ) < min( q0.y, q1.y ) || min( p0.y, p1.y ) > max( q0.y, q1.y ))
+    return false;
+
+  float d1 = cross( q1.x - q0.x, q1.y - q0.y, p0.x - q0.x, p0.y - q0.y );
+  float d2 = cross( q1.x - q0.x, q1.y - q0.y, p1.x - q0.x, p1.y - q0.y );
+  float d3 = cross( p1.x - p0.x, p1.y - p0.y, q0.x - p0.x, q0.y - p0.y );
+  float d4 = cross( p1.x - p0.x, p1.y - p0.y, q1.x - p0.x, q1.y - p0.y );
+
+  if ((d1 > 0 && d2 > 0) || (d1 < 0 && d2 < 0) || (d3 > 0 && d4 > 0) || (d3 < 0 && d4 < 0))
+    return false;
+
+  if (d1 != 0 || d2 != 0 || d3 != 0 || d4 != 0)
+    return true;
+
+  // Collinear: they intersect if their bounds overlap
+
+  return (max( min( p0.x, p1.x ), min( q0.x, q1.x ) ) <= min( max( p0.x, p1.x ), max( q0.x, q1.x ) ) &&
+          max( min( p0.y, p1.y ), min( q0.y, q1.y ) ) <= min( max( p0.y, p1.y ), max( q0.y, q1.y ) ));
+}
+
+
+// Overlap test against one landscape segment
+
+struct OverlapVisitor {
+  Landscape *landscape;
+  vec3      *verts;
+  int        numVerts;
+  bool       hit;
+
+  void operator()( int i ) {
+
+    if (hit)
+      return;
+
+    vec3 a = landscape->vertex( i );
+    vec3 b = landscape->vertex( i+1 );
+
+    for (int j=0; j<numVerts && !hit; j+=2)
+      hit = segmentsCross( verts[j], verts[j+1], a, b );
+  }
+};
+
+
+bool outlineOverlaps( Landscape *landscape, const vector<float> &outline, vec3 position, float orientation )
+
+{
+  vec3  verts[ MAX_OUTLINE_VERTS ];
+  float minX, minY, maxX, maxY;
+
+  OverlapVisitor overlap;
+
+  overlap.landscape = landscape;
+  overlap.verts     = verts;
+  overlap.numVerts  = placeOutline( outline, position, orientation, verts, minX, minY, maxX, maxY );
+  overlap.hit       = false;
+
+  if (overlap.numVerts == 0)
+    return false;
+
+  landscape->forSegmentsInBox( minX, minY, maxX, maxY, overlap );
+
+  if (overlap.hit)
+    return true;
+
+  // No segments cross, so the outline is either all above or all
+  // below the landscape.  Check a vertex that is over the landscape.
+
+  float left  = landscape->vertex( 0 ).x;
+  float right = landscape->vertex( landscape->numSegments() ).x;
+
+  for (int j=0; j<overlap.numVerts; j++)
+    if (verts[j].x >= left && verts[j].x <= right)
+      return (landscape->findLanderAltitude( landscape->findSegmentBelow( verts[j] ), verts[j], 0 ) < 0);
+
+  return false;
+}
+
+
+// The earliest time in [t0,t1] at which the point is less than
+// 'margin' above the line y = a + b x, or MAXFLOAT if none
+
+static float firstTimeBelowLine( float a, float b, vec3 p, vec3 v, float ay, float margin, float t0, float t1 )
+
+{
+  // Height above the line, less the margin, is h(t) = c2 t^2 + c1 t + c0
+
+  float c2 = ay / 2;
+  float c1 = v.y - b * v.x;
+  float c0 = p.y - a - b * p.x - margin;
+
+  float h0 = (c2 * t0 + c1) * t0 + c0;
+
+  if (h0 < 0)
+    return t0;
+
+  // h is concave and h(t0) >= 0, so h becomes negative only after its
+  // larger root
+
+  float root;
+
+  if (c2 == 0) {
+    if (c1 >= 0)
+      return MAXFLOAT;
+    root = -c0 / c1;
+  } else {
+    float disc = c1 * c1 - 4 * c2 * c0;
+    if (disc < 0)
+      return MAXFLOAT;		// (cannot happen, since h(t0) >= 0)
+    root = (-c1 - sqrt( disc )) / (2 * c2);
+  }
+
+  return (root <= t1 ? max( root, t0 ) : MAXFLOAT);
+}
+
+
+float firstTimeBelow( const float *x, const float *y, int stride, int n, bool extend,
+                      vec3 p, vec3 v, float ay, float margin, float tMax )
+
+{
+  if (n < 2)
+    return MAXFLOAT;
+
+  // Walk the segments in the direction the point moves, starting with
+  // the one it is over
+
+  int i = 0;
+  while (i < n-2 && x[(i+1)*stride] <= p.x)
+    i++;
+
+  int dir = (v.x > 0 ? 1 : (v.x < 0 ? -1 : 0));
+
+  while (i >= 0 && i < n-1) {
+
+    float x0 = x[i*stride],     y0 = y[i*stride];
+    float x1 = x[(i+1)*stride], y1 = y[(i+1)*stride];
+
+    // The x range of this segment, extended past the ends of the
+    // polyline if asked
+
+    float left  = (i == 0   && extend ? -MAXFLOAT : x0);
+    float right = (i == n-2 && extend ?  MAXFLOAT : x1);
+
+    // Times at which the point is in that range
+
+    float t0, t1;
+
+    if (dir == 0) {
+      if (p.x < left || p.x > right)
+        return MAXFLOAT;
+      t0 = 0;
+      t1 = tMax;
+    } else {
+      float ta = (left  == -MAXFLOAT ? -MAXFLOAT : (left  - p.x) / v.x);
+      float tb = (right ==  MAXFLOAT ?  MAXFLOAT : (right - p.x) / v.x);
+      if (dir < 0) {
+        ta = (right ==  MAXFLOAT ? -MAXFLOAT : (right - p.x) / v.x);
+        tb = (left  == -MAXFLOAT ?  MAXFLOAT : (left  - p.x) / v.x);
+      }
+      t0 = max( ta, 0.0f );
+      t1 = min( tb, tMax );
+    }
+
+    if (t0 > tMax)
+      break;
+
+    if (t0 <= t1 && x1 > x0) {
+      float b = (y1 - y0) / (x1 - x0);
+      float t = firstTimeBelowLine( y0 - b * x0, b, p, v, ay, margin, t0, t1 );
+      if (t != MAXFLOAT)
+        return t;
+    }
+
+    if (dir == 0)
+      break;
+
+    i += dir;
+  }
+
+  return MAXFLOAT;
+}
@@ -0,0 +1,51 @@
+// collision.h
+//
+// Collisions between the lander outline and the landscape.
+//
+// The lander outline is given as segments (x,y vertex pairs around
+// the lander centre, ending in -1, as from Lander::getVertices()),
+// which are rotated by the lander's orientation and translated to
+// its position.
+
+
+#ifndef COLLISION_H
+#define COLLISION_H
+
+
+#include "landscape.h"
+
+
+// Sweep the outline at 'position' and 'orientation' along
+// 'displacement' (with the orientation fixed, as in one step of
+// Lander::updatePose()).  If it hits the landscape, return true and
+// set 'fraction' to the part of the displacement, in [0,1], covered
+// before it first touches.
+//
+// Only landscape segments within the bounds of the sweep are tested.
+
+bool sweepOutline( Landscape *landscape, const vector<float> &outline,
+                   vec3 position, float orientation, vec3 displacement, float &fraction );
+
+// True if the outline at 'position' and 'orientation' touches or
+// crosses the landscape, or is entirely below it.  Only landscape
+// segments within the bounds of the outline are tested.
+
+bool outlineOverlaps( Landscape *landscape, const vector<float> &outline, vec3 position, float orientation );
+
+// The earliest time t in [0,tMax] at which the point
+//
+//     ( p.x + v.x t,  p.y + v.y t + ay t^2 / 2 )
+//
+// is less than 'margin' above the polyline with vertices (x[i*stride],
+// y[i*stride]), i = 0..n-1, in increasing x.  If 'extend', the end
+// segments continue beyond the ends of the polyline; otherwise
+// nothing is there.  Returns MAXFLOAT if there is no such time.
+//
+// 'ay' must not be positive, so that the height above each segment is
+// a concave quadratic in t.
+
+float firstTimeBelow( const float *x, const float *y, int stride, int n, bool extend,
+                      vec3 p, vec3 v, float ay, float margin, float tMax );
+
+
+#endif
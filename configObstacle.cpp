@@ -0,0 +1,282 @@
+// configObstacle.cpp
+
+
+#include "configObstacle.h"
+
+#include <algorithm>
+
+
+// One line segment (with x0 < x1) that may be part of F
+
+struct Piece {
+  float x0, y0, x1, y1;
+
+  float slope()      const { return (y1 - y0) / (x1 - x0); }
+  float at( float x ) const { return y0 + slope() * (x - x0); }
+
+  bool operator < ( const Piece &p ) const { return x0 < p.x0; }
+};
+
+
+static bool leftToRight( const vec3 &a, const vec3 &b )
+
+{
+  return a.x < b.x || a.x == b.x && a.y < b.y;
+}
+
+
+ConfigObstacle::ConfigObstacle( Landscape *landscape, const vector<float> &landerVerts, int numOrientations )
+
+{
+  vector<vec3> points;
+
+  for (int i=0; landerVerts[i] != -1; i+=2)
+    points.push_back( vec3( landerVerts[i], landerVerts[i+1], 0 ) );
+
+  envelopes.resize( numOrientations );
+
+  for (int k=0; k<numOrientations; k++) {
+
+    // Rotate the outline CCW, as the lander is drawn
+
+    float theta = 2 * M_PI * k / numOrientations;
+    float c = cos( theta );
+    float s = sin( theta );
+
+    vector<vec3> r( points.size() );
+    for (unsigned int i=0; i<points.size(); i++)
+      r[i] = vec3( c * points[i].x - s * points[i].y, s * points[i].x + c * points[i].y, 0 );
+
+    // Lower hull, left to right (Andrew's monotone chain).  Only the
+    // lower hull can touch the landscape first.
+
+    sort( r.begin(), r.end(), leftToRight );
+
+    vector<vec3> lower;
+
+    for (unsigned int i=0; i<r.size(); i++) {
+      while (lower.size() >= 2) {
+        vec3 &o = lower[lower.size()-2];
+        vec3 &a = lower[lower.size()-1];
+        if ((a.x - o.x) * (r[i].y - o.y) - (a.y - o.y) * (r[i].x - o.x) > 0)
+          break;
+        lower.pop_back();
+      }
+      lower.push_back( r[i] );
+    }
+
+    vector<float> hull;
+    for (unsigned int i=0; i<lower.size(); i++) {
+      hull.push_back( lower[i].x );
+      hull.push_back( lower[i].y );
+    }
+
+    buildEnvelope( envelopes[k], landscape, hull );
+  }
+}
+
+
+// Build F for one orientation, given the lower hull as x,y pairs.
+//
+// F(x) is the highest landscape point under any point of the hull,
+// less that point's height in the hull.  Since the landscape and the
+// hull are both polylines, F is the upper envelope of two families of
+// segments: each landscape segment shifted by each hull vertex, and
+// each hull edge (upside down) hung from each landscape vertex.
+// Between the endpoints of these segments, the envelope of the
+// segments that span the interval is found by following the highest
+// line and switching to any steeper line that overtakes it.
+
+
+void ConfigObstacle::buildEnvelope( Envelope &e, Landscape *landscape, const vector<float> &hull )
+
+{
+  int numVerts = landscape->numSegments() + 1;
+  int numHull  = hull.size() / 2;
+
+  vector<Piece> pieces;
+  vector<float> events;
+
+  for (int k=0; k<numVerts; k++) {
+
+    vec3 a = landscape->vertex( k );
+
+    for (int j=0; j<numHull; j++) {
+
+      float hx = hull[2*j];
+      float hy = hull[2*j+1];
+
+      if (k < numVerts-1) {
+        vec3 b = landscape->vertex( k+1 );
+        if (b.x > a.x) {
+          Piece p = { a.x - hx, a.y - hy, b.x - hx, b.y - hy };
+          pieces.push_back( p );
+        }
+      }
+
+      if (j < numHull-1 && hull[2*(j+1)] > hx) {
+        Piece p = { a.x - hull[2*(j+1)], a.y - hull[2*(j+1)+1], a.x - hx, a.y - hy };
+        pieces.push_back( p );
+      }
+    }
+  }
+
+  for (unsigned int i=0; i<pieces.size(); i++) {
+    events.push_back( pieces[i].x0 );
+    events.push_back( pieces[i].x1 );
+  }
+
+  sort( pieces.begin(), pieces.end() );
+  sort( events.begin(), events.end() );
+  events.erase( unique( events.begin(), events.end() ), events.end() );
+
+  e.x.clear();
+  e.y.clear();
+
+  vector<int> active;
+  unsigned int next = 0;
+
+  for (unsigned int ev=0; ev+1<events.size(); ev++) {
+
+    float a = events[ev];
+    float b = events[ev+1];
+
+    // Pieces that span [a,b]
+
+    while (next < pieces.size() && pieces[next].x0 <= a)
+      active.push_back( next++ );
+
+    unsigned int n = 0;
+    for (unsigned int i=0; i<active.size(); i++)
+      if (pieces[active[i]].x1 > a)
+        active[n++] = active[i];
+    active.resize( n );
+
+    if (active.empty())
+      continue;
+
+    // The highest piece at a (the steepest, if several are equal)
+
+    float x = a;
+    int   cur = active[0];
+
+    for (unsigned int i=1; i<active.size(); i++) {
+      const Piece &p = pieces[active[i]];
+      float d = p.at( x ) - pieces[cur].at( x );
+      if (d > 1e-4 || d > -1e-4 && p.slope() > pieces[cur].slope())
+        cur = active[i];
+    }
+
+    addVertex( e, x, pieces[cur].at( x ) );
+
+    // Follow it, switching to steeper pieces where they overtake it
+
+    while (true) {
+
+      float curSlope = pieces[cur].slope();
+      float curY     = pieces[cur].at( x );
+      float bestX    = b;
+      int   best     = -1;
+
+      for (unsigned int i=0; i<active.size(); i++) {
+        const Piece &p = pieces[active[i]];
+        float slope = p.slope();
+        if (slope <= curSlope)
+          continue;
+        float xc = x + fmax( curY - p.at( x ), 0 ) / (slope - curSlope);
+        if (xc < bestX || xc == bestX && best >= 0 && slope > pieces[best].slope()) {
+          bestX = xc;
+          best  = active[i];
+        }
+      }
+
+      if (best < 0)
+        break;
+
+      x   = bestX;
+      cur = best;
+      addVertex( e, x, pieces[cur].at( x ) );
+    }
+
+    addVertex( e, b, pieces[cur].at( b ) );
+  }
+
+  // Drop the vertices in the middle of straight runs
+
+  unsigned int n = 0;
+
+  for (unsigned int i=0; i<e.x.size(); i++) {
+    if (n >= 2 && e.x[n-1] > e.x[n-2] && e.x[i] > e.x[n-1]) {
+      float s0 = (e.y[n-1] - e.y[n-2]) / (e.x[n-1] - e.x[n-2]);
+      float s1 = (e.y[i]   - e.y[n-1]) / (e.x[i]   - e.x[n-1]);
+      if (fabs( s1 - s0 ) < 1e-5)
+        n--;
+    }
+    e.x[n] = e.x[i];
+    e.y[n] = e.y[i];
+    n++;
+  }
+
+  e.x.resize( n );
+  e.y.resize( n );
+}
+
+
+// Add a vertex to F.  F jumps where the lander passes the top of a
+// vertical landscape segment, so there may be two vertices at one x:
+// the limits of F from the left and from the right.
+
+
+void ConfigObstacle::addVertex( Envelope &e, float x, float y )
+
+{
+  int n = e.x.size();
+
+  if (n > 0 && x == e.x[n-1]) {
+    if (n > 1 && x == e.x[n-2])
+      e.y[n-1] = y;		// a later limit from the right
+    else if (fabs( y - e.y[n-1] ) > 1e-5) {
+      e.x.push_back( x );
+      e.y.push_back( y );
+    }
+    return;
+  }
+
+  e.x.push_back( x );
+  e.y.push_back( y );
+}
+
+
+// The nearest computed orientation to 'orientation'
+
+
+int ConfigObstacle::orientationIndex( float orientation )
+
+{
+  int n = envelopes.size();
+  int k = (int) lround( orientation / (2 * M_PI) * n ) % n;
+
+  return (k < 0 ? k + n : k);
+}
+
+
+float ConfigObstacle::height( float x, float orientation )
+
+{
+  const Envelope &e = envelopes[orientationIndex( orientation )];
+
+  if (e.x.empty() || x < e.x.front() || x > e.x.back())
+    return -MAXFLOAT;
+
+  int i = upper_bound( e.x.begin(), e.x.end(), x ) - e.x.begin() - 1;
+
+  if (i > (int) e.x.size() - 2)
+    i = e.x.size() - 2;
+  if (i < 0)
+    return e.y[0];
+
+  if (e.x[i+1] == e.x[i])	// at a jump
+    return fmax( e.y[i], e.y[i+1] );
+
+  return e.y[i] + (e.y[i+1] - e.y[i]) * (x - e.x[i]) / (e.x[i+1] - e.x[i]);
+}
@@ -0,0 +1,77 @@
+// configObstacle.h
+//
+// The landscape as an obstacle in the lander's configuration space.
+//
+// For a lander with orientation 'theta', the set of centre positions
+// at which the lander outline touches or overlaps the landscape is
+// the Minkowski sum of the region below the landscape with the
+// reflected lander.  Its upper boundary is a polyline F(x), so the
+// lander overlaps the landscape exactly when its centre c has
+//
+//     c.y < F(c.x)
+//
+// and c.y - F(c.x) is the vertical distance the lander can drop
+// before it touches.  F is computed once for each of a fixed number
+// of orientations, after which a query is a binary search in F.
+//
+// The lander is treated as its convex hull, so a peak that pokes up
+// between the legs counts as touching the lander.  The orientation is
+// rounded to the nearest computed one; with CSPACE_ORIENTATIONS of
+// 256, that moves the outline by at most 0.05 m.
+
+
+#ifndef CONFIGOBSTACLE_H
+#define CONFIGOBSTACLE_H
+
+
+#include "landscape.h"
+#include "lander.h"
+
+
+#define CSPACE_ORIENTATIONS 256	// default number of orientations
+
+
+class ConfigObstacle {
+
+  struct Envelope {
+    vector<float> x, y;		// vertices of F, in increasing x
+  };
+
+  vector<Envelope> envelopes;	// one per orientation
+
+  void buildEnvelope( Envelope &e, Landscape *landscape, const vector<float> &hull );
+  void addVertex( Envelope &e, float x, float y );
+  int  orientationIndex( float orientation );
+
+ public:
+
+  // Build F for 'numOrientations' evenly spaced orientations of the
+  // outline 'landerVerts' (x,y pairs around (0,0), ending in -1, as
+  // from Lander::getVertices())
+
+  ConfigObstacle( Landscape *landscape, const vector<float> &landerVerts,
+                  int numOrientations = CSPACE_ORIENTATIONS );
+
+  // F(x) for the lander at 'orientation' (radians CCW), or -MAXFLOAT
+  // if no part of the lander can be over the landscape at 'x'
+
+  float height( float x, float orientation );
+
+  // Vertical distance the lander can drop before it touches the
+  // landscape (negative if it overlaps the landscape)
+
+  float clearance( vec3 centre, float orientation ) {
+    return centre.y - height( centre.x, orientation );
+  }
+
+  // The vertices of F for 'orientation' (see height())
+
+  const vector<float> &envelopeX( float orientation ) { return envelopes[orientationIndex( orientation )].x; }
+  const vector<float> &envelopeY( float orientation ) { return envelopes[orientationIndex( orientation )].y; }
+
+  int numOrientations() { return envelopes.size(); }
+  int numVertices( int orientation ) { return envelopes[orientation].x.size(); }
+};
+
+
+#endif
@@ -0,0 +1,60 @@
+// controllers.cpp
+
+
+#include "controllers.h"
+#include "session.h"
+
+
+#define MAX_TILT        0.5	// largest tilt used to cancel horizontal speed (radians)
+#define TILT_PER_SPEED  0.05	// tilt per m/s of horizontal speed
+#define TILT_TOLERANCE  0.01	// orientation error that is ignored (radians)
+#define DESCENT_PER_ALT 0.05	// target descent speed per m of altitude
+#define MIN_DESCENT     0.4	// target descent speed at touchdown (m/s)
+
+
+Controls freeFallController( Session &session, float deltaT, void *data )
+
+{
+  return CONTROL_NONE;
+}
+
+
+Controls descentController( Session &session, float deltaT, void *data )
+
+{
+  if (!session.running())
+    return CONTROL_NONE;
+
+  Lander    *lander    = session.getLander();
+  Landscape *landscape = session.getLandscape();
+
+  vec3  pos = lander->centrePosition();
+  vec3  vel = lander->getVelocity();
+  float alt = landscape->findLanderAltitude( landscape->findSegmentBelow( pos ), pos, lander->getDimensions().y );
+
+  Controls c = CONTROL_NONE;
+
+  // Tilt against the horizontal velocity (a positive orientation
+  // thrusts toward -x), upright when close to the ground
+
+  float tilt = TILT_PER_SPEED * vel.x;
+  if (tilt > MAX_TILT)  tilt = MAX_TILT;
+  if (tilt < -MAX_TILT) tilt = -MAX_TILT;
+  if (alt < 5)
+    tilt = 0;
+
+  float err = tilt - lander->getOrientation();
+  if (err > TILT_TOLERANCE)
+    c |= CONTROL_ROTATE_CCW;
+  else if (err < -TILT_TOLERANCE)
+    c |= CONTROL_ROTATE_CW;
+
+  // Thrust to hold the target descent speed, or to brake sideways
+
+  float targetVy = -(MIN_DESCENT + DESCENT_PER_ALT * alt);
+
+  if (vel.y < targetVy || fabs( vel.x ) > 0.3 && fabs( lander->getOrientation() ) > 0.1)
+    c |= CONTROL_THRUST;
+
+  return c;
+}
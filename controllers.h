@@ -0,0 +1,23 @@
+// controllers.h
+//
+// Simple built-in lander controllers for use with ControllerInput
+
+
+#ifndef CONTROLLERS_H
+#define CONTROLLERS_H
+
+
+#include "input.h"
+
+
+// Never fire anything: the lander falls under gravity
+
+Controls freeFallController( Session &session, float deltaT, void *data );
+
+// Tilt against the horizontal velocity and fire the main engine to
+// hold a descent rate that shrinks with altitude.
+
+Controls descentController( Session &session, float deltaT, void *data );
+
+
+#endif
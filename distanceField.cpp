@@ -0,0 +1,109 @@
+// distanceField.cpp
+
+
+#include "distanceField.h"
+
+#include <thread>
+
+
+DistanceField::DistanceField( Landscape *landscape, float x0, float x1, float y0, float y1,
+                              float size, int numThreads )
+
+{
+  minX = x0;
+  minY = y0;
+  cellSize = size;
+
+  nx = max( 2, (int) ceil( (x1 - x0) / cellSize ) + 1 );
+  ny = max( 2, (int) ceil( (y1 - y0) / cellSize ) + 1 );
+
+  samples.resize( nx * ny );
+
+  if (numThreads <= 0)
+    numThreads = thread::hardware_concurrency();
+  if (numThreads <= 0)
+    numThreads = 1;
+  if (numThreads > ny)
+    numThreads = ny;
+
+  // Each thread fills a band of rows.  Landscape queries do not
+  // modify the landscape, so the threads can share it.
+
+  vector<thread> threads;
+
+  for (int t=0; t<numThreads; t++)
+    threads.push_back( thread( &DistanceField::buildRows, this, landscape,
+                               ny * t / numThreads, ny * (t+1) / numThreads ) );
+
+  for (int t=0; t<numThreads; t++)
+    threads[t].join();
+}
+
+
+// Fill rows [firstRow,lastRow) with exact distances from the
+// landscape's BVH.  A sample is below the landscape if it is below
+// the segment under it.
+
+
+void DistanceField::buildRows( Landscape *landscape, int firstRow, int lastRow )
+
+{
+  for (int j=firstRow; j<lastRow; j++)
+    for (int i=0; i<nx; i++) {
+
+      vec3 p( minX + i * cellSize, minY + j * cellSize, 0 );
+
+      float dist2;
+      if (landscape->findClosestSegment( p, dist2 ) < 0) {
+        samples[j*nx + i] = MAXFLOAT;
+        continue;
+      }
+
+      float d = sqrt( dist2 );
+
+      if (landscape->findLanderAltitude( landscape->findSegmentBelow( p ), p, 0 ) < 0)
+        d = -d;
+
+      samples[j*nx + i] = d;
+    }
+}
+
+
+float DistanceField::distance( vec3 position )
+
+{
+  // Position in grid cells, clamped to the grid
+
+  float gx = (position.x - minX) / cellSize;
+  float gy = (position.y - minY) / cellSize;
+
+  float cx = min( max( gx, 0.0f ), (float) (nx-1) );
+  float cy = min( max( gy, 0.0f ), (float) (ny-1) );
+
+  int i = (int) cx;
+  int j = (int) cy;
+
+  if (i > nx-2) i = nx-2;
+  if (j > ny-2) j = ny-2;
+
+  float fx = cx - i;
+  float fy = cy - j;
+
+  const float *s = &samples[j*nx + i];
+
+  float bottom = s[0]  + fx * (s[1]    - s[0]);
+  float top    = s[nx] + fx * (s[nx+1] - s[nx]);
+
+  float d = bottom + fy * (top - bottom);
+
+  // Outside the grid, the point may be closer to the landscape than
+  // the grid edge by as much as the distance to the edge
+
+  if (gx != cx || gy != cy) {
+    float ox = (gx - cx) * cellSize;
+    float oy = (gy - cy) * cellSize;
+    d -= (d < 0 ? -1 : 1) * sqrt( ox*ox + oy*oy );
+  }
+
+  return d;
+}
@@ -0,0 +1,56 @@
+// distanceField.h
+//
+// The signed distance to the landscape, sampled on a regular grid
+// and interpolated bilinearly.  Distances are positive above the
+// landscape and negative below it.
+//
+// A lookup costs the same wherever the point is and does not touch
+// the landscape segments, so it is used to skip the exact (and more
+// costly) closest-point query when the lander is far from the
+// landscape.  Since distance changes by at most the distance moved,
+// the interpolated value is within maxError() of the true distance.
+
+
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+
+#include "landscape.h"
+
+
+#define DF_CELL_SIZE 2.0	// default grid spacing (m)
+
+
+class DistanceField {
+
+  float minX, minY;		// grid origin (world coordinates)
+  float cellSize;
+  int   nx, ny;			// number of samples in x and y
+  vector<float> samples;	// row by row, from the bottom
+
+  void buildRows( Landscape *landscape, int firstRow, int lastRow );
+
+ public:
+
+  // Sample the distance to 'landscape' over the given bounds.  The
+  // rows are split among 'numThreads' threads (0 for one per core).
+
+  DistanceField( Landscape *landscape, float minX, float maxX, float minY, float maxY,
+                 float cellSize = DF_CELL_SIZE, int numThreads = 0 );
+
+  // Approximate signed distance from 'position' to the landscape.
+  // Outside the grid, this moves the distance at the grid edge toward
+  // zero by the distance to the grid, so it never overstates how far
+  // away the landscape is by more than maxError().
+
+  float distance( vec3 position );
+
+  // Largest difference between distance() and the true distance
+
+  float maxError() { return cellSize * 1.41421356f; }
+
+  float getCellSize() { return cellSize; }
+};
+
+
+#endif
@@ -0,0 +1,151 @@
+// fixedLanderBatch.cpp
+
+
+#include "fixedLanderBatch.h"
+
+
+#define BATCH_ALIGN 8		// pad arrays to a multiple of the widest SIMD width
+
+
+// The constants are computed in double from the float physics
+// constants.  Each is one correctly rounded operation (or exact),
+// so they are the same everywhere.
+
+FixedStepConstants fixedStepConstants()
+
+{
+  FixedStepConstants k;
+
+  k.rotStep  = toFixedAngle( ROTATION_SPEED * FIXED_DT );
+  k.gravStep = toFixed( GRAVITY_ACCEL * FIXED_DT );
+  k.thrustX0 = (fix32) floor( THRUST_ACCEL * FIXED_DT * (FIXED_ONE << CORDIC_GUARD_BITS) / CORDIC_GAIN + 0.5 );
+
+  return k;
+}
+
+
+FixedLanderBatch::FixedLanderBatch( int n, float maxX, float maxY )
+
+{
+  numLanders = n;
+  paddedSize = (n + BATCH_ALIGN - 1) / BATCH_ALIGN * BATCH_ALIGN;
+
+  worldMaxX = maxX;
+  worldMaxY = maxY;
+
+  // Padding landers have no controls and no fuel, so they just fall
+
+  posX.assign( paddedSize, 0 );
+  posY.assign( paddedSize, 0 );
+  velX.assign( paddedSize, 0 );
+  velY.assign( paddedSize, 0 );
+  orient.assign( paddedSize, 0 );
+  fuelLevel.assign( paddedSize, 0 );
+  controls.assign( paddedSize, CONTROL_NONE );
+
+  resetAll();
+
+  constants = fixedStepConstants();
+  kernel    = bestSimdKernel();
+}
+
+
+void FixedLanderBatch::reset( int i )
+
+{
+  place( i, vec3( START_X_FRACTION * worldMaxX, START_Y_FRACTION * worldMaxY, 0 ), vec3( START_SPEED, 0, 0 ), 0 );
+  fuelLevel[i] = INITIAL_FUEL;
+}
+
+
+void FixedLanderBatch::resetAll()
+
+{
+  for (int i=0; i<numLanders; i++)
+    reset( i );
+}
+
+
+void FixedLanderBatch::setKernel( SimdKernel k )
+
+{
+  if (k == SIMD_AVX2 && !cpuHasAVX2())
+    k = SIMD_SSE2;
+
+#ifndef HAVE_SSE2
+  if (k == SIMD_SSE2)
+    k = SIMD_SCALAR;
+#endif
+
+  kernel = k;
+}
+
+
+FixedLanderArrays FixedLanderBatch::arrays()
+
+{
+  FixedLanderArrays a;
+
+  a.posX = &posX[0];
+  a.posY = &posY[0];
+  a.velX = &velX[0];
+  a.velY = &velY[0];
+  a.orient = &orient[0];
+  a.fuel = &fuelLevel[0];
+  a.controls = &controls[0];
+  a.n = paddedSize;
+  a.wrapLow  = toFixed( -WRAP_MARGIN );
+  a.wrapHigh = toFixed( worldMaxX + WRAP_MARGIN );
+
+  return a;
+}
+
+
+void stepFixedLanderArraysSSE2( FixedLanderArrays &a, const FixedStepConstants &k )
+
+{
+#ifdef HAVE_SSE2
+  stepFixedLanderArrays<SimdSSE2>( a, k );
+#else
+  stepFixedLanderArrays<FixedScalar>( a, k );
+#endif
+}
+
+
+void FixedLanderBatch::step()
+
+{
+  FixedLanderArrays a = arrays();
+
+  switch (kernel) {
+  case SIMD_AVX2:
+    stepFixedLanderArraysAVX2( a, constants );
+    break;
+  case SIMD_SSE2:
+    stepFixedLanderArraysSSE2( a, constants );
+    break;
+  default:
+    stepFixedLanderArrays<FixedScalar>( a, constants );
+    break;
+  }
+}
+
+
+// FNV-1a over the state of each lander
+
+uint64_t FixedLanderBatch::stateHash()
+
+{
+  uint64_t h = 14695981039346656037ULL;
+
+  for (int i=0; i<numLanders; i++) {
+    int32_t v[6] = { posX[i], posY[i], velX[i], velY[i], orient[i], fuelLevel[i] };
+    for (int j=0; j<6; j++)
+      for (int b=0; b<4; b++) {
+        h ^= (v[j] >> (8*b)) & 0xff;
+        h *= 1099511628211ULL;
+      }
+  }
+
+  return h;
+}
@@ -0,0 +1,91 @@
+// fixedLanderBatch.h
+//
+// Landers stepped in Q16.16 fixed point (see fixedPoint.h), for runs
+// that must give the same bits on every build: replays, lockstep
+// sessions and their checks.  The physics is that of LanderBatch with
+// steps of 2^-FIXED_DT_SHIFT seconds, and the integer SIMD kernels
+// give the same results as the one-lane kernel.
+//
+// The float interface converts on the way in and out.  Converting in
+// is exact up to rounding to 2^-16, and so is the same everywhere.
+
+
+#ifndef FIXEDLANDERBATCH_H
+#define FIXEDLANDERBATCH_H
+
+
+#include "simHeaders.h"
+#include "fixedLanderKernel.h"
+#include "input.h"
+#include <vector>
+
+
+class FixedLanderBatch {
+
+  int numLanders;
+  int paddedSize;		// numLanders rounded up to the SIMD width
+
+  vector<fix32> posX, posY;	// position in world coordinates (m)
+  vector<fix32> velX, velY;	// velocity in world coordinates (m/s)
+  vector<fix32> orient;		// orientation (turns CCW)
+  vector<int>   fuelLevel;
+  vector<Controls> controls;	// controls for the next step
+
+  float worldMaxX, worldMaxY;	// world dimensions
+
+  FixedStepConstants constants;
+  SimdKernel kernel;
+
+  FixedLanderArrays arrays();
+
+ public:
+
+  FixedLanderBatch( int n, float maxX, float maxY );
+
+  int size() { return numLanders; }
+
+  // Put lander 'i' (or all landers) at the start position with full fuel
+
+  void reset( int i );
+  void resetAll();
+
+  void place( int i, vec3 pos, vec3 vel, float orientation ) {
+    posX[i] = toFixed( pos.x );  posY[i] = toFixed( pos.y );
+    velX[i] = toFixed( vel.x );  velY[i] = toFixed( vel.y );
+    orient[i] = toFixedAngle( orientation );
+  }
+
+  void setFuel( int i, int fuel ) { fuelLevel[i] = fuel; }
+
+  // Controls for the next step.  These stay set until changed.
+
+  void setControls( int i, Controls c ) { controls[i] = c; }
+
+  // Step all landers by 2^-FIXED_DT_SHIFT seconds
+
+  void step();
+
+  void setKernel( SimdKernel k );
+  SimdKernel getKernel() { return kernel; }
+
+  vec3  centrePosition( int i ) { return vec3( fromFixed( posX[i] ), fromFixed( posY[i] ), 0 ); }
+  vec3  getVelocity( int i )    { return vec3( fromFixed( velX[i] ), fromFixed( velY[i] ), 0 ); }
+  float getOrientation( int i ) { return fromFixedAngle( orient[i] ); }
+  int   fuel( int i )           { return fuelLevel[i]; }
+
+  // The fixed-point state
+
+  fix32 positionX( int i )   { return posX[i]; }
+  fix32 positionY( int i )   { return posY[i]; }
+  fix32 velocityX( int i )   { return velX[i]; }
+  fix32 velocityY( int i )   { return velY[i]; }
+  fix32 orientation( int i ) { return orient[i]; }
+
+  // A hash of the state of every lander, to check that two runs are
+  // the same
+
+  uint64_t stateHash();
+};
+
+
+#endif
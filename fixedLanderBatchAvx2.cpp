@@ -0,0 +1,19 @@
+// fixedLanderBatchAvx2.cpp
+//
+// The AVX2 instance of the fixed-point lander kernel.  This file is
+// built with -mavx2 -mfma, so it must only be called when
+// cpuHasAVX2().
+
+
+#include "fixedLanderKernel.h"
+
+
+void stepFixedLanderArraysAVX2( FixedLanderArrays &a, const FixedStepConstants &k )
+
+{
+#ifdef HAVE_AVX2
+  stepFixedLanderArrays<SimdAVX2>( a, k );
+#else
+  stepFixedLanderArraysSSE2( a, k );
+#endif
+}
@@ -0,0 +1,119 @@
+// fixedLanderKernel.h
+//
+// The kernel that steps a FixedLanderBatch.  It is compiled one lane
+// at a time and for SSE2 (in fixedLanderBatch.cpp) and for AVX2 (in
+// fixedLanderBatchAvx2.cpp), and since it only uses integer adds,
+// shifts and compares, every instance gives the same bits.
+
+
+#ifndef FIXEDLANDERKERNEL_H
+#define FIXEDLANDERKERNEL_H
+
+
+#include "fixedPoint.h"
+
+
+// The lander arrays, padded so that 'n' is a multiple of the widest
+// SIMD width.  Lengths are Q16.16 meters and orientations Q16.16
+// turns (see fixedPoint.h).
+
+struct FixedLanderArrays {
+  fix32 *posX, *posY;
+  fix32 *velX, *velY;
+  fix32 *orient;
+  int   *fuel;
+  const unsigned char *controls; // Controls bitmask (see input.h)
+  int    n;
+  fix32  wrapLow, wrapHigh;	// x beyond which the landers wrap around
+};
+
+
+// Constants of one step
+
+struct FixedStepConstants {
+  fix32 rotStep;		// turn per step of rotation
+  fix32 gravStep;		// velocity change per step of gravity
+  fix32 thrustX0;		// start of the CORDIC vector for thrust (see fixedRotate())
+};
+
+FixedStepConstants fixedStepConstants();
+
+
+// Step all of the landers by 2^-FIXED_DT_SHIFT seconds.  This does
+// what Lander::rotateCW(), rotateCCW(), addThrust() and updatePose()
+// do, in that order, in fixed point.
+
+template <class S>
+void stepFixedLanderArrays( FixedLanderArrays &a, const FixedStepConstants &k )
+
+{
+  typedef typename S::I I;
+
+  const I zero      = S::set1i( 0 );
+  const I cwBit     = S::set1i( 0x01 ); // CONTROL_ROTATE_CW
+  const I ccwBit    = S::set1i( 0x02 ); // CONTROL_ROTATE_CCW
+  const I thrustBit = S::set1i( 0x04 ); // CONTROL_THRUST
+
+  const I rotStep   = S::set1i( k.rotStep );
+  const I gravStep  = S::set1i( k.gravStep );
+  const I thrustX0  = S::set1i( k.thrustX0 );
+  const I halfStep  = S::set1i( 1 << (FIXED_DT_SHIFT - 1) ); // to round v dt
+  const I wrapHigh  = S::set1i( a.wrapHigh );
+  const I wrapLow   = S::set1i( a.wrapLow );
+
+  for (int i=0; i<a.n; i+=S::WIDTH) {
+
+    I ctl  = S::loadBytes( a.controls + i );
+    I fuel = S::loadi( a.fuel + i );
+    I o    = S::loadi( a.orient + i );
+    I vx   = S::loadi( a.velX + i );
+    I vy   = S::loadi( a.velY + i );
+
+    // Each control is applied only if there is fuel left, and uses
+    // one unit of fuel (the masks are -1 where applied)
+
+    I cw = S::andi( S::eqi( S::andi( ctl, cwBit ), cwBit ), S::gti( fuel, zero ) );
+    fuel = S::addi( fuel, cw );
+    o = S::subi( o, S::andi( cw, rotStep ) );
+
+    I ccw = S::andi( S::eqi( S::andi( ctl, ccwBit ), ccwBit ), S::gti( fuel, zero ) );
+    fuel = S::addi( fuel, ccw );
+    o = S::addi( o, S::andi( ccw, rotStep ) );
+
+    I thrust = S::andi( S::eqi( S::andi( ctl, thrustBit ), thrustBit ), S::gti( fuel, zero ) );
+
+    if (S::anyi( thrust )) {
+      I cosO, sinO;
+      fixedRotate<S>( o, thrustX0, cosO, sinO );
+      vx = S::subi( vx, S::andi( thrust, sinO ) );
+      vy = S::addi( vy, S::andi( thrust, cosO ) );
+      fuel = S::addi( fuel, thrust );
+    }
+
+    // Update the pose with the old velocity, then the velocity
+
+    I px = S::addi( S::loadi( a.posX + i ), S::srai( S::addi( vx, halfStep ), FIXED_DT_SHIFT ) );
+    I py = S::addi( S::loadi( a.posY + i ), S::srai( S::addi( vy, halfStep ), FIXED_DT_SHIFT ) );
+    vy = S::subi( vy, gravStep );
+
+    // Wrap around the screen
+
+    px = S::selecti( S::gti( px, wrapHigh ), wrapLow, S::selecti( S::gti( wrapLow, px ), wrapHigh, px ) );
+
+    S::storei( a.posX + i, px );
+    S::storei( a.posY + i, py );
+    S::storei( a.velX + i, vx );
+    S::storei( a.velY + i, vy );
+    S::storei( a.orient + i, o );
+    S::storei( a.fuel + i, fuel );
+  }
+}
+
+
+// Entry points for each instruction set
+
+void stepFixedLanderArraysSSE2( FixedLanderArrays &a, const FixedStepConstants &k );
+void stepFixedLanderArraysAVX2( FixedLanderArrays &a, const FixedStepConstants &k );
+
+
+#endif
@@ -0,0 +1,153 @@
+// fixedPoint.h
+//
+// Q16.16 fixed-point numbers for the deterministic physics mode (see
+// fixedLanderBatch.h and fixedTerrain.h).  All arithmetic on them is
+// integer adds, shifts and compares, so the results are the same bits
+// with any compiler, optimization level or SIMD width.  (Right shifts
+// of negative numbers are assumed to be arithmetic, as they are on
+// every compiler this builds with.)
+//
+// Lengths are in meters, velocities in m/s and orientations in turns
+// (one turn is 2 pi radians), so that the fraction bits of an
+// orientation are its angle within a turn.  Steps are 2^-FIXED_DT_SHIFT
+// seconds, so that multiplying by the step is a shift.
+//
+// This is included in files compiled for other instruction sets, so
+// it only includes headers that are safe there.
+
+
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+
+#include "simd.h"
+#include "landerPhysics.h"
+#include <cmath>
+#include <stdint.h>
+
+
+typedef int32_t fix32;		// Q16.16 (std::fixed takes the obvious name)
+
+#define FIXED_FRACTION_BITS 16
+#define FIXED_ONE (1 << FIXED_FRACTION_BITS)
+
+#define FIXED_TURN 6.283185307179586477	// radians per turn (M_PI is not in every <cmath>)
+
+#define FIXED_DT_SHIFT 6		// each step is 2^-6 = 1/64 s
+#define FIXED_DT (1.0 / (1 << FIXED_DT_SHIFT))
+
+#define CORDIC_STEPS 16			// CORDIC iterations (angle to about 3e-5 radians)
+#define CORDIC_GAIN 1.6467602578654548	// growth of the vector over CORDIC_STEPS iterations
+#define CORDIC_GUARD_BITS 14		// extra fraction bits in the CORDIC vector
+
+
+// Conversions.  Scaling by a power of two is exact, so these give
+// the same results everywhere.
+
+inline fix32 toFixed( double x )          { return (fix32) floor( x * FIXED_ONE + 0.5 ); }
+inline float fromFixed( fix32 x )         { return x * (1.0f / FIXED_ONE); }
+
+inline fix32 toFixedAngle( double radians ) { return toFixed( radians / FIXED_TURN ); }
+inline float fromFixedAngle( fix32 turns )  { return (float) (turns * (FIXED_TURN / FIXED_ONE)); }
+
+
+// Plain integers with the same names as the SIMD wrappers in simd.h,
+// so that a kernel written for those also runs one lane at a time
+
+struct FixedScalar {
+
+  typedef int32_t I;
+
+  enum { WIDTH = 1 };
+
+  static inline I loadi( const int *p )       { return *p; }
+  static inline void storei( int *p, I a )    { *p = a; }
+  static inline I loadBytes( const unsigned char *p ) { return *p; }
+
+  static inline I set1i( int a )   { return a; }
+
+  static inline I addi( I a, I b ) { return a + b; }
+  static inline I subi( I a, I b ) { return a - b; }
+  static inline I andi( I a, I b ) { return a & b; }
+  static inline I ori( I a, I b )  { return a | b; }
+  static inline I xori( I a, I b ) { return a ^ b; }
+  static inline I gti( I a, I b )  { return -(a > b); }
+  static inline I eqi( I a, I b )  { return -(a == b); }
+  static inline I slli( I a, int n ) { return (I) ((uint32_t) a << n); }
+  static inline I srai( I a, int n ) { return a >> n; }
+  static inline I selecti( I mask, I a, I b ) { return (mask & a) | (~mask & b); }
+
+  static inline bool anyi( I mask ) { return mask != 0; }
+};
+
+
+// atan(2^-i) in units of 2^-30 turn
+
+static const int cordicAngles[CORDIC_STEPS] = {
+  134217728, 79233351, 41864727, 21251189, 10666833, 5338616, 2669960, 1335061,
+  667541, 333772, 166886, 83443, 41722, 20861, 10430, 5215
+};
+
+
+// (x,y) = r (cos a, sin a) for each lane, where a is an orientation
+// in turns and 'x0' is r / CORDIC_GAIN with CORDIC_GUARD_BITS extra
+// fraction bits.
+//
+// The angle is reduced to the nearest quarter turn, the remainder is
+// rotated through by CORDIC (shifts and adds only) and the result is
+// turned by the quarter turns.
+
+template <class S>
+inline void fixedRotate( typename S::I a, typename S::I x0, typename S::I &x, typename S::I &y )
+
+{
+  typedef typename S::I I;
+
+  const I quarterBits = S::set1i( 3 );
+
+  a = S::andi( a, S::set1i( FIXED_ONE - 1 ) );			 // fraction of a turn
+  I q = S::srai( S::addi( a, S::set1i( FIXED_ONE / 8 ) ), FIXED_FRACTION_BITS - 2 ); // nearest quarter turn
+  I z = S::slli( S::subi( a, S::slli( q, FIXED_FRACTION_BITS - 2 ) ), 30 - FIXED_FRACTION_BITS ); // 2^-30 turns
+  q = S::andi( q, quarterBits );
+
+  x = x0;
+  y = S::set1i( 0 );
+
+  // Turn toward z = 0 by +/- atan(2^-i) at each step (the masks are
+  // -1 where z < 0, and (v ^ m) - m negates v there)
+
+  for (int i=0; i<CORDIC_STEPS; i++) {
+    I m  = S::srai( z, 31 );
+    I dx = S::srai( y, i );
+    I dy = S::srai( x, i );
+    x = S::subi( x, S::subi( S::xori( dx, m ), m ) );
+    y = S::addi( y, S::subi( S::xori( dy, m ), m ) );
+    z = S::subi( z, S::subi( S::xori( S::set1i( cordicAngles[i] ), m ), m ) );
+  }
+
+  // Round off the guard bits
+
+  const I half = S::set1i( 1 << (CORDIC_GUARD_BITS - 1) );
+
+  x = S::srai( S::addi( x, half ), CORDIC_GUARD_BITS );
+  y = S::srai( S::addi( y, half ), CORDIC_GUARD_BITS );
+
+  // Quarter turns: (x,y) becomes (-y,x), (-x,-y) or (y,-x)
+
+  I q1 = S::eqi( q, S::set1i( 1 ) );
+  I q2 = S::eqi( q, S::set1i( 2 ) );
+  I q3 = S::eqi( q, quarterBits );
+
+  I swap = S::ori( q1, q3 );
+  I negX = S::ori( q1, q2 );
+  I negY = S::ori( q2, q3 );
+
+  I c = S::selecti( swap, y, x );
+  I s = S::selecti( swap, x, y );
+
+  x = S::subi( S::xori( c, negX ), negX );
+  y = S::subi( S::xori( s, negY ), negY );
+}
+
+
+#endif
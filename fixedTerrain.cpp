@@ -0,0 +1,105 @@
+// fixedTerrain.cpp
+
+
+#include "fixedTerrain.h"
+#include <algorithm>
+
+
+// Transform the model vertices as Landscape::setupGeometry() does:
+// the x values fill [ 0, LANDSCAPE_WIDTH ], y increases upward from
+// 0, and no segment goes backward in x.
+
+FixedTerrain::FixedTerrain( Landscape *landscape )
+
+{
+  const float *model = landscape->modelVertices();
+
+  numVerts = landscape->numSegments() + 1;
+
+  double minX = model[0], maxX = model[0], maxY = model[1];
+
+  for (int i=0; i<numVerts; i++) {
+    minX = min( minX, (double) model[2*i] );
+    maxX = max( maxX, (double) model[2*i] );
+    maxY = max( maxY, (double) model[2*i+1] );
+  }
+
+  double s = LANDSCAPE_WIDTH / (maxX - minX);
+
+  vertX.resize( numVerts );
+  vertY.resize( numVerts );
+
+  fix32 prevX = 0;
+
+  for (int i=0; i<numVerts; i++) {
+
+    vertX[i] = toFixed( s * (model[2*i] - minX) );
+    vertY[i] = toFixed( s * (maxY - model[2*i+1]) );
+
+    if (vertX[i] < prevX)
+      vertX[i] = prevX;
+
+    prevX = vertX[i];
+  }
+}
+
+
+// The last segment whose left end is at or left of 'x', skipping
+// vertical segments at the right end
+
+int FixedTerrain::segmentBelow( fix32 x )
+
+{
+  int i = (int) (upper_bound( vertX.begin(), vertX.end(), x ) - vertX.begin()) - 1;
+
+  if (i < 0)
+    i = 0;
+  else if (i > numVerts - 2) {
+    i = numVerts - 2;
+    while (i > 0 && vertX[i+1] == vertX[i])
+      i--;
+  }
+
+  return i;
+}
+
+
+// Altitude of the lander's base above segment 'i' at 'x'.  The
+// product is in 64 bits, and the division rounds toward zero.
+
+fix32 FixedTerrain::altitude( int i, fix32 x, fix32 y, fix32 landerHeight )
+
+{
+  fix32 x0 = vertX[i], x1 = vertX[i+1];
+  fix32 y0 = vertY[i], y1 = vertY[i+1];
+
+  fix32 terrainY = (x1 == x0 ? max( y0, y1 ) : y0 + (fix32) ((int64_t) (y1 - y0) * (x - x0) / (x1 - x0)));
+
+  return y - landerHeight / 2 - terrainY;
+}
+
+
+// 0 if the lander can land on segment 'i', or the reason it cannot:
+// 1 if the segment is not flat, 2 if the centre is not over it, 3 if
+// the lander does not fit on it, or 0 (!) if the lander is tilted
+// more than 5 degrees, as in Landscape::isSegmentGoodToLand()
+
+int FixedTerrain::goodToLand( int i, fix32 orientation, fix32 x, fix32 landerWidth )
+
+{
+  static const fix32 maxTilt = toFixedAngle( 5 * 3.14 / 180 );
+
+  if (abs( orientation ) >= maxTilt)
+    return 0;
+
+  if (vertY[i] != vertY[i+1])
+    return 1;
+
+  if (x <= vertX[i] || x >= vertX[i+1])
+    return 2;
+
+  if (x + landerWidth / 2 >= vertX[i+1] || x - landerWidth / 2 <= vertX[i])
+    return 3;
+
+  return 0;
+}
@@ -0,0 +1,45 @@
+// fixedTerrain.h
+//
+// The landscape in Q16.16 fixed point (see fixedPoint.h), with the
+// queries that the landing rules need.  The vertices are computed
+// from the model coordinates in double, one correctly rounded
+// operation at a time, so they are the same bits on every build (the
+// float vertices of the Landscape may differ in their last bit, since
+// compilers are free to fuse their multiply-adds).
+
+
+#ifndef FIXEDTERRAIN_H
+#define FIXEDTERRAIN_H
+
+
+#include "landscape.h"
+#include "fixedPoint.h"
+#include <vector>
+
+
+class FixedTerrain {
+
+  vector<fix32> vertX, vertY;	// vertices in world coordinates (Q16.16 m)
+  int numVerts;
+
+ public:
+
+  FixedTerrain( Landscape *landscape );
+
+  int numSegments() { return numVerts - 1; }
+
+  fix32 x( int i ) { return vertX[i]; }
+  fix32 y( int i ) { return vertY[i]; }
+
+  // These are as Landscape::findSegmentBelow(), findLanderAltitude()
+  // and isSegmentGoodToLand(), with the orientation in turns
+
+  int   segmentBelow( fix32 x );
+  fix32 altitude( int i, fix32 x, fix32 y, fix32 landerHeight );
+  int   goodToLand( int i, fix32 orientation, fix32 x, fix32 landerWidth );
+
+  fix32 segmentWidth( int i ) { return vertX[i+1] - vertX[i]; }
+};
+
+
+#endif
@@ -0,0 +1,311 @@
+// heatmap.cpp
+
+
+#include "heatmap.h"
+#include <fstream>
+
+
+// The radical inverse of 'i' in base 'b': the k-th digit of 'i'
+// becomes the k-th digit after the point
+
+static float radicalInverse( long i, int b )
+
+{
+  double f = 1, r = 0;
+
+  while (i > 0) {
+    f /= b;
+    r += f * (i % b);
+    i /= b;
+  }
+
+  return r;
+}
+
+
+// A number in [0,1) from 'cell' and 'dim', to shift each cell's
+// sequence (so that neighbouring cells are not sampled in the same
+// pattern)
+
+static float cellShift( int cell, int dim )
+
+{
+  uint32_t h = cell * 0x9e3779b9u + dim * 0x85ebca6bu;
+
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  h *= 0x846ca68bu;
+  h ^= h >> 16;
+
+  return (h >> 8) * (1.0f / (1 << 24));
+}
+
+
+LandingHeatmap::LandingHeatmap( Landscape *l, int cellsX, int cellsY, int samplesPerCell )
+
+  : cells( max( 1, cellsX ) * max( 1, cellsY ) )
+
+{
+  landscape = l;
+  nx = max( 1, cellsX );
+  ny = max( 1, cellsY );
+  samples = max( 1, samplesPerCell );
+
+  Session probe( landscape );	// for the world bounds
+  worldMaxX = probe.maxX();
+  worldMaxY = probe.maxY();
+
+  for (unsigned int c=0; c<cells.size(); c++) {
+    cells[c].episodes = 0;
+    cells[c].landings = 0;
+    cells[c].fuelUsed = 0;
+    cells[c].blocked  = 0;
+  }
+
+  next     = 0;
+  finished = 0;
+  stopping = false;
+
+  maxVX = 30;
+  maxVY = 5;
+  maxTime = 300;
+  deltaT = 1/60.0;
+  controller = NULL;
+  controllerData = NULL;
+  script = NULL;
+}
+
+
+void LandingHeatmap::start( int numThreads )
+
+{
+  stop();
+
+  stopping = false;
+
+  for (int t=0; t<max( 1, numThreads ); t++)
+    threads.push_back( thread( &LandingHeatmap::work, this ) );
+}
+
+
+void LandingHeatmap::stop()
+
+{
+  stopping = true;
+
+  for (unsigned int t=0; t<threads.size(); t++)
+    threads[t].join();
+
+  threads.clear();
+}
+
+
+// One thread: take samples in order until all are played
+
+void LandingHeatmap::work()
+
+{
+  Session         session( landscape );
+  ControllerInput controllerInput( controller, controllerData );
+  ScriptedInput   scriptInput;
+
+  if (script)
+    scriptInput = *script;
+
+  InputSource &input = (script ? (InputSource &) scriptInput : controllerInput);
+
+  while (!stopping) {
+
+    long item = next++;
+    if (item >= total())
+      break;
+
+    scriptInput.restart();
+    play( session, input, item );
+    finished++;
+  }
+}
+
+
+// Play sample 'item' (pass * cells + cell)
+
+void LandingHeatmap::play( Session &session, InputSource &input, long item )
+
+{
+  int  c = item % cells.size();
+  long k = item / cells.size() + 1; // (the Halton sequence starts at 1)
+  int  i = c % nx, j = c / nx;
+
+  float u[4];
+  int   bases[4] = { 2, 3, 5, 7 };
+
+  for (int d=0; d<4; d++) {
+    u[d] = radicalInverse( k, bases[d] ) + cellShift( c, d );
+    if (u[d] >= 1)
+      u[d] -= 1;
+  }
+
+  vec3 pos( (i + u[0]) * cellWidth(), (j + u[1]) * cellHeight(), 0 );
+  vec3 vel( maxVX * (2 * u[2] - 1), -maxVY * u[3], 0 );
+
+  Cell &cell = cells[c];
+
+  if (landscape->findLanderAltitude( landscape->findSegmentBelow( pos ), pos, session.getLander()->getDimensions().y ) < HEATMAP_MIN_ALTITUDE) {
+    cell.blocked++;
+    return;
+  }
+
+  session.HardReset();
+  session.getLander()->place( pos, vel, 0 );
+
+  while (session.running() && session.getTime() < maxTime)
+    session.update( input, deltaT );
+
+  if (!session.running() && session.won()) {
+    cell.fuelUsed += session.getStartFuel() - session.getLander()->fuel();
+    cell.landings++;
+  }
+
+  cell.episodes++;
+}
+
+
+float LandingHeatmap::success( int i, int j )
+
+{
+  Cell &cell = cells[j*nx+i];
+  int n = cell.episodes;
+
+  return (n > 0 ? cell.landings / (float) n : -1);
+}
+
+
+float LandingHeatmap::fuelCost( int i, int j )
+
+{
+  Cell &cell = cells[j*nx+i];
+  int n = cell.landings;
+
+  return (n > 0 ? cell.fuelUsed / (float) n : -1);
+}
+
+
+float LandingHeatmap::maxFuelCost()
+
+{
+  float m = 0;
+
+  for (int j=0; j<ny; j++)
+    for (int i=0; i<nx; i++)
+      m = max( m, fuelCost( i, j ) );
+
+  return m;
+}
+
+
+// ---------------- output ----------------
+
+
+void LandingHeatmap::successColour( float s, float rgb[3] )
+
+{
+  rgb[0] = 1 - s;
+  rgb[1] = s;
+  rgb[2] = 0;
+}
+
+
+void LandingHeatmap::fuelColour( float f, float rgb[3] )
+
+{
+  rgb[0] = f;
+  rgb[1] = 1 - f;
+  rgb[2] = 0;
+}
+
+
+bool LandingHeatmap::writeCsv( const char *path )
+
+{
+  ofstream out( path );
+
+  out << "x,y,episodes,landings,success,fuel" << endl;
+
+  for (int j=0; j<ny; j++)
+    for (int i=0; i<nx; i++) {
+      Cell &cell = cells[j*nx+i];
+      out << (i + 0.5) * cellWidth() << "," << (j + 0.5) * cellHeight() << ","
+          << cell.episodes << "," << cell.landings << ",";
+      if (cell.episodes > 0)
+        out << success( i, j );
+      out << ",";
+      if (cell.landings > 0)
+        out << fuelCost( i, j );
+      out << endl;
+    }
+
+  if (!out) {
+    cerr << "Could not write " << path << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+// Write a PPM of one colour per cell from 'value' (in [0,1], or
+// negative for none)
+
+static bool writePpm( const char *path, int nx, int ny, const vector<float> &value, void (*colour)( float, float[3] ) )
+
+{
+  ofstream out( path, ios::binary );
+
+  out << "P6 " << nx << " " << ny << " 255\n";
+
+  for (int j=ny-1; j>=0; j--)
+    for (int i=0; i<nx; i++) {
+      float rgb[3] = { 0.3, 0.3, 0.3 };
+      if (value[j*nx+i] >= 0)
+        colour( value[j*nx+i], rgb );
+      for (int k=0; k<3; k++)
+        out.put( (unsigned char) (255 * rgb[k] + 0.5) );
+    }
+
+  if (!out) {
+    cerr << "Could not write " << path << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool LandingHeatmap::writeSuccessPpm( const char *path )
+
+{
+  vector<float> v( nx * ny );
+
+  for (int j=0; j<ny; j++)
+    for (int i=0; i<nx; i++)
+      v[j*nx+i] = success( i, j );
+
+  return writePpm( path, nx, ny, v, successColour );
+}
+
+
+bool LandingHeatmap::writeFuelPpm( const char *path )
+
+{
+  vector<float> v( nx * ny );
+  float m = maxFuelCost();
+
+  for (int j=0; j<ny; j++)
+    for (int i=0; i<nx; i++) {
+      float f = fuelCost( i, j );
+      v[j*nx+i] = (f >= 0 && m > 0 ? f / m : f);
+    }
+
+  return writePpm( path, nx, ny, v, fuelColour );
+}
@@ -0,0 +1,12 @@
+// fragment shader for the heatmap overlay
+
+#version 300 es
+
+in mediump vec4 cellColour;
+out mediump vec4 fragColour;
+
+void main()
+
+{
+  fragColour = cellColour;
+}
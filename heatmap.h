@@ -0,0 +1,118 @@
+// heatmap.h
+//
+// The chance of landing, and the fuel it takes, from starting states
+// over a grid of start positions.  Each cell of the grid is sampled
+// with starts spread over the cell and over a range of start
+// velocities by a Halton sequence (shifted differently in each cell),
+// and each start is played headless to the end with a controller or a
+// script.
+//
+// The episodes run on background threads in passes, each pass adding
+// one sample to every cell, so the whole map sharpens together and
+// can be read (or drawn; see heatmapDraw.cpp) at any time.  The
+// results do not depend on the number of threads.
+
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "input.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+#define HEATMAP_MIN_ALTITUDE 1	// starts closer to the terrain than this are not played (m)
+
+
+class LandingHeatmap {
+
+  struct Cell {
+    atomic<int>  episodes;	// episodes played
+    atomic<int>  landings;
+    atomic<long> fuelUsed;	// total fuel used by the landings
+    atomic<int>  blocked;	// starts too close to (or under) the terrain
+  };
+
+  Landscape     *landscape;
+  int            nx, ny;	// cells across and up
+  int            samples;	// samples per cell
+  float          worldMaxX, worldMaxY;
+  vector<Cell>   cells;		// row by row from the bottom left
+  atomic<long>   next;		// next sample to play (pass * cells + cell)
+  atomic<long>   finished;	// samples played
+  atomic<bool>   stopping;
+  vector<thread> threads;
+
+  unsigned int   VAO, VBO;	// for the overlay (see heatmapDraw.cpp)
+  vector<float>  drawVerts;
+
+  void work();
+  void play( Session &session, InputSource &input, long item );
+
+ public:
+
+  // What is sampled and how it is played.  Set these before start().
+
+  float maxVX, maxVY;		// start velocity in [-maxVX,maxVX] x [-maxVY,0] (m/s)
+  float maxTime;		// longest episode (s)
+  float deltaT;			// step (s)
+  ControllerFunc controller;	// with 'controllerData', unless 'script' is set
+  void          *controllerData;
+  const ScriptedInput *script;	// optional; each episode plays a copy
+
+  LandingHeatmap( Landscape *l, int cellsX, int cellsY, int samplesPerCell );
+  ~LandingHeatmap() { stop(); }
+
+  // Play the episodes on 'numThreads' threads, in the background.
+  // stop() waits for the episodes being played and abandons the rest.
+
+  void start( int numThreads );
+  void stop();
+  bool done() { return finished == (long) samples * nx * ny; }
+
+  int   cellsX()  { return nx; }
+  int   cellsY()  { return ny; }
+  float cellWidth()  { return worldMaxX / nx; }
+  float cellHeight() { return worldMaxY / ny; }
+  long  played()  { return finished; }
+  long  total()   { return (long) samples * nx * ny; }
+
+  // Results for cell (i,j) so far: the fraction of episodes that
+  // landed and the mean fuel used by the landings (both -1 if there
+  // are none yet), and the number of episodes
+
+  float success( int i, int j );
+  float fuelCost( int i, int j );
+  int   episodes( int i, int j ) { return cells[j*nx+i].episodes; }
+  int   landings( int i, int j ) { return cells[j*nx+i].landings; }
+  bool  blocked( int i, int j )  { return cells[j*nx+i].blocked > 0 && cells[j*nx+i].episodes == 0; }
+
+  // Write the results so far as CSV (one line per cell) and as PPM
+  // images (one pixel per cell, top row first; success from red to
+  // green, fuel from green (none) to red (the most of any cell), and
+  // grey where nothing was played)
+
+  bool writeCsv( const char *path );
+  bool writeSuccessPpm( const char *path );
+  bool writeFuelPpm( const char *path );
+
+  // Colour of a success fraction or of a fuel cost (as a fraction of
+  // the largest), as r,g,b in [0,1]
+
+  static void successColour( float s, float rgb[3] );
+  static void fuelColour( float f, float rgb[3] );
+
+  float maxFuelCost();
+
+  // Draw the results so far over the world (see heatmapDraw.cpp)
+
+  void setupVAO();
+  void draw( mat4 &worldToViewTransform, bool showFuel );
+};
+
+
+#endif
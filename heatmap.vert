@@ -0,0 +1,16 @@
+// vertex shader for the heatmap overlay
+
+#version 300 es
+
+layout (location = 0) in vec4 position;
+layout (location = 1) in vec4 colour;
+uniform mat4 MVP;
+
+out mediump vec4 cellColour;
+
+void main()
+
+{
+  gl_Position = MVP * position;
+  cellColour = colour;
+}
@@ -0,0 +1,99 @@
+// heatmapDraw.cpp
+//
+// The OpenGL parts of the landing heatmap: an overlay of one
+// translucent square per cell, over the start positions it covers
+
+
+#include "headers.h"
+#include "heatmap.h"
+#include "gpuProgram.h"
+#include "ll.h"
+
+
+#define HEATMAP_ALPHA 0.35	// opacity of the overlay
+
+
+static GPUProgram *heatmapProgram = NULL; // shared by all heatmaps
+
+
+// Set up the VAO for the overlay.  This must be called once there is
+// an OpenGL context.
+
+void LandingHeatmap::setupVAO()
+
+{
+  if (!heatmapProgram)
+    heatmapProgram = new GPUProgram( "heatmap.vert", "heatmap.frag" );
+
+  glGenVertexArrays( 1, &VAO );
+  glBindVertexArray( VAO );
+
+  glGenBuffers( 1, &VBO );
+  glBindBuffer( GL_ARRAY_BUFFER, VBO );
+
+  // x,y then r,g,b,a for each vertex
+
+  glEnableVertexAttribArray( 0 );
+  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 6*sizeof(float), 0 );
+  glEnableVertexAttribArray( 1 );
+  glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void *) (2*sizeof(float)) );
+
+  drawVerts.reserve( nx * ny * 6 * 6 );
+}
+
+
+// Draw the results so far: the chance of landing or (if 'showFuel')
+// the fuel used.  Cells with no results yet are not drawn.
+
+void LandingHeatmap::draw( mat4 &worldToViewTransform, bool showFuel )
+
+{
+  float maxFuel = maxFuelCost();
+
+  drawVerts.clear();
+
+  for (int j=0; j<ny; j++)
+    for (int i=0; i<nx; i++) {
+
+      float v = (showFuel ? fuelCost( i, j ) : success( i, j ));
+      if (v < 0)
+        continue;
+
+      float rgb[3];
+      if (showFuel)
+        fuelColour( maxFuel > 0 ? v / maxFuel : 0, rgb );
+      else
+        successColour( v, rgb );
+
+      float x0 = i * cellWidth(), x1 = x0 + cellWidth();
+      float y0 = j * cellHeight(), y1 = y0 + cellHeight();
+      float corners[6][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y0 }, { x1, y1 }, { x0, y1 } };
+
+      for (int k=0; k<6; k++) {
+        drawVerts.push_back( corners[k][0] );
+        drawVerts.push_back( corners[k][1] );
+        drawVerts.push_back( rgb[0] );
+        drawVerts.push_back( rgb[1] );
+        drawVerts.push_back( rgb[2] );
+        drawVerts.push_back( HEATMAP_ALPHA );
+      }
+    }
+
+  if (drawVerts.empty())
+    return;
+
+  heatmapProgram->activate();
+
+  glBindVertexArray( VAO );
+  glBindBuffer( GL_ARRAY_BUFFER, VBO );
+  glBufferData( GL_ARRAY_BUFFER, drawVerts.size() * sizeof(float), &drawVerts[0], GL_STREAM_DRAW );
+
+  glUniformMatrix4fv( glGetUniformLocation( heatmapProgram->id(), "MVP"), 1, GL_TRUE, &worldToViewTransform[0][0] );
+
+  glEnable( GL_BLEND );
+  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  glDrawArrays( GL_TRIANGLES, 0, drawVerts.size() / 6 );
+  glDisable( GL_BLEND );
+
+  myGPUProgram->activate();
+}
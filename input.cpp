@@ -0,0 +1,119 @@
+// input.cpp
+
+
+#include "input.h"
+
+
+// Add an event to the script.  Events are expected in time order.
+
+void ScriptedInput::add( float time, Controls controls )
+
+{
+  Event e;
+
+  e.time     = time;
+  e.controls = controls;
+
+  events.push_back( e );
+}
+
+
+Controls ScriptedInput::controls( Session &session, float deltaT )
+
+{
+  // Apply all events that have started by now
+
+  while (next < (int) events.size() && events[next].time <= time) {
+    current = events[next].controls;
+    next++;
+  }
+
+  time += deltaT;
+
+  return current;
+}
+
+
+// Steps until the first event with controls, less one for rounding
+// (since 'time' is a sum of step lengths)
+
+int ScriptedInput::idleSteps( Session &session, float deltaT )
+
+{
+  // The controls now
+
+  Controls c = current;
+  int i = next;
+
+  while (i < (int) events.size() && events[i].time <= time) {
+    c = events[i].controls;
+    i++;
+  }
+
+  if (c != CONTROL_NONE)
+    return 0;
+
+  while (i < (int) events.size() && events[i].controls == CONTROL_NONE)
+    i++;
+
+  if (i == (int) events.size())
+    return IDLE_FOREVER;
+
+  return max( 0, (int) ((events[i].time - time) / deltaT) - 1 );
+}
+
+
+// Steps until the first event that changes the controls, less one for
+// rounding as above
+
+int ScriptedInput::heldSteps( Session &session, float deltaT )
+
+{
+  int i = next;
+
+  while (i < (int) events.size() && events[i].controls == current)
+    i++;
+
+  if (i == (int) events.size())
+    return IDLE_FOREVER;
+
+  return max( 0, (int) ((events[i].time - time) / deltaT) - 1 );
+}
+
+
+Controls ReplayInput::controls( Session &session, float deltaT )
+
+{
+  if (next >= steps.size())
+    return CONTROL_NONE;
+
+  return steps[next++];
+}
+
+
+int ReplayInput::idleSteps( Session &session, float deltaT )
+
+{
+  unsigned int i = next;
+
+  while (i < steps.size() && steps[i] == CONTROL_NONE)
+    i++;
+
+  return (i == steps.size() ? IDLE_FOREVER : i - next);
+}
+
+
+int ReplayInput::heldSteps( Session &session, float deltaT )
+
+{
+  if (next == 0)
+    return 0;
+
+  Controls c = (next <= steps.size() ? steps[next-1] : CONTROL_NONE);
+  unsigned int i = next;
+
+  while (i < steps.size() && steps[i] == c)
+    i++;
+
+  return (i == steps.size() && c == CONTROL_NONE ? IDLE_FOREVER : i - next);
+}
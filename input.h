@@ -0,0 +1,149 @@
+// input.h
+//
+// Sources of lander controls.  A Session is stepped with a set of
+// Controls; an InputSource decides what those controls are.  The
+// keyboard source (keyboardInput.h) is the only one that needs a
+// window, so the others can drive headless runs.
+
+
+#ifndef INPUT_H
+#define INPUT_H
+
+
+#include "simHeaders.h"
+#include <vector>
+
+
+// Controls for one step, as a bitmask
+
+typedef unsigned char Controls;
+
+#define CONTROL_NONE       0x00
+#define CONTROL_ROTATE_CW  0x01	// right arrow
+#define CONTROL_ROTATE_CCW 0x02	// left arrow
+#define CONTROL_THRUST     0x04	// down arrow
+#define CONTROL_NEW_GAME   0x08	// 'n' after a game ends
+#define CONTROL_CONTINUE   0x10	// 's' after a game ends
+#define CONTROL_RESET      0x20	// 'r' = reset lander
+
+
+class Session;
+
+
+class InputSource {
+
+ public:
+
+  virtual ~InputSource() {}
+
+  // Return the controls to apply to 'session' for the next step of
+  // 'deltaT' seconds.
+
+  virtual Controls controls( Session &session, float deltaT ) = 0;
+
+  // The number of upcoming steps of 'deltaT' for which this source
+  // will certainly return no controls, so that they can be skipped
+  // with Session::coast().  Sources that cannot tell return 0.
+
+  virtual int idleSteps( Session &session, float deltaT ) { return 0; }
+
+  // The number of upcoming steps of 'deltaT', after the one that the
+  // last call to controls() was for, on which this source will
+  // certainly return the same controls, so that they can be held with
+  // Session::stepAdaptive().  Sources that cannot tell return 0.
+
+  virtual int heldSteps( Session &session, float deltaT ) { return 0; }
+
+  // Advance the source's clock over 'numSteps' steps of 'deltaT' that
+  // it was not asked about: steps skipped with no controls (no more
+  // than idleSteps()), or steps that held the last controls (no more
+  // than heldSteps()).
+
+  virtual void skip( int numSteps, float deltaT ) {}
+};
+
+
+#define IDLE_FOREVER 0x3fffffff	// idleSteps() when no controls will ever come
+
+
+// Controls that change at given times (in seconds since the script
+// was started).  Events must be added in time order.
+
+class ScriptedInput : public InputSource {
+
+  struct Event {
+    float    time;
+    Controls controls;
+  };
+
+  vector<Event> events;
+  float         time;		// time since start of script
+  int           next;		// next event to apply
+  Controls      current;
+
+ public:
+
+  ScriptedInput() { restart(); }
+
+  void add( float time, Controls controls );
+
+  void restart() { time = 0; next = 0; current = CONTROL_NONE; }
+
+  Controls controls( Session &session, float deltaT );
+
+  int  idleSteps( Session &session, float deltaT );
+  int  heldSteps( Session &session, float deltaT );
+  void skip( int numSteps, float deltaT ) { time += numSteps * deltaT; }
+};
+
+
+// Controls recorded one per step, played back in order.  After the
+// last step, no controls are applied.
+
+class ReplayInput : public InputSource {
+
+  vector<Controls> steps;
+  unsigned int     next;
+
+ public:
+
+  ReplayInput() { next = 0; }
+
+  void add( Controls controls ) { steps.push_back( controls ); }
+
+  void restart() { next = 0; }
+
+  bool done() { return next >= steps.size(); }
+
+  Controls controls( Session &session, float deltaT );
+
+  int  idleSteps( Session &session, float deltaT );
+  int  heldSteps( Session &session, float deltaT );
+  void skip( int numSteps, float deltaT ) { next += numSteps; }
+};
+
+
+// Controls computed from the session state by a controller function.
+// 'data' is passed through to the function unchanged.
+
+typedef Controls (*ControllerFunc)( Session &session, float deltaT, void *data );
+
+class ControllerInput : public InputSource {
+
+  ControllerFunc func;
+  void          *data;
+
+ public:
+
+  ControllerInput( ControllerFunc f, void *d = NULL ) {
+    func = f;
+    data = d;
+  }
+
+  Controls controls( Session &session, float deltaT ) {
+    return func( session, deltaT, data );
+  }
+};
+
+
+#endif
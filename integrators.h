@@ -0,0 +1,199 @@
+// integrators.h
+//
+// Integrators for the lander's motion over one step, as policies for
+// Lander::step() and LanderBatch::step().  Each policy has a static
+// advance() that is a template on the arithmetic: ScalarOps for one
+// lander, or a SIMD wrapper (see simd.h) for several at once.  So the
+// integrator is chosen at compile time and the same code runs in
+// every kernel.
+//
+// Over a step of 'deltaT' the orientation turns at a constant rate
+// from o0 to o1, and the acceleration is gravity plus 'thrust' (m/s/s,
+// zero where the lander is not thrusting) along the lander's axis.
+// 'anyThrust' is false if 'thrust' is zero everywhere, which saves the
+// sin and cos.
+//
+// This is included in files compiled for other instruction sets, so
+// it only includes headers that are safe there.
+
+
+#ifndef INTEGRATORS_H
+#define INTEGRATORS_H
+
+
+#include "simd.h"
+#include "landerPhysics.h"
+#include <cmath>
+
+
+// Plain arithmetic with the same names as the SIMD wrappers
+
+template <class T>
+struct ScalarOps {
+
+  typedef T F;
+
+  static inline F set1( double a )       { return (F) a; }
+  static inline F add( F a, F b )        { return a + b; }
+  static inline F sub( F a, F b )        { return a - b; }
+  static inline F mul( F a, F b )        { return a * b; }
+  static inline F fmadd( F a, F b, F c ) { return a * b + c; } // a*b+c
+};
+
+
+template <class S>
+struct SinCos {
+  static inline void eval( typename S::F x, typename S::F &s, typename S::F &c ) { simdSinCos<S>( x, s, c ); }
+};
+
+template <class T>
+struct SinCos< ScalarOps<T> > {
+  static inline void eval( T x, T &s, T &c ) { s = std::sin( x ); c = std::cos( x ); }
+};
+
+
+// Acceleration (m/s/s) at orientation 'o'
+
+template <class S>
+inline void landerAccel( typename S::F o, typename S::F thrust, bool anyThrust, typename S::F &ax, typename S::F &ay )
+
+{
+  typedef typename S::F F;
+
+  if (anyThrust) {
+    F s, c;
+    SinCos<S>::eval( o, s, c );
+    ax = S::sub( S::set1( 0 ), S::mul( thrust, s ) );
+    ay = S::fmadd( thrust, c, S::set1( -GRAVITY_ACCEL ) );
+  }
+  else {
+    ax = S::set1( 0 );
+    ay = S::set1( -GRAVITY_ACCEL );
+  }
+}
+
+
+// The original update: the controls act at the start of the step
+// (thrust along the new orientation), then the position moves with
+// the velocity from before gravity is applied.  First order.  This is
+// what Session uses, and what Session::coast() and sweepOutline()
+// assume.
+
+struct ExplicitEuler {
+
+  static const char *name() { return "explicit Euler"; }
+
+  template <class S>
+  static inline void advance( typename S::F &px, typename S::F &py, typename S::F &vx, typename S::F &vy,
+                              typename S::F o0, typename S::F o1, typename S::F thrust, bool anyThrust, double deltaT )
+  {
+    typedef typename S::F F;
+
+    F dt = S::set1( deltaT );
+
+    if (anyThrust) {
+      F s, c;
+      SinCos<S>::eval( o1, s, c );
+      F k = S::mul( thrust, dt );
+      vx = S::sub( vx, S::mul( k, s ) );
+      vy = S::add( vy, S::mul( k, c ) );
+    }
+
+    px = S::fmadd( dt, vx, px );
+    py = S::fmadd( dt, vy, py );
+    vy = S::sub( vy, S::set1( GRAVITY_ACCEL * deltaT ) );
+  }
+};
+
+
+// Semi-implicit (symplectic) Euler: the velocity is updated with the
+// acceleration at the end of the step, then the position with the
+// new velocity.  First order, the same cost as ExplicitEuler.
+
+struct SemiImplicitEuler {
+
+  static const char *name() { return "semi-implicit Euler"; }
+
+  template <class S>
+  static inline void advance( typename S::F &px, typename S::F &py, typename S::F &vx, typename S::F &vy,
+                              typename S::F o0, typename S::F o1, typename S::F thrust, bool anyThrust, double deltaT )
+  {
+    typedef typename S::F F;
+
+    F dt = S::set1( deltaT );
+    F ax, ay;
+    landerAccel<S>( o1, thrust, anyThrust, ax, ay );
+
+    vx = S::fmadd( dt, ax, vx );
+    vy = S::fmadd( dt, ay, vy );
+    px = S::fmadd( dt, vx, px );
+    py = S::fmadd( dt, vy, py );
+  }
+};
+
+
+// Velocity Verlet: the position moves with the starting velocity and
+// acceleration, and the velocity with the average of the accelerations
+// at the two ends.  Second order, and exact in free fall.
+
+struct Verlet {
+
+  static const char *name() { return "Verlet"; }
+
+  template <class S>
+  static inline void advance( typename S::F &px, typename S::F &py, typename S::F &vx, typename S::F &vy,
+                              typename S::F o0, typename S::F o1, typename S::F thrust, bool anyThrust, double deltaT )
+  {
+    typedef typename S::F F;
+
+    F dt     = S::set1( deltaT );
+    F halfDt = S::set1( 0.5 * deltaT );
+    F a0x, a0y, a1x, a1y;
+    landerAccel<S>( o0, thrust, anyThrust, a0x, a0y );
+    landerAccel<S>( o1, thrust, anyThrust, a1x, a1y );
+
+    px = S::fmadd( dt, S::fmadd( halfDt, a0x, vx ), px );
+    py = S::fmadd( dt, S::fmadd( halfDt, a0y, vy ), py );
+    vx = S::fmadd( halfDt, S::add( a0x, a1x ), vx );
+    vy = S::fmadd( halfDt, S::add( a0y, a1y ), vy );
+  }
+};
+
+
+// Classical fourth-order Runge-Kutta.  The acceleration depends only
+// on time (through the orientation), so the second and third stages
+// are both at the midpoint and the step reduces to Simpson's rule for
+// the velocity.  Fourth order, and exact in free fall.
+
+struct RK4 {
+
+  static const char *name() { return "RK4"; }
+
+  template <class S>
+  static inline void advance( typename S::F &px, typename S::F &py, typename S::F &vx, typename S::F &vy,
+                              typename S::F o0, typename S::F o1, typename S::F thrust, bool anyThrust, double deltaT )
+  {
+    typedef typename S::F F;
+
+    F dt      = S::set1( deltaT );
+    F sixthDt = S::set1( deltaT / 6 );
+    F a0x, a0y, amx, amy, a1x, a1y;
+    landerAccel<S>( o0, thrust, anyThrust, a0x, a0y );
+    landerAccel<S>( S::mul( S::add( o0, o1 ), S::set1( 0.5 ) ), thrust, anyThrust, amx, amy );
+    landerAccel<S>( o1, thrust, anyThrust, a1x, a1y );
+
+    // x1 = x0 + dt v0 + dt^2/6 (a0 + 2 am)
+    // v1 = v0 + dt/6 (a0 + 4 am + a1)
+
+    F two  = S::set1( 2 );
+    F four = S::set1( 4 );
+
+    px = S::fmadd( dt, S::fmadd( sixthDt, S::fmadd( two, amx, a0x ), vx ), px );
+    py = S::fmadd( dt, S::fmadd( sixthDt, S::fmadd( two, amy, a0y ), vy ), py );
+    vx = S::fmadd( sixthDt, S::add( S::fmadd( four, amx, a0x ), a1x ), vx );
+    vy = S::fmadd( sixthDt, S::add( S::fmadd( four, amy, a0y ), a1y ), vy );
+  }
+};
+
+
+#endif
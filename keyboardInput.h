@@ -0,0 +1,39 @@
+// keyboardInput.h
+//
+// Lander controls from the GLFW keyboard
+
+
+#ifndef KEYBOARDINPUT_H
+#define KEYBOARDINPUT_H
+
+
+#include "headers.h"
+#include "input.h"
+
+
+class KeyboardInput : public InputSource {
+
+  GLFWwindow *window;
+
+  bool pressed( int key ) { return glfwGetKey( window, key ) == GLFW_PRESS; }
+
+ public:
+
+  KeyboardInput( GLFWwindow *w ) { window = w; }
+
+  Controls controls( Session &session, float deltaT ) {
+
+    Controls c = CONTROL_NONE;
+
+    if (pressed( GLFW_KEY_RIGHT )) c |= CONTROL_ROTATE_CW;  // right arrow
+    if (pressed( GLFW_KEY_LEFT ))  c |= CONTROL_ROTATE_CCW; // left arrow
+    if (pressed( GLFW_KEY_DOWN ))  c |= CONTROL_THRUST;     // down arrow
+    if (pressed( GLFW_KEY_N ))     c |= CONTROL_NEW_GAME;
+    if (pressed( GLFW_KEY_S ))     c |= CONTROL_CONTINUE;
+
+    return c;
+  }
+};
+
+
+#endif
@@ -1,30 +1,30 @@
 // lander.cpp
 
 
-#include "headers.h"
 #include "lander.h"
-#include "world.h"
-#include "gpuProgram.h"
-#include "ll.h"
 
 
-// Animation of the lander is not physically realistic.  The lander
-// should really have a mass (which decreases as fuel is used) and a
-// thrust in Newtons, from which acceleration should be calculated.
-// We also have rotation without rotational inertia (as in the
-// original game).
+// The physics constants are in landerPhysics.h
 
-#define ROTATION_SPEED 0.4	          // upon sidewise thrust, rotation speed in radians/second
-#define THRUST_ACCEL 4.0                  // upon main thrust, acceleration in m/s/s
-#define GRAVITY vec3( 0, -1.6, 0 ) // gravity acceleration on the moon is 1.6 m/s/s
-#define LANDER_WIDTH 6.7                  // the real lander is about 6.7 m wide
+#define GRAVITY vec3( 0, -GRAVITY_ACCEL, 0 )
 
-// Set up the lander by creating a VAO and rewriting the lander
-// vertices so that the lander is centred at (0,0).
 
-void Lander::setupVAO()
+// Set up the lander geometry by rewriting the lander vertices so
+// that the lander is centred at (0,0).  The VAO is set up separately
+// (in landerDraw.cpp) so that the lander can be simulated without
+// OpenGL.
+
+void Lander::setupGeometry()
 
 {
+  // Copy the model so that each lander has its own vertices
+
+  for (int i=0; modelVerts[i] != -1; i+=2) {
+    landerVerts.push_back( modelVerts[i] );
+    landerVerts.push_back( modelVerts[i+1] );
+  }
+  landerVerts.push_back( -1 );
+
   // ---- Rewrite the lander vertices ----
 
   // Find the bounding box of the lander
@@ -62,42 +62,6 @@ void Lander::setupVAO()
     landerVerts[i]   = newV.x / newV.w;
     landerVerts[i+1] = newV.y / newV.w;
   }
-
-  // ---- Create a VAO for this object ----
-
-  // YOUR CODE HERE
-  // This simply is pushing the VAO onto the GPU by giving it the number of segments and the lander verticies
-
-  glGenVertexArrays(1, &VAO);
-  glBindVertexArray(VAO);
-
-  GLuint VBO;
-  glGenBuffers(1, &VBO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, 2 * numSegments * sizeof(float), &landerVerts[0], GL_STATIC_DRAW);
-
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
-}
-
-
-// Draw the lander
-
-void Lander::draw( mat4 &worldToViewTransform )
-
-{
-  // YOUR CODE HERE
-	// Get the position of the lander
-	float x = position.x;
-	float y = position.y;
-	// Translate the lander to the correct coordinates in the world
-	worldToViewTransform = worldToViewTransform * translate(x, y, 0) * rotate(orientation, vec3(0,0,1));
-	// Push the VAO to the GUP with it's transformation
-	glBindVertexArray(VAO);
-	glUniformMatrix4fv(glGetUniformLocation(myGPUProgram->id(), "MVP"), 1, GL_TRUE, &worldToViewTransform[0][0]);
-	glLineWidth(2.0);
-	glDrawArrays(GL_LINES, 0, numSegments);
-
 }
 
 
@@ -111,12 +75,19 @@ void Lander::updatePose( float deltaT )
   orientation = orientation + deltaT * angularVelocity;
   velocity    = velocity    + deltaT * GRAVITY;
 
-  // wrap around screen
+  wrap();
+}
+
+
+// Wrap around screen (the world runs from x = 0 to x = worldMaxX)
 
-  if (position.x > world->maxX() + 10)
-    position.x = world->minX() - 10;
-  else if (position.x < world->minX() - 10)
-    position.x = world->maxX() + 10;
+void Lander::wrap()
+
+{
+  if (position.x > worldMaxX + WRAP_MARGIN)
+    position.x = -WRAP_MARGIN;
+  else if (position.x < -WRAP_MARGIN)
+    position.x = worldMaxX + WRAP_MARGIN;
 }
 
 
@@ -166,7 +137,7 @@ void Lander::addThrust( float deltaT )
 // when the VAO is set up.
 
 
-float Lander::landerVerts[] = {
+const float Lander::modelVerts[] = {
 
   165,859, 157,852,
   157,852, 157,842,
@@ -7,16 +7,20 @@
 #define LANDER_H
 
 
-#include "headers.h"
-// Default fuel is set to 9999 for multi game use
-#define INITIAL_FUEL 9999
+#include "simHeaders.h"
+#include "landerPhysics.h"
+#include "integrators.h"
+#include "input.h"
+#include <vector>
+
 
 class Lander {
 
-  static float landerVerts[];	// lander segments as vertex pairs
+  static const float modelVerts[]; // lander model segments as vertex pairs, ending in -1
+  vector<float> landerVerts;	// model vertices centred at (0,0), for this lander
   int numSegments;		// number of line segments in the lander model
   
-  GLuint VAO;			// VAO for lander geometry
+  unsigned int VAO;		// VAO for lander geometry (see landerDraw.cpp)
 
   vec3 position;		// position in world coordinates (m)
   vec3 velocity;		// velocity in world coordinates (m/s)
@@ -31,6 +35,8 @@ class Lander {
   vec3 landerDimensions;
   vec3 flameDimensions;
 
+  void wrap();
+
  public:
 
   Lander( float maxX, float maxY ) {
@@ -38,20 +44,26 @@ class Lander {
     worldMaxY = maxY;
 	resetFuel();
     reset();
-    setupVAO();
+    setupGeometry();
   };
 
   void resetFuel() { fuelLevel = INITIAL_FUEL; }
 
+  void setupGeometry();
+
   void setupVAO();  
 
-  void draw( mat4 &worldToViewTransform );
+  void draw( mat4 &worldToViewTransform, vec3 pos, float orient );
+
+  void draw( mat4 &worldToViewTransform ) {
+    draw( worldToViewTransform, position, orientation );
+  }
 
   void updatePose( float deltaT );
 
   void reset() {
-    position = vec3( 0.05 * worldMaxX, 0.7 * worldMaxY, 0.0  );
-    velocity = vec3( 30.0f, 0.0f, 0.0f );
+    position = vec3( START_X_FRACTION * worldMaxX, START_Y_FRACTION * worldMaxY, 0.0  );
+    velocity = vec3( START_SPEED, 0.0f, 0.0f );
 
     orientation = 0;
     angularVelocity = 0;
@@ -61,6 +73,40 @@ class Lander {
   void rotateCCW( float deltaT );
   void addThrust( float deltaT );
 
+  // Apply 'controls' and move the lander over a step of 'deltaT' with
+  // one of the integrators in integrators.h.  With ExplicitEuler this
+  // is the same (up to rounding) as the calls above followed by
+  // updatePose().
+
+  template <class Integrator>
+  void step( Controls controls, float deltaT ) {
+    float o0 = orientation;
+    float thrust = 0;
+
+    if (controls & CONTROL_ROTATE_CW)
+      rotateCW( deltaT );
+    if (controls & CONTROL_ROTATE_CCW)
+      rotateCCW( deltaT );
+    if ((controls & CONTROL_THRUST) && fuelLevel > 0) {
+      thrust = THRUST_ACCEL;
+      fuelLevel--;
+    }
+
+    Integrator::template advance< ScalarOps<float> >( position.x, position.y, velocity.x, velocity.y,
+                                                      o0, orientation, thrust, thrust != 0, deltaT );
+    wrap();
+  }
+
+  // Place the lander at an arbitrary starting state (e.g. for headless
+  // runs that sample many starting states)
+
+  void place( vec3 pos, vec3 vel, float orient ) {
+    position = pos;
+    velocity = vel;
+    orientation = orient;
+    angularVelocity = 0;
+  }
+
   vec3 centrePosition() { return position; }
 
   float speed() { return velocity.length(); }
@@ -71,10 +117,15 @@ class Lander {
   void stopLander() { velocity = vec3(0, 0, 0); }
   // Method to get the fuel level
   int fuel() { return fuelLevel; }
+  void setFuel( int units ) { fuelLevel = units; }
+  // Use 'units' of fuel (as for that many controls)
+  void useFuel( int units ) { fuelLevel = (units < fuelLevel ? fuelLevel - units : 0); }
   // Method to get the dimensions 
   vec3 getDimensions() { return landerDimensions; }
   // Method to get the orientation of the lander
   float getOrientation() { return orientation; }
+  // Model vertices (segment endpoints as x,y pairs around the centre, ending in -1)
+  const vector<float> &getVertices() { return landerVerts; }
 };
 
 
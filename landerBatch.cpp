@@ -0,0 +1,165 @@
+// landerBatch.cpp
+
+
+#include "landerBatch.h"
+
+
+#define BATCH_ALIGN 8		// pad arrays to a multiple of the widest SIMD width
+
+
+LanderBatch::LanderBatch( int n, float maxX, float maxY )
+
+{
+  numLanders = n;
+  paddedSize = (n + BATCH_ALIGN - 1) / BATCH_ALIGN * BATCH_ALIGN;
+
+  worldMaxX = maxX;
+  worldMaxY = maxY;
+
+  // Padding landers have no controls and no fuel, so they just fall
+
+  posX.assign( paddedSize, 0 );
+  posY.assign( paddedSize, 0 );
+  velX.assign( paddedSize, 0 );
+  velY.assign( paddedSize, 0 );
+  orient.assign( paddedSize, 0 );
+  fuelLevel.assign( paddedSize, 0 );
+  controls.assign( paddedSize, CONTROL_NONE );
+
+  resetAll();
+
+  kernel = bestSimdKernel();
+}
+
+
+void LanderBatch::reset( int i )
+
+{
+  place( i, vec3( START_X_FRACTION * worldMaxX, START_Y_FRACTION * worldMaxY, 0 ), vec3( START_SPEED, 0, 0 ), 0 );
+  fuelLevel[i] = INITIAL_FUEL;
+}
+
+
+void LanderBatch::resetAll()
+
+{
+  for (int i=0; i<numLanders; i++)
+    reset( i );
+}
+
+
+void LanderBatch::setKernel( SimdKernel k )
+
+{
+  if (k == SIMD_AVX2 && !cpuHasAVX2())
+    k = SIMD_SSE2;
+
+#ifndef HAVE_SSE2
+  if (k == SIMD_SSE2)
+    k = SIMD_SCALAR;
+#endif
+
+  kernel = k;
+}
+
+
+LanderArrays LanderBatch::arrays()
+
+{
+  LanderArrays a;
+
+  a.posX = &posX[0];
+  a.posY = &posY[0];
+  a.velX = &velX[0];
+  a.velY = &velY[0];
+  a.orient = &orient[0];
+  a.fuel = &fuelLevel[0];
+  a.controls = &controls[0];
+  a.n = paddedSize;
+  a.worldMaxX = worldMaxX;
+
+  return a;
+}
+
+
+// Scalar version of the kernel, one lander at a time
+
+template <class Integrator>
+static void stepLanderArraysScalar( LanderArrays &a, float deltaT )
+
+{
+  for (int i=0; i<a.n; i++) {
+
+    Controls c = a.controls[i];
+    float o0 = a.orient[i];
+    float thrust = 0;
+
+    if ((c & CONTROL_ROTATE_CW) && a.fuel[i] > 0) {
+      a.orient[i] -= ROTATION_SPEED * deltaT;
+      a.fuel[i]--;
+    }
+
+    if ((c & CONTROL_ROTATE_CCW) && a.fuel[i] > 0) {
+      a.orient[i] += ROTATION_SPEED * deltaT;
+      a.fuel[i]--;
+    }
+
+    if ((c & CONTROL_THRUST) && a.fuel[i] > 0) {
+      thrust = THRUST_ACCEL;
+      a.fuel[i]--;
+    }
+
+    Integrator::template advance< ScalarOps<float> >( a.posX[i], a.posY[i], a.velX[i], a.velY[i],
+                                                      o0, a.orient[i], thrust, thrust != 0, deltaT );
+
+    if (a.posX[i] > a.worldMaxX + WRAP_MARGIN)
+      a.posX[i] = -WRAP_MARGIN;
+    else if (a.posX[i] < -WRAP_MARGIN)
+      a.posX[i] = a.worldMaxX + WRAP_MARGIN;
+  }
+}
+
+
+template <class Integrator>
+void stepLanderArraysSSE2( LanderArrays &a, float deltaT )
+
+{
+#ifdef HAVE_SSE2
+  stepLanderArrays<SimdSSE2, Integrator>( a, deltaT );
+#else
+  stepLanderArraysScalar<Integrator>( a, deltaT );
+#endif
+}
+
+
+template <class Integrator>
+void LanderBatch::step( float deltaT )
+
+{
+  LanderArrays a = arrays();
+
+  switch (kernel) {
+  case SIMD_AVX2:
+    stepLanderArraysAVX2<Integrator>( a, deltaT );
+    break;
+  case SIMD_SSE2:
+    stepLanderArraysSSE2<Integrator>( a, deltaT );
+    break;
+  default:
+    stepLanderArraysScalar<Integrator>( a, deltaT );
+    break;
+  }
+}
+
+
+// The integrators in integrators.h
+
+template void stepLanderArraysSSE2<ExplicitEuler>( LanderArrays &a, float deltaT );
+template void stepLanderArraysSSE2<SemiImplicitEuler>( LanderArrays &a, float deltaT );
+template void stepLanderArraysSSE2<Verlet>( LanderArrays &a, float deltaT );
+template void stepLanderArraysSSE2<RK4>( LanderArrays &a, float deltaT );
+
+template void LanderBatch::step<ExplicitEuler>( float deltaT );
+template void LanderBatch::step<SemiImplicitEuler>( float deltaT );
+template void LanderBatch::step<Verlet>( float deltaT );
+template void LanderBatch::step<RK4>( float deltaT );
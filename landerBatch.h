@@ -0,0 +1,89 @@
+// landerBatch.h
+//
+// Many landers stored as a structure of arrays and stepped together
+// with SIMD kernels.  Each lander follows the same physics as Lander
+// (see landerBatchKernel.h) but there is no per-lander object, so
+// millions of landers can be stepped for Monte Carlo runs and
+// controller training.
+
+
+#ifndef LANDERBATCH_H
+#define LANDERBATCH_H
+
+
+#include "simHeaders.h"
+#include "landerPhysics.h"
+#include "landerBatchKernel.h"
+#include "input.h"
+#include <vector>
+
+
+class LanderBatch {
+
+  int numLanders;
+  int paddedSize;		// numLanders rounded up to the SIMD width
+
+  vector<float> posX, posY;	// position in world coordinates (m)
+  vector<float> velX, velY;	// velocity in world coordinates (m/s)
+  vector<float> orient;		// orientation (radians CCW)
+  vector<int>   fuelLevel;
+  vector<Controls> controls;	// controls for the next step
+
+  float worldMaxX, worldMaxY;	// world dimensions
+
+  SimdKernel kernel;
+
+  LanderArrays arrays();
+
+ public:
+
+  LanderBatch( int n, float maxX, float maxY );
+
+  int size() { return numLanders; }
+
+  // Put lander 'i' (or all landers) at the start position with full fuel
+
+  void reset( int i );
+  void resetAll();
+
+  void place( int i, vec3 pos, vec3 vel, float orientation ) {
+    posX[i] = pos.x;  posY[i] = pos.y;
+    velX[i] = vel.x;  velY[i] = vel.y;
+    orient[i] = orientation;
+  }
+
+  void setFuel( int i, int fuel ) { fuelLevel[i] = fuel; }
+
+  // Controls for the next step.  These stay set until changed.
+
+  void setControls( int i, Controls c ) { controls[i] = c; }
+  Controls *controlData() { return &controls[0]; }
+
+  // Step all landers by 'deltaT' seconds, with one of the integrators
+  // in integrators.h (by default, the game's own update)
+
+  template <class Integrator> void step( float deltaT );
+  void step( float deltaT ) { step<ExplicitEuler>( deltaT ); }
+
+  // The kernel used by step().  By default this is the widest one
+  // the CPU supports.
+
+  void setKernel( SimdKernel k );
+  SimdKernel getKernel() { return kernel; }
+
+  vec3  centrePosition( int i ) { return vec3( posX[i], posY[i], 0 ); }
+  vec3  getVelocity( int i )    { return vec3( velX[i], velY[i], 0 ); }
+  float getOrientation( int i ) { return orient[i]; }
+  int   fuel( int i )           { return fuelLevel[i]; }
+
+  // Direct access to the arrays, for code that reads many landers
+
+  const float *positionX()   { return &posX[0]; }
+  const float *positionY()   { return &posY[0]; }
+  const float *velocityX()   { return &velX[0]; }
+  const float *velocityY()   { return &velY[0]; }
+  const float *orientations() { return &orient[0]; }
+};
+
+
+#endif
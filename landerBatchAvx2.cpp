@@ -0,0 +1,27 @@
+// landerBatchAvx2.cpp
+//
+// The AVX2 instance of the lander batch kernel.  This file is built
+// with -mavx2 -mfma, so it must only be called when cpuHasAVX2().
+
+
+#include "landerBatchKernel.h"
+
+
+template <class Integrator>
+void stepLanderArraysAVX2( LanderArrays &a, float deltaT )
+
+{
+#ifdef HAVE_AVX2
+  stepLanderArrays<SimdAVX2, Integrator>( a, deltaT );
+#else
+  stepLanderArraysSSE2<Integrator>( a, deltaT );
+#endif
+}
+
+
+// The integrators in integrators.h
+
+template void stepLanderArraysAVX2<ExplicitEuler>( LanderArrays &a, float deltaT );
+template void stepLanderArraysAVX2<SemiImplicitEuler>( LanderArrays &a, float deltaT );
+template void stepLanderArraysAVX2<Verlet>( LanderArrays &a, float deltaT );
+template void stepLanderArraysAVX2<RK4>( LanderArrays &a, float deltaT );
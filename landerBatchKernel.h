@@ -0,0 +1,107 @@
+// landerBatchKernel.h
+//
+// The SIMD kernel that steps a LanderBatch.  It is compiled once for
+// SSE2 (in landerBatch.cpp) and once for AVX2 (in landerBatchAvx2.cpp)
+// for each integrator, so it only includes headers that are safe in
+// either file.
+
+
+#ifndef LANDERBATCHKERNEL_H
+#define LANDERBATCHKERNEL_H
+
+
+#include "simd.h"
+#include "landerPhysics.h"
+#include "integrators.h"
+
+
+// The lander arrays, padded so that 'n' is a multiple of the widest
+// SIMD width
+
+struct LanderArrays {
+  float *posX, *posY;
+  float *velX, *velY;
+  float *orient;
+  int   *fuel;
+  const unsigned char *controls; // Controls bitmask (see input.h)
+  int    n;
+  float  worldMaxX;
+};
+
+
+// Step all of the landers by 'deltaT' seconds.  This does what
+// Lander::step() does for each lander's controls: the controls are
+// applied (if there is fuel) as in Lander::rotateCW(), rotateCCW() and
+// addThrust(), then the Integrator (see integrators.h) moves the
+// lander.  With ExplicitEuler this is the same as those calls followed
+// by Lander::updatePose().
+
+template <class S, class Integrator>
+void stepLanderArrays( LanderArrays &a, float deltaT )
+
+{
+  typedef typename S::F F;
+  typedef typename S::I I;
+
+  const I zero     = S::set1i( 0 );
+  const I cwBit    = S::set1i( 0x01 ); // CONTROL_ROTATE_CW
+  const I ccwBit   = S::set1i( 0x02 ); // CONTROL_ROTATE_CCW
+  const I thrustBit = S::set1i( 0x04 ); // CONTROL_THRUST
+
+  const F rotStep   = S::set1( ROTATION_SPEED * deltaT );
+  const F thrustAccel = S::set1( THRUST_ACCEL );
+  const F wrapHigh  = S::set1( a.worldMaxX + WRAP_MARGIN );
+  const F wrapLow   = S::set1( -WRAP_MARGIN );
+
+  for (int i=0; i<a.n; i+=S::WIDTH) {
+
+    I ctl  = S::loadBytes( a.controls + i );
+    I fuel = S::loadi( a.fuel + i );
+    F o0   = S::load( a.orient + i );
+    F o    = o0;
+
+    // Each control is applied only if there is fuel left, and uses
+    // one unit of fuel (the masks are -1 where applied)
+
+    I cw = S::andi( S::eqi( S::andi( ctl, cwBit ), cwBit ), S::gti( fuel, zero ) );
+    fuel = S::addi( fuel, cw );
+    o = S::sub( o, S::andf( S::asF( cw ), rotStep ) );
+
+    I ccw = S::andi( S::eqi( S::andi( ctl, ccwBit ), ccwBit ), S::gti( fuel, zero ) );
+    fuel = S::addi( fuel, ccw );
+    o = S::add( o, S::andf( S::asF( ccw ), rotStep ) );
+
+    I thrust = S::andi( S::eqi( S::andi( ctl, thrustBit ), thrustBit ), S::gti( fuel, zero ) );
+    fuel = S::addi( fuel, thrust );
+
+    // Move the lander
+
+    F px = S::load( a.posX + i );
+    F py = S::load( a.posY + i );
+    F vx = S::load( a.velX + i );
+    F vy = S::load( a.velY + i );
+
+    Integrator::template advance<S>( px, py, vx, vy, o0, o, S::andf( S::asF( thrust ), thrustAccel ), S::anyi( thrust ), deltaT );
+
+    // Wrap around the screen
+
+    px = S::select( S::gt( px, wrapHigh ), wrapLow, S::select( S::lt( px, wrapLow ), wrapHigh, px ) );
+
+    S::store( a.posX + i, px );
+    S::store( a.posY + i, py );
+    S::store( a.velX + i, vx );
+    S::store( a.velY + i, vy );
+    S::store( a.orient + i, o );
+    S::storei( a.fuel + i, fuel );
+  }
+}
+
+
+// Entry points for each instruction set, instantiated for each of the
+// integrators in integrators.h
+
+template <class Integrator> void stepLanderArraysSSE2( LanderArrays &a, float deltaT );
+template <class Integrator> void stepLanderArraysAVX2( LanderArrays &a, float deltaT );
+
+
+#endif
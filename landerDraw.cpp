@@ -0,0 +1,55 @@
+// landerDraw.cpp
+//
+// The OpenGL parts of the lander
+
+
+#include "headers.h"
+#include "lander.h"
+#include "gpuProgram.h"
+#include "ll.h"
+
+
+// Set up the VAO that defines the lander segments.  This must be
+// called after setupGeometry() (which the constructor does) and
+// once there is an OpenGL context.
+
+void Lander::setupVAO()
+
+{
+  // ---- Create a VAO for this object ----
+
+  // YOUR CODE HERE
+  // This simply is pushing the VAO onto the GPU by giving it the number of segments and the lander verticies
+
+  glGenVertexArrays(1, &VAO);
+  glBindVertexArray(VAO);
+
+  GLuint VBO;
+  glGenBuffers(1, &VBO);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glBufferData(GL_ARRAY_BUFFER, 2 * numSegments * sizeof(float), &landerVerts[0], GL_STATIC_DRAW);
+
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+}
+
+
+// Draw the lander at pose ('pos','orient'), which the world may
+// interpolate between simulation steps
+
+void Lander::draw( mat4 &worldToViewTransform, vec3 pos, float orient )
+
+{
+  // YOUR CODE HERE
+	// Get the position of the lander
+	float x = pos.x;
+	float y = pos.y;
+	// Translate the lander to the correct coordinates in the world
+	worldToViewTransform = worldToViewTransform * translate(x, y, 0) * rotate(orient, vec3(0,0,1));
+	// Push the VAO to the GUP with it's transformation
+	glBindVertexArray(VAO);
+	glUniformMatrix4fv(glGetUniformLocation(myGPUProgram->id(), "MVP"), 1, GL_TRUE, &worldToViewTransform[0][0]);
+	glLineWidth(2.0);
+	glDrawArrays(GL_LINES, 0, numSegments);
+
+}
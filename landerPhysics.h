@@ -0,0 +1,36 @@
+// landerPhysics.h
+//
+// Constants of the lander physics, shared by Lander and the batch
+// simulators.  This has no includes so that it can be used in files
+// compiled for other instruction sets (see simd.h).
+
+
+#ifndef LANDERPHYSICS_H
+#define LANDERPHYSICS_H
+
+
+// Animation of the lander is not physically realistic.  The lander
+// should really have a mass (which decreases as fuel is used) and a
+// thrust in Newtons, from which acceleration should be calculated.
+// We also have rotation without rotational inertia (as in the
+// original game).
+
+#define ROTATION_SPEED 0.4	          // upon sidewise thrust, rotation speed in radians/second
+#define THRUST_ACCEL 4.0                  // upon main thrust, acceleration in m/s/s
+#define GRAVITY_ACCEL 1.6                 // gravity acceleration on the moon is 1.6 m/s/s
+#define LANDER_WIDTH 6.7                  // the real lander is about 6.7 m wide
+
+#define WRAP_MARGIN 10                    // lander wraps around this far beyond the world edges (m)
+
+// Default fuel is set to 9999 for multi game use
+#define INITIAL_FUEL 9999
+
+// Start of each landing, as fractions of the world size, and
+// starting horizontal speed (m/s)
+
+#define START_X_FRACTION 0.05
+#define START_Y_FRACTION 0.7
+#define START_SPEED      30.0
+
+
+#endif
@@ -1,19 +1,29 @@
 // landscape.cpp
 
 
-#include "headers.h"
 #include "landscape.h"
-#include "gpuProgram.h"
-#include "ll.h"
 
 
-// Set up the landscape by creating a VAO and rewriting the landscape
-// vertices so that the x values fit in [ 0, LANDSCAPE_WIDTH ].
+// Set up the landscape geometry by rewriting the landscape vertices
+// so that the x values fit in [ 0, LANDSCAPE_WIDTH ].  The VAO is set
+// up separately (in landscapeDraw.cpp).
+//
+// 'verts' holds 'n' vertices, or ends in -1 if 'n' is -1.
 
 
-void Landscape::setupVAO()
+void Landscape::setupGeometry( const float *verts, int n )
 
 {
+  // Copy the model so that each landscape has its own vertices
+
+  for (int i=0; (n < 0 ? verts[2*i] != -1 : i < n); i++) {
+    landscapeVerts.push_back( verts[2*i] );
+    landscapeVerts.push_back( verts[2*i+1] );
+  }
+  landscapeVerts.push_back( -1 );
+
+  modelCoords = landscapeVerts;
+
   // ---- Rewrite the landscape vertices into world coordinates ----
 
   // Find the bounding box of the landscape
@@ -70,38 +80,81 @@ void Landscape::setupVAO()
     prevX = landscapeVerts[i];
   }
 
-  // ---- Create a VAO for this object ----
+  buildSegmentIndex();
+}
+
+
+// Build the indices of the segments: the Eytzinger index of vertex x
+// coordinates, and the BVH used by findClosestPoint().  The vertices
+// are already sorted by x (see setupGeometry()), so an in-order walk
+// of the implicit tree fills the Eytzinger index.
 
-  glGenVertexArrays( 1, &VAO );
-  glBindVertexArray( VAO );
 
-  // Store the vertices
+void Landscape::buildSegmentIndex()
+
+{
+  eytzX.resize( numVerts+1 );
+  eytzVert.resize( numVerts+1 );
 
-  GLuint VBO;
-  glGenBuffers( 1, &VBO );
-  glBindBuffer( GL_ARRAY_BUFFER, VBO );
-  glBufferData( GL_ARRAY_BUFFER, 2*numVerts*sizeof(float), &landscapeVerts[0], GL_STATIC_DRAW );
+  fillSegmentIndex( 1, 0 );
 
-  // define the position attribute
+  segmentTree.build( &landscapeVerts[0], numVerts );
 
-  glEnableVertexAttribArray( 0 );
-  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 0, 0 );
+  // Segment arrays for the SIMD scan, padded with segments far away
+
+  int numSegs = numVerts - 1;
+  int padded  = (numSegs + 7) / 8 * 8;
+
+  segX0.assign( padded, 1e18 );
+  segY0.assign( padded, 1e18 );
+  segDX.assign( padded, 0 );
+  segDY.assign( padded, 0 );
+  segInvLen2.assign( padded, 0 );
+
+  for (int i=0; i<numSegs; i++) {
+    segX0[i] = landscapeVerts[2*i];
+    segY0[i] = landscapeVerts[2*i+1];
+    segDX[i] = landscapeVerts[2*(i+1)]   - segX0[i];
+    segDY[i] = landscapeVerts[2*(i+1)+1] - segY0[i];
+    float len2 = segDX[i]*segDX[i] + segDY[i]*segDY[i];
+    segInvLen2[i] = (len2 > 0 ? 1 / len2 : 0);
+  }
+
+  if (closestMethod == CLOSEST_AUTO)
+    closestMethod = (numSegs <= SIMD_SCAN_MAX_SEGMENTS ? CLOSEST_SIMD : CLOSEST_BVH);
 }
 
 
-// Draw the landscape
+void Landscape::setClosestPointMethod( ClosestPointMethod m, SimdKernel kernel )
 
+{
+  if (m == CLOSEST_AUTO)
+    m = (numVerts - 1 <= SIMD_SCAN_MAX_SEGMENTS ? CLOSEST_SIMD : CLOSEST_BVH);
+
+  if (kernel == SIMD_AVX2 && !cpuHasAVX2())
+    kernel = SIMD_SSE2;
+
+  closestMethod = m;
+  simdKernel    = kernel;
+}
 
-void Landscape::draw(  mat4 &worldToViewTransform )
+
+// Fill the subtree rooted at node 'k' with vertices starting at
+// 'nextVert'.  Return the next vertex not used.
+
+
+int Landscape::fillSegmentIndex( int k, int nextVert )
 
 {
-  glBindVertexArray( VAO );
+  if (k > numVerts)
+    return nextVert;
 
-  glUniformMatrix4fv( glGetUniformLocation( myGPUProgram->id(), "MVP"), 1, GL_TRUE, &worldToViewTransform[0][0] );
+  nextVert = fillSegmentIndex( 2*k, nextVert );
 
-  glLineWidth( 2.0 );
+  eytzX[k]    = landscapeVerts[2*nextVert];
+  eytzVert[k] = nextVert;
 
-  glDrawArrays( GL_LINE_STRIP, 0, numVerts );
+  return fillSegmentIndex( 2*k+1, nextVert+1 );
 }
 
 
@@ -119,29 +172,79 @@ vec3 Landscape::findClosestPoint( vec3 position, vec3 segTail, vec3 segHead )
 
 	// Create vector s for current segment
 	vec3 s = vec3(segHead.x - segTail.x, segHead.y - segTail.y, 0);
+	float length = sqrt(s.x*s.x + s.y*s.y);
+	// A segment of zero length is just its tail
+	if (length == 0) {
+		return segTail;
+	}
 	// Normalize s
-	vec3 S = 1 / sqrt(s.x*s.x + s.y*s.y) * s;
+	vec3 S = 1 / length * s;
 	// Define vector p to point from tail of S
 	vec3 p = position - segTail; 
 	float a = p*S; 
-	// a = amount of p in the direction of s
+	// a = distance along s of the projection of p
 	if (a < 0) {
 		return segTail;
 	}
-	if (a > 1) {
+	if (a > length) {
 		return segHead;
 	}
-	// if a > 0 && a < 1 then p is above the line segment so return distance along segment + start of segment
-	return a*s + segTail;
+	// if 0 <= a <= length then p is above the line segment so return distance along segment + start of segment
+	return a*S + segTail;
 }
 
 
 // Find the point on the landscape that is closest to 'position'.
 //
-// This is very inefficiently done.
+// Large landscapes are searched with the bounding volume hierarchy of
+// the segments, so only segments near 'position' are looked at.
+// Small ones are faster to scan with SIMD, checking every segment.
 
 vec3 Landscape::findClosestPoint( vec3 position )
 
+{
+  float dist2;
+  int   i;
+
+  switch (closestMethod) {
+
+  case CLOSEST_SCAN:
+    return findClosestPointByScan( position );
+
+  case CLOSEST_SIMD: {
+    SegmentArrays a;
+    a.x0 = &segX0[0];
+    a.y0 = &segY0[0];
+    a.dx = &segDX[0];
+    a.dy = &segDY[0];
+    a.invLen2 = &segInvLen2[0];
+    a.n = segX0.size();
+    if (simdKernel == SIMD_AVX2)
+      i = nearestSegmentArraysAVX2( a, position.x, position.y, dist2 );
+    else
+      i = nearestSegmentArraysSSE2( a, position.x, position.y, dist2 );
+    break;
+  }
+
+  default:
+    i = segmentTree.nearestSegment( position.x, position.y, dist2 );
+    break;
+  }
+
+  if (i < 0 || i >= numVerts - 1) // no segments
+    return vec3( landscapeVerts[0], landscapeVerts[1], 0 );
+
+  return findClosestPoint( position,
+                           vec3( landscapeVerts[2*i], landscapeVerts[2*i+1], 0 ),
+                           vec3( landscapeVerts[2*(i+1)], landscapeVerts[2*(i+1)+1], 0 ) );
+}
+
+
+// The same as findClosestPoint( position ), by checking every
+// segment.  This is kept to check and benchmark the BVH.
+
+vec3 Landscape::findClosestPointByScan( vec3 position )
+
 {
   vec3  closestPoint;
   float minSquaredDistance = MAXFLOAT;
@@ -163,17 +266,105 @@ vec3 Landscape::findClosestPoint( vec3 position )
   return closestPoint;
 }
 
-int Landscape::findSegmentBelow(vec3 centerPosition) {
-	// Find segment below point P
-	for (int i = 0; i < numVerts - 1; i++) {
-		int xstart = landscapeVerts[2 * i];
-		int xend = landscapeVerts[2 * (i + 1)];
-		// Checking if it's x is in the bounds of the segment
-		if (centerPosition.x > xstart && centerPosition.x < xend) {
-			return i;
-		}
-	}
-	return 0;
+
+// The SSE2 instance of the closest segment kernel (the AVX2 instance
+// is in closestSegmentAvx2.cpp)
+
+int nearestSegmentArraysSSE2( const SegmentArrays &a, float px, float py, float &dist2 )
+
+{
+#ifdef HAVE_SSE2
+  return nearestSegmentArrays<SimdSSE2>( a, px, py, dist2 );
+#else
+  int   best = -1;
+  dist2 = MAXFLOAT;
+  for (int i=0; i<a.n; i++) {
+    float t;
+    float d2 = pointSegmentDist2( px, py, a.x0[i], a.y0[i], a.x0[i]+a.dx[i], a.y0[i]+a.dy[i], t );
+    if (d2 < dist2) {
+      dist2 = d2;
+      best  = i;
+    }
+  }
+  return best;
+#endif
+}
+
+
+// Find the segment below 'centerPosition': the last segment whose
+// left end is at or left of it, skipping vertical segments.  Outside
+// the landscape, this is the first or last segment.
+//
+// This is a branchless binary search of the Eytzinger index, which
+// descends the implicit tree to a leaf and then recovers the first
+// vertex to the right of 'centerPosition' from the path taken.
+
+
+int Landscape::findSegmentBelow(vec3 centerPosition)
+
+{
+  float x = centerPosition.x;
+  const float *tree = &eytzX[0];
+
+  int k = 1;
+
+  while (k <= numVerts) {
+#ifdef __GNUC__
+    __builtin_prefetch( tree + 16*k );	// the 16 descendants four levels down fill one cache line
+#endif
+    k = 2*k + (tree[k] <= x);
+  }
+
+  // Undo the right turns at the bottom of the path and one left turn
+  // to find the first vertex with x > centerPosition.x (or 0 if none)
+
+#ifdef __GNUC__
+  k >>= __builtin_ffs( ~k );
+#else
+  while (k & 1)
+    k >>= 1;
+  k >>= 1;
+#endif
+
+  int numAtOrLeft = (k == 0 ? numVerts : eytzVert[k]);
+
+  int i = numAtOrLeft - 1;
+
+  if (i < 0)
+    i = 0;
+  else if (i > numVerts - 2) {
+    i = numVerts - 2;
+    while (i > 0 && landscapeVerts[2*(i+1)] == landscapeVerts[2*i]) // skip vertical segments at the right end
+      i--;
+  }
+
+  return i;
+}
+
+
+// The same as findSegmentBelow(), by checking every segment.  This is
+// kept to check and benchmark the index.
+
+
+int Landscape::findSegmentBelowByScan(vec3 centerPosition)
+
+{
+  int numAtOrLeft = 0;
+
+  while (numAtOrLeft < numVerts && landscapeVerts[2*numAtOrLeft] <= centerPosition.x)
+    numAtOrLeft++;
+
+  int i = numAtOrLeft - 1;
+
+  if (i < 0)
+    i = 0;
+  else if (i > numVerts - 2) {
+    i = numVerts - 2;
+    while (i > 0 && landscapeVerts[2*(i+1)] == landscapeVerts[2*i])
+      i--;
+  }
+
+  return i;
 }
 
 float Landscape::getSegmentWidth(int segmentIndex) {
@@ -238,7 +429,7 @@ float Landscape::findLanderAltitude(int i, vec3 centerPosition, float landerHeig
 // world coordinate system when the VAO is set up.
 
 
-float Landscape::landscapeVerts[] = {
+const float Landscape::modelVerts[] = {
   -463, 866,
   -449, 866,
   -445, 879,
@@ -10,26 +10,76 @@
 #define LANDSCAPE_H
 
 
-#include "headers.h"
+#include "simHeaders.h"
+#include "segmentBVH.h"
+#include "closestSegmentKernel.h"
+#include <vector>
 
 
 #define LANDSCAPE_WIDTH 1000.0	// Width of landscape in meters
 
 #define ZOOM_RADIUS 70.0        // Radius of zoomed view (when lander is close to terrain)
 
+#define SIMD_SCAN_MAX_SEGMENTS 1024 // SIMD scan is faster than the BVH up to about this many segments
+
+
+// How findClosestPoint() searches the segments
+
+typedef enum {
+  CLOSEST_AUTO,			// SIMD scan for small landscapes, BVH for large ones
+  CLOSEST_SCAN,			// check every segment (scalar)
+  CLOSEST_BVH,			// search the segment BVH
+  CLOSEST_SIMD			// check every segment, 4 or 8 at a time
+} ClosestPointMethod;
+
 
 class Landscape {
 
-  static float landscapeVerts[];
+  static const float modelVerts[]; // landscape model as a path of vertices, ending in -1
+  vector<float> landscapeVerts;	// model vertices in world coordinates, for this landscape
+  vector<float> modelCoords;	// the same vertices in model coordinates (see FixedTerrain)
   int numVerts;			// number of vertices in the landscape model
-  GLuint VAO;
+  unsigned int VAO;		// VAO for landscape geometry (see landscapeDraw.cpp)
+
+  // Index of the vertex x coordinates for findSegmentBelow(), stored
+  // in Eytzinger (breadth-first binary tree) order starting at [1],
+  // with the vertex number of each
+
+  vector<float> eytzX;
+  vector<int>   eytzVert;
+
+  SegmentBVH segmentTree;	// for findClosestPoint()
+
+  // The segments as a structure of arrays for the SIMD scan (see
+  // closestSegmentKernel.h), padded to a multiple of 8
+
+  vector<float> segX0, segY0, segDX, segDY, segInvLen2;
+
+  ClosestPointMethod closestMethod;
+  SimdKernel         simdKernel;
+
+  void buildSegmentIndex();
+  int  fillSegmentIndex( int k, int nextVert );
 
  public:
 
   Landscape() {
-    setupVAO();
+    closestMethod = CLOSEST_AUTO;
+    simdKernel    = bestSimdKernel();
+    setupGeometry( modelVerts, -1 );
   }
 
+  // A landscape from 'n' vertices (x,y pairs) in the same model
+  // coordinates as modelVerts, with y increasing downward
+
+  Landscape( const float *verts, int n ) {
+    closestMethod = CLOSEST_AUTO;
+    simdKernel    = bestSimdKernel();
+    setupGeometry( verts, n );
+  }
+
+  void setupGeometry( const float *verts, int n );
+
   void setupVAO();  
 
   void draw( mat4 &worldToViewTransform );
@@ -40,7 +90,34 @@ class Landscape {
 
   vec3 findClosestPoint( vec3 position, vec3 segTail, vec3 segHead );
   vec3 findClosestPoint( vec3 position );
+  vec3 findClosestPointByScan( vec3 position );
+
+  // The segment closest to 'position' from the BVH, and its squared
+  // distance.  Returns -1 if no segment is closer than 'maxDist2'.
+
+  int findClosestSegment( vec3 position, float &dist2, float maxDist2 = MAXFLOAT ) {
+    return segmentTree.nearestSegment( position.x, position.y, dist2, maxDist2 );
+  }
+
+  // Call visit(i) for each segment i that may overlap the box (see
+  // SegmentBVH::forSegmentsInBox())
+
+  template <class Visitor>
+  void forSegmentsInBox( float minX, float minY, float maxX, float maxY, Visitor &visit ) {
+    segmentTree.forSegmentsInBox( minX, minY, maxX, maxY, visit );
+  }
+
+  // Choose how findClosestPoint() works (for benchmarking).  The SIMD
+  // scan uses 'kernel' if the CPU supports it.
+
+  void setClosestPointMethod( ClosestPointMethod m, SimdKernel kernel = bestSimdKernel() );
+  SimdKernel getSimdKernel() { return simdKernel; }
   int findSegmentBelow(vec3 centerPosition);
+  int findSegmentBelowByScan(vec3 centerPosition);
+  int numSegments() { return numVerts - 1; }
+  vec3 vertex( int i ) { return vec3( landscapeVerts[2*i], landscapeVerts[2*i+1], 0 ); }
+  const float *vertices() { return &landscapeVerts[0]; } // x,y pairs
+  const float *modelVertices() { return &modelCoords[0]; } // x,y pairs, as given to the constructor
   float getSegmentWidth(int segmentIndex);
   float findLanderAltitude(int segmentIndex, vec3 centerPosition, float landerHeight);
   int isSegmentGoodToLand(int segmentIndex, float orientation, vec3 centerposition, float landerWidth);
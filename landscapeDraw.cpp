@@ -0,0 +1,52 @@
+// landscapeDraw.cpp
+//
+// The OpenGL parts of the landscape
+
+
+#include "headers.h"
+#include "landscape.h"
+#include "gpuProgram.h"
+#include "ll.h"
+
+
+// Set up the VAO that holds the landscape vertices.  This must be
+// called after setupGeometry() (which the constructor does) and once
+// there is an OpenGL context.
+
+
+void Landscape::setupVAO()
+
+{
+  // ---- Create a VAO for this object ----
+
+  glGenVertexArrays( 1, &VAO );
+  glBindVertexArray( VAO );
+
+  // Store the vertices
+
+  GLuint VBO;
+  glGenBuffers( 1, &VBO );
+  glBindBuffer( GL_ARRAY_BUFFER, VBO );
+  glBufferData( GL_ARRAY_BUFFER, 2*numVerts*sizeof(float), &landscapeVerts[0], GL_STATIC_DRAW );
+
+  // define the position attribute
+
+  glEnableVertexAttribArray( 0 );
+  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 0, 0 );
+}
+
+
+// Draw the landscape
+
+
+void Landscape::draw(  mat4 &worldToViewTransform )
+
+{
+  glBindVertexArray( VAO );
+
+  glUniformMatrix4fv( glGetUniformLocation( myGPUProgram->id(), "MVP"), 1, GL_TRUE, &worldToViewTransform[0][0] );
+
+  glLineWidth( 2.0 );
+
+  glDrawArrays( GL_LINE_STRIP, 0, numVerts );
+}
@@ -1,8 +1,21 @@
 // Lunar lander game
+//
+// Usage: ll [-hz rate] [-novsync] [-sdf] [-shape] [-record file] [-heatmap samples]
+//
+// -hz sets the number of simulation steps per second (default
+// SIM_RATE).  -novsync draws as fast as possible instead of once per
+// screen refresh; the simulation runs at the same rate either way.
+// -sdf precomputes a distance field to the landscape (see
+// distanceField.h) for deciding when to zoom.  -shape tests the whole
+// lander outline against the landscape (see configObstacle.h).
+// -record writes the game to 'file' as a replay (see replay.h) when
+// the window is closed, for llplay to re-simulate.  -heatmap works
+// out the chance that the descent controller lands from each start
+// position (see heatmap.h) in the background, with 'samples' episodes
+// per cell, and draws it over the world; 'h' switches between the
+// landing success, the fuel used and no overlay.
 
 
-#include <sys/timeb.h>
-
 #include "headers.h"
 #include "gpuProgram.h"
 #include "world.h"
@@ -11,8 +24,6 @@
 
 GPUProgram *myGPUProgram;	// pointer to GPU program object
 
-World *world;			// the world, including landscape and lander
-
 bool pauseGame = false;
 
 
@@ -22,10 +33,12 @@ bool pauseGame = false;
 void keyCallback( GLFWwindow *w, int key, int scancode, int action, int mods )
 
 {
+  World *world = (World *) glfwGetWindowUserPointer( w ); // the world shown in this window
+
   if (action == GLFW_PRESS)
     
     if (key == GLFW_KEY_ESCAPE)	// quit upon ESC
-      exit(0);
+      glfwSetWindowShouldClose( w, GL_TRUE );
 
     else if (key == 'p')	// p = pause
       pauseGame = !pauseGame;
@@ -33,6 +46,12 @@ void keyCallback( GLFWwindow *w, int key, int scancode, int action, int mods )
     else if (key == 'r')	// r = reset lander
       world->resetLander();
 
+    else if (key == GLFW_KEY_H)	// h = next heatmap overlay
+      world->cycleHeatmap();
+
+    else if (key == GLFW_KEY_A)	// a = autopilot on/off
+      world->toggleAutopilot();
+
     else if (key == '?') 	// ? = output help
       cout << "help" << endl;
 }
@@ -54,6 +73,31 @@ void errorCallback( int error, const char* description )
 int main( int argc, char **argv )
 
 {
+  float simRate = SIM_RATE;
+  bool  vsync   = true;
+  bool  useSdf  = false;
+  bool  useShape = false;
+  const char *recordPath = NULL;
+  int   heatmapSamples = 0;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-hz" ) == 0 && i+1 < argc && atof( argv[i+1] ) > 0)
+      simRate = atof( argv[++i] );
+    else if (strcmp( argv[i], "-novsync" ) == 0)
+      vsync = false;
+    else if (strcmp( argv[i], "-sdf" ) == 0)
+      useSdf = true;
+    else if (strcmp( argv[i], "-shape" ) == 0)
+      useShape = true;
+    else if (strcmp( argv[i], "-record" ) == 0 && i+1 < argc)
+      recordPath = argv[++i];
+    else if (strcmp( argv[i], "-heatmap" ) == 0 && i+1 < argc)
+      heatmapSamples = atoi( argv[++i] );
+    else {
+      cerr << "Usage: ll [-hz rate] [-novsync] [-sdf] [-shape] [-record file] [-heatmap samples]" << endl;
+      return 1;
+    }
+
   // Set up GLFW
 
   GLFWwindow* window;
@@ -78,7 +122,7 @@ int main( int argc, char **argv )
 
   glfwMakeContextCurrent( window );
   
-  glfwSwapInterval( 1 ); // redraw at most every 1 screen scan
+  glfwSwapInterval( vsync ? 1 : 0 ); // redraw at most every 1 screen scan (or as fast as possible)
   
   // Set OpenGL function bindings
 
@@ -95,19 +139,20 @@ int main( int argc, char **argv )
 
   // Set up world
 
-  world = new World( window );
+  World *world = new World( window, simRate, useSdf, useShape, recordPath, heatmapSamples );
+
+  glfwSetWindowUserPointer( window, world );
 
   // Run
 
-  struct timeb prevTime, thisTime;
-  ftime( &prevTime );
+  double prevTime = glfwGetTime();
 
   while (!glfwWindowShouldClose( window )) {
 
     // Find elapsed time since last render
 
-    ftime( &thisTime );
-    float elapsedSeconds = (thisTime.time + thisTime.millitm / 1000.0) - (prevTime.time + prevTime.millitm / 1000.0);
+    double thisTime = glfwGetTime();
+    float elapsedSeconds = thisTime - prevTime;
     prevTime = thisTime;
 
     // Update the world state
@@ -129,6 +174,8 @@ int main( int argc, char **argv )
     glfwPollEvents();
   }
 
+  world->saveRecording();
+
   glfwDestroyWindow( window );
   glfwTerminate();
   return 0;
@@ -7,9 +7,6 @@
 class GPUProgram;
 extern GPUProgram *myGPUProgram;
 
-class World;
-extern World *world;
-
 typedef enum { UP, DOWN } KeyState;
 extern KeyState upKey, downKey, leftKey, rightKey;
 
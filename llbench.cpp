@@ -0,0 +1,1886 @@
+// llbench.cpp
+//
+// Benchmarks of the simulation core.
+//
+// Usage: llbench [test ...] [-n count] [-steps s]
+//
+// Tests are:
+//
+//   batch    LanderBatch lander-steps/s for each SIMD kernel, and
+//            its difference from Lander over the same controls
+//
+//   segment  Landscape::findSegmentBelow() on a random terrain of
+//            'count' vertices, against a linear scan
+//
+//   closest  Landscape::findClosestPoint() on a random terrain of
+//            'count' vertices, with the BVH and the SIMD scans,
+//            against the scalar scan
+//
+//   cursor   TerrainCursor queries along a lander-like path low over
+//            a random terrain of 'count' vertices, against the
+//            Landscape queries
+//
+//   sdf      DistanceField build time and lookups over the game
+//            landscape, against the exact distance
+//
+//   cspace   ConfigObstacle build time and clearance queries over the
+//            game landscape, against a direct check of the outline
+//
+//   collide  outlineOverlaps() and sweepOutline() near the game
+//            landscape, and whether they agree on the contact
+//
+//   coast    free-fall episodes stepped and coasted (Session::coast()),
+//            and whether they end the same way
+//
+//   integrate  each integrator in integrators.h: its error over random
+//            episodes at several steps, against a fine reference, and
+//            its lander-steps/s with each SIMD kernel
+//
+//   rewind   RewindBuffer seeks to random steps of a long random
+//            game, their time, and whether they restore the exact
+//            state
+//
+//   env      VecEnv env-steps/s of 'count' environments with one
+//            thread and with one per core, whether they give the
+//            same results, and heap allocations per step
+//
+//   shm      ShmEnv lockstep steps/s and round trips with a
+//            controller in another process, for 'count' environments
+//            with one thread and with one per core, and whether they
+//            give the same results
+//
+//   mpc      MpcAutopilot time per lander-step and per tick for
+//            'count' landers flying at once with the default budget,
+//            against the frame time, and how many land when flown
+//            until they finish (or for 'steps' steps)
+//
+//   policy   PolicyBuilder cell-updates/s with one thread and with
+//            one per core (on a coarse grid), whether they give the
+//            same table, and PolicyController time per lander-step
+//            and per tick for 'count' landers flying with that table
+//
+//   mlp      MlpPolicy evaluation: whether each SIMD kernel agrees
+//            with the scalar one and int8 with fp32, the time per
+//            batch and per lander at each batch size, against the
+//            frame time, and MlpPopulation time per tick for 'count'
+//            sessions
+//
+//   fixed    FixedLanderBatch lander-steps/s for each SIMD kernel,
+//            whether the kernels give the same bits, and the
+//            difference from LanderBatch and from the Landscape
+//            altitude
+//
+// With no tests named, all are run.
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "landerBatch.h"
+#include "terrainCursor.h"
+#include "distanceField.h"
+#include "configObstacle.h"
+#include "collision.h"
+#include "fixedLanderBatch.h"
+#include "fixedTerrain.h"
+#include "rewind.h"
+#include "vecEnv.h"
+#include "shmEnv.h"
+#include "mpcAutopilot.h"
+#include "policyTable.h"
+#include "mlpPolicy.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+int count = -1;			// problem size (test-specific default if -1)
+int steps = -1;			// number of steps (test-specific default if -1)
+
+
+// Count heap allocations, to check that the per-step paths do none.
+// (The library's operator delete calls free().  malloc() is called
+// through a pointer so that the compiler does not pair it with the
+// deletes.)
+
+atomic<long> allocations( 0 );
+void *(*volatile allocate)( size_t ) = malloc;
+
+void *operator new( size_t n )
+
+{
+  allocations++;
+
+  void *p = allocate( n > 0 ? n : 1 );
+  if (!p)
+    throw bad_alloc();
+
+  return p;
+}
+
+
+double now()
+
+{
+  return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+// ---------------- batch ----------------
+
+
+void benchBatch()
+
+{
+  Session session;
+
+  int   n  = (count > 0 ? count : 100000);
+  int   s  = (steps > 0 ? steps : 1000);
+  float dt = 1/60.0;
+
+  minstd_rand rng( 1 );
+
+  cout << "batch: " << n << " landers, " << s << " steps" << endl;
+
+  // Throughput for each kernel, with random controls
+
+  SimdKernel kernels[] = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+  for (int k=0; k<3; k++) {
+
+    LanderBatch batch( n, session.maxX(), session.maxY() );
+
+    batch.setKernel( kernels[k] );
+    if (batch.getKernel() != kernels[k])
+      continue;			// not supported here
+
+    for (int i=0; i<n; i++)
+      batch.setControls( i, rng() % 8 );
+
+    double start = now();
+    for (int j=0; j<s; j++)
+      batch.step( dt );
+    double seconds = now() - start;
+
+    cout << "  " << simdKernelName( kernels[k] ) << ": "
+         << n * (double) s / seconds / 1e6 << " M lander-steps/s" << endl;
+  }
+
+  // Difference from Lander over changing controls
+
+  int m = 64;
+  LanderBatch batch( m, session.maxX(), session.maxY() );
+  vector<Lander *> landers;
+
+  for (int i=0; i<m; i++)
+    landers.push_back( new Lander( session.maxX(), session.maxY() ) );
+
+  float maxPosDiff = 0, maxVelDiff = 0;
+
+  for (int j=0; j<600; j++) {
+
+    for (int i=0; i<m; i++) {
+
+      Controls c = rng() % 8;
+      batch.setControls( i, c );
+
+      if (c & CONTROL_ROTATE_CW)  landers[i]->rotateCW( dt );
+      if (c & CONTROL_ROTATE_CCW) landers[i]->rotateCCW( dt );
+      if (c & CONTROL_THRUST)     landers[i]->addThrust( dt );
+      landers[i]->updatePose( dt );
+    }
+
+    batch.step( dt );
+
+    for (int i=0; i<m; i++) {
+      float dp = (batch.centrePosition( i ) - landers[i]->centrePosition()).length();
+      float dv = (batch.getVelocity( i ) - landers[i]->getVelocity()).length();
+      if (dp > maxPosDiff) maxPosDiff = dp;
+      if (dv > maxVelDiff) maxVelDiff = dv;
+    }
+  }
+
+  cout << "  " << simdKernelName( batch.getKernel() ) << " vs Lander after 600 steps: max position difference "
+       << maxPosDiff << " m, max velocity difference " << maxVelDiff << " m/s" << endl;
+
+  for (int i=0; i<m; i++)
+    delete landers[i];
+}
+
+
+// ---------------- terrain ----------------
+
+
+// A random terrain of 'n' vertices in landscape model coordinates
+// (y increasing downward), with some vertical segments
+
+Landscape *randomLandscape( int n, int seed )
+
+{
+  minstd_rand rng( seed );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  vector<float> verts;
+  float x = 0, y = 0;
+
+  for (int i=0; i<n; i++) {
+    verts.push_back( x );
+    verts.push_back( y );
+    if (in01( rng ) > 0.1)
+      x += in01( rng );
+    y += in01( rng ) - 0.5;
+  }
+
+  return new Landscape( &verts[0], n );
+}
+
+
+// ---------------- segment ----------------
+
+
+void benchSegment()
+
+{
+  int n = (count > 0 ? count : 100000);
+  int q = (steps > 0 ? steps : 1000000);
+
+  Landscape *landscape = randomLandscape( n, 1 );
+
+  cout << "segment: " << n << " vertices, " << q << " queries" << endl;
+
+  minstd_rand rng( 2 );
+  uniform_real_distribution<float> inX( -20, landscape->maxX() + 20 );
+
+  vector<vec3> queries( q );
+  for (int i=0; i<q; i++)
+    queries[i] = vec3( inX( rng ), 0, 0 );
+
+  long sum = 0;
+  double start = now();
+  for (int i=0; i<q; i++)
+    sum += landscape->findSegmentBelow( queries[i] );
+  double seconds = now() - start;
+
+  cout << "  index: " << seconds / q * 1e9 << " ns/query" << endl;
+
+  // The scan is slow, so only time a few queries
+
+  int qScan = q / 100 + 1;
+  int mismatches = 0;
+
+  start = now();
+  for (int i=0; i<qScan; i++)
+    if (landscape->findSegmentBelowByScan( queries[i] ) != landscape->findSegmentBelow( queries[i] ))
+      mismatches++;
+  seconds = now() - start;
+
+  cout << "  scan:  " << seconds / qScan * 1e9 << " ns/query, "
+       << mismatches << " of " << qScan << " differ from index (checksum " << sum << ")" << endl;
+
+  delete landscape;
+}
+
+
+// ---------------- closest ----------------
+
+
+// Random points over a landscape's bounds and up to 'above' metres
+// above it
+
+void randomQueries( Landscape *landscape, int q, float above, vector<vec3> &queries, int seed )
+
+{
+  minstd_rand rng( seed );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  float maxY = 0;
+  for (int i=0; i<=landscape->numSegments(); i++)
+    maxY = max( maxY, landscape->vertex( i ).y );
+
+  queries.resize( q );
+  for (int i=0; i<q; i++)
+    queries[i] = vec3( landscape->maxX() * in01( rng ), (maxY + above) * in01( rng ), 0 );
+}
+
+
+void benchClosest()
+
+{
+  int n = (count > 0 ? count : 100000);
+  int q = (steps > 0 ? steps : 1000000);
+
+  Landscape *landscape = randomLandscape( n, 1 );
+
+  cout << "closest: " << n << " vertices, " << q << " queries" << endl;
+
+  vector<vec3> queries;
+  randomQueries( landscape, q, 100, queries, 2 );
+
+  // Exact distances from the scalar scan, on as many queries as take
+  // about 1e7 segment tests
+
+  int qCheck = max( 1, min( q, (int) (1e7 / n) ) );
+  vector<float> exact( qCheck );
+
+  landscape->setClosestPointMethod( CLOSEST_SCAN );
+
+  double start = now();
+  for (int i=0; i<qCheck; i++)
+    exact[i] = (landscape->findClosestPoint( queries[i] ) - queries[i]).length();
+  double seconds = now() - start;
+
+  cout << "  scan:   " << seconds / qCheck * 1e9 << " ns/query" << endl;
+
+  struct { const char *name; ClosestPointMethod method; SimdKernel kernel; } methods[] = {
+    { "bvh:   ", CLOSEST_BVH,  SIMD_SCALAR },
+    { "sse2:  ", CLOSEST_SIMD, SIMD_SSE2 },
+    { "avx2:  ", CLOSEST_SIMD, SIMD_AVX2 },
+  };
+
+  for (int m=0; m<3; m++) {
+
+    landscape->setClosestPointMethod( methods[m].method, methods[m].kernel );
+    if (methods[m].method == CLOSEST_SIMD && landscape->getSimdKernel() != methods[m].kernel)
+      continue;			// not supported here
+
+    // Scans are slow on large landscapes, so use fewer queries
+
+    int qm = (methods[m].method == CLOSEST_SIMD ? max( qCheck, min( q, (int) (1e9 / n) ) ) : q);
+
+    float sum = 0;
+    start = now();
+    for (int i=0; i<qm; i++)
+      sum += landscape->findClosestPoint( queries[i] ).y;
+    seconds = now() - start;
+
+    int mismatches = 0;
+    for (int i=0; i<qCheck; i++) {
+      float d = (landscape->findClosestPoint( queries[i] ) - queries[i]).length();
+      if (fabs( d - exact[i] ) > 1e-4 * (1 + exact[i]))
+        mismatches++;
+    }
+
+    cout << "  " << methods[m].name << seconds / qm * 1e9 << " ns/query, "
+         << mismatches << " of " << qCheck << " distances differ from scan (checksum " << sum << ")" << endl;
+  }
+
+  delete landscape;
+}
+
+
+// ---------------- cursor ----------------
+
+
+void benchCursor()
+
+{
+  int n = (count > 0 ? count : 1000);
+  int q = (steps > 0 ? steps : 1000000);
+
+  Landscape *landscape = randomLandscape( n, 1 );
+
+  cout << "cursor: " << n << " vertices, " << q << " queries" << endl;
+
+  // A path that moves 0.5 m per step (30 m/s at 60 Hz) between 1 and
+  // 20 m above the terrain, with a jump to a random place every 1000
+  // steps, like a lander being reset
+
+  minstd_rand rng( 2 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  vector<vec3> queries( q );
+  float x = 0, dir = 1;
+
+  for (int i=0; i<q; i++) {
+    if (i % 1000 == 0)
+      x = landscape->maxX() * in01( rng );
+    x += 0.5 * dir;
+    if (x < 0 || x > landscape->maxX())
+      dir = -dir;
+    vec3 below = landscape->vertex( landscape->findSegmentBelow( vec3( x, 0, 0 ) ) );
+    queries[i] = vec3( x, below.y + 10.5 + 9.5 * sin( 0.01 * i ), 0 );
+  }
+
+  landscape->setClosestPointMethod( CLOSEST_AUTO );
+
+  for (int useCursor=0; useCursor<2; useCursor++) {
+
+    TerrainCursor cursor( landscape );
+    long  sumBelow = 0;
+    float sumClosest = 0;
+
+    double start = now();
+    for (int i=0; i<q; i++)
+      if (useCursor) {
+        sumBelow   += cursor.findSegmentBelow( queries[i] );
+        sumClosest += cursor.findClosestPoint( queries[i] ).y;
+      } else {
+        sumBelow   += landscape->findSegmentBelow( queries[i] );
+        sumClosest += landscape->findClosestPoint( queries[i] ).y;
+      }
+    double seconds = now() - start;
+
+    cout << (useCursor ? "  cursor: " : "  index:  ") << seconds / q * 1e9 << " ns/query";
+
+    if (useCursor) {
+
+      TerrainCursor check( landscape );
+      int mismatches = 0;
+
+      for (int i=0; i<q; i++) {
+        float d = (check.findClosestPoint( queries[i] ) - queries[i]).length();
+        float e = (landscape->findClosestPoint( queries[i] ) - queries[i]).length();
+        if (check.findSegmentBelow( queries[i] ) != landscape->findSegmentBelow( queries[i] ) ||
+            fabs( d - e ) > 1e-4 * (1 + e))
+          mismatches++;
+      }
+
+      cout << ", " << mismatches << " of " << q << " differ from index";
+    }
+
+    cout << " (checksums " << sumBelow << " " << sumClosest << ")" << endl;
+  }
+
+  delete landscape;
+}
+
+
+// ---------------- sdf ----------------
+
+
+void benchSdf()
+
+{
+  int q = (steps > 0 ? steps : 1000000);
+
+  Session    session;
+  Landscape *landscape = session.getLandscape();
+
+  cout << "sdf: game landscape, " << q << " queries" << endl;
+
+  DistanceField *field = NULL;
+
+  for (int threads=1; threads>=0; threads--) {
+    delete field;
+    double start = now();
+    field = new DistanceField( landscape, session.minX(), session.maxX(), session.minY(), session.maxY(),
+                               DF_CELL_SIZE, threads );
+    cout << "  build (" << (threads ? "1 thread" : "all cores") << "): " << now() - start << " s" << endl;
+  }
+
+  // Queries over the world, and a little beyond it
+
+  minstd_rand rng( 2 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  vector<vec3> queries( q );
+  for (int i=0; i<q; i++)
+    queries[i] = vec3( session.maxX() * (1.1 * in01( rng ) - 0.05), session.maxY() * (1.1 * in01( rng ) - 0.05), 0 );
+
+  float sum = 0;
+  double start = now();
+  for (int i=0; i<q; i++)
+    sum += field->distance( queries[i] );
+  double seconds = now() - start;
+
+  cout << "  lookup: " << seconds / q * 1e9 << " ns/query (checksum " << sum << ")" << endl;
+
+  sum = 0;
+  start = now();
+  for (int i=0; i<q; i++)
+    sum += (landscape->findClosestPoint( queries[i] ) - queries[i]).length();
+  seconds = now() - start;
+
+  cout << "  exact:  " << seconds / q * 1e9 << " ns/query (checksum " << sum << ")" << endl;
+
+  // The field should never overstate the distance by more than
+  // maxError(), and should be within maxError() inside the grid
+
+  float worstOver = 0, worstInside = 0;
+
+  for (int i=0; i<q; i++) {
+    float exact = (landscape->findClosestPoint( queries[i] ) - queries[i]).length();
+    float d = fabs( field->distance( queries[i] ) );
+    worstOver = max( worstOver, d - exact );
+    if (queries[i].x >= session.minX() && queries[i].x <= session.maxX() &&
+        queries[i].y >= session.minY() && queries[i].y <= session.maxY())
+      worstInside = max( worstInside, fabs( d - exact ) );
+  }
+
+  cout << "  error:  " << worstInside << " m inside the grid, overstated by at most "
+       << worstOver << " m (bound " << field->maxError() << " m)" << endl;
+
+  delete field;
+}
+
+
+// ---------------- cspace ----------------
+
+
+// Height of the landscape at 'x' (the highest point if there is a
+// vertical segment there), or -MAXFLOAT beyond its ends
+
+float landscapeHeight( Landscape *landscape, float x )
+
+{
+  int last = landscape->numSegments();
+
+  if (last < 1 || x < landscape->vertex( 0 ).x || x > landscape->vertex( last ).x)
+    return -MAXFLOAT;
+
+  float h = -MAXFLOAT;
+
+  for (int i=0; i<last; i++) {
+    vec3 a = landscape->vertex( i );
+    vec3 b = landscape->vertex( i+1 );
+    if (x >= a.x && x <= b.x)
+      h = fmax( h, (b.x > a.x ? a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x) : fmax( a.y, b.y )) );
+  }
+
+  return h;
+}
+
+
+// F(x) found directly from the lander vertices: the highest of the
+// landscape under each lander vertex, and each landscape vertex above
+// the bottom of the lander's hull.  The bottom of the hull at u is
+// the lowest chord between two vertices on either side of u.
+
+float outlineHeight( Landscape *landscape, const vector<float> &verts, float theta, float x )
+
+{
+  float c = cos( theta );
+  float s = sin( theta );
+  float best = -MAXFLOAT;
+
+  vector<vec3> p;
+  for (int i=0; verts[i] != -1; i+=2)
+    p.push_back( vec3( c * verts[i] - s * verts[i+1], s * verts[i] + c * verts[i+1], 0 ) );
+
+  for (unsigned int i=0; i<p.size(); i++)
+    best = fmax( best, landscapeHeight( landscape, x + p[i].x ) - p[i].y );
+
+  for (int k=0; k<=landscape->numSegments(); k++) {
+
+    vec3  v = landscape->vertex( k );
+    float u = v.x - x;
+    float bottom = MAXFLOAT;
+
+    for (unsigned int i=0; i<p.size(); i++)
+      for (unsigned int j=0; j<p.size(); j++)
+        if (p[i].x <= u && u <= p[j].x)
+          bottom = fmin( bottom, (p[j].x > p[i].x ? p[i].y + (p[j].y - p[i].y) * (u - p[i].x) / (p[j].x - p[i].x)
+                                                  : fmin( p[i].y, p[j].y )) );
+
+    if (bottom != MAXFLOAT)
+      best = fmax( best, v.y - bottom );
+  }
+
+  return best;
+}
+
+
+void benchCspace()
+
+{
+  int q = (steps > 0 ? steps : 1000000);
+  int n = (count > 0 ? count : CSPACE_ORIENTATIONS);
+
+  Session    session;
+  Landscape *landscape = session.getLandscape();
+  Lander    *lander    = session.getLander();
+
+  cout << "cspace: game landscape, " << n << " orientations, " << q << " queries" << endl;
+
+  double start = now();
+  ConfigObstacle obstacle( landscape, lander->getVertices(), n );
+  double seconds = now() - start;
+
+  int total = 0;
+  for (int k=0; k<n; k++)
+    total += obstacle.numVertices( k );
+
+  cout << "  build: " << seconds << " s, " << total / n << " vertices per orientation" << endl;
+
+  // Queries near the landscape, at the computed orientations
+
+  minstd_rand rng( 2 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  vector<vec3>  queries( q );
+  vector<float> thetas( q );
+
+  for (int i=0; i<q; i++) {
+    float x = (session.maxX() + 20) * in01( rng ) - 10;
+    float h = fmax( 0, landscapeHeight( landscape, fmin( fmax( x, 0 ), session.maxX() ) ) );
+    queries[i] = vec3( x, h + 20 * in01( rng ) - 5, 0 );
+    thetas[i]  = 2 * M_PI * (int) (n * in01( rng )) / n;
+  }
+
+  float sum = 0;
+  start = now();
+  for (int i=0; i<q; i++)
+    sum += fmin( obstacle.clearance( queries[i], thetas[i] ), 1000 ); // (infinite off the landscape)
+  seconds = now() - start;
+
+  cout << "  outline:  " << seconds / q * 1e9 << " ns/query (checksum " << sum << ")" << endl;
+
+  sum = 0;
+  start = now();
+  for (int i=0; i<q; i++)
+    sum += landscape->findLanderAltitude( landscape->findSegmentBelow( queries[i] ), queries[i], lander->getDimensions().y );
+  seconds = now() - start;
+
+  cout << "  altitude: " << seconds / q * 1e9 << " ns/query (checksum " << sum << ")" << endl;
+
+  // Check against the direct computation
+
+  int qCheck = min( q, 10000 );
+  int mismatches = 0;
+  int disagree = 0;
+  float worst = 0;
+
+  for (int i=0; i<qCheck; i++) {
+    float exact = outlineHeight( landscape, lander->getVertices(), thetas[i], queries[i].x );
+    float h = obstacle.height( queries[i].x, thetas[i] );
+    if (exact == -MAXFLOAT || h == -MAXFLOAT) {
+      if (exact != h)
+        mismatches++;
+      continue;
+    }
+    worst = max( worst, fabs( h - exact ) );
+    if (fabs( h - exact ) > 1e-3)
+      mismatches++;
+    if ((queries[i].y < h) != (queries[i].y < exact))
+      disagree++;
+  }
+
+  cout << "  " << mismatches << " of " << qCheck << " heights differ from direct check (worst "
+       << worst << " m), " << disagree << " collisions differ" << endl;
+}
+
+
+// ---------------- collide ----------------
+
+
+void benchCollide()
+
+{
+  int q = (steps > 0 ? steps : 100000);
+
+  Session    session;
+  Landscape *landscape = session.getLandscape();
+  const vector<float> &outline = session.getLander()->getVertices();
+
+  cout << "collide: game landscape, " << q << " queries" << endl;
+
+  // Lander poses near the landscape, with displacements of up to 10 m
+  // (e.g. 40 m/s over a 0.25 s step)
+
+  minstd_rand rng( 2 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  vector<vec3>  queries( q ), moves( q );
+  vector<float> thetas( q );
+
+  for (int i=0; i<q; i++) {
+    float x = session.maxX() * in01( rng );
+    float h = landscapeHeight( landscape, x );
+    queries[i] = vec3( x, h + 20 * in01( rng ) - 2, 0 );
+    moves[i]   = vec3( 20 * in01( rng ) - 10, 20 * in01( rng ) - 10, 0 );
+    thetas[i]  = 2 * in01( rng ) - 1;
+  }
+
+  int hits = 0;
+  double start = now();
+  for (int i=0; i<q; i++)
+    hits += outlineOverlaps( landscape, outline, queries[i], thetas[i] );
+  double seconds = now() - start;
+
+  cout << "  overlap: " << seconds / q * 1e9 << " ns/query, " << hits << " overlapping" << endl;
+
+  vector<float> fractions( q );
+
+  hits = 0;
+  start = now();
+  for (int i=0; i<q; i++) {
+    fractions[i] = 2;
+    hits += sweepOutline( landscape, outline, queries[i], thetas[i], moves[i], fractions[i] );
+  }
+  seconds = now() - start;
+
+  cout << "  sweep:   " << seconds / q * 1e9 << " ns/query, " << hits << " hit" << endl;
+
+  // The outline should be clear just before the contact, and clear
+  // at the end if there is no contact.  It should also overlap just
+  // after the contact, unless it only grazes the landscape.
+
+  int disagree = 0;
+  int grazes = 0;
+
+  for (int i=0; i<q; i++) {
+    if (outlineOverlaps( landscape, outline, queries[i], thetas[i] ))
+      continue;
+    float f = fractions[i];
+    float eps = 1e-2 / (moves[i].length() + 1e-6); // 1 cm
+    if (f > 1) {
+      if (outlineOverlaps( landscape, outline, queries[i] + moves[i], thetas[i] ))
+        disagree++;
+    } else if (f > eps && outlineOverlaps( landscape, outline, queries[i] + (f - eps) * moves[i], thetas[i] ))
+      disagree++;
+    else if (!outlineOverlaps( landscape, outline, queries[i] + min( f + eps, 1.0f ) * moves[i], thetas[i] ))
+      grazes++;
+  }
+
+  cout << "  " << disagree << " sweeps disagree with the overlap test, " << grazes << " graze" << endl;
+}
+
+
+// ---------------- coast ----------------
+
+
+void benchCoast()
+
+{
+  int   n  = (count > 0 ? count : 1000);
+  float dt = 1 / 60.0;
+
+  Landscape landscape;
+
+  cout << "coast: " << n << " free-fall episodes" << endl;
+
+  // Random starts over the game landscape, with the lander tilted
+
+  minstd_rand rng( 2 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  struct Start { vec3 pos, vel; float orient; };
+  vector<Start> starts( n );
+
+  Session probe( &landscape );
+
+  for (int i=0; i<n; i++) {
+    starts[i].pos    = vec3( probe.maxX() * in01( rng ), probe.maxY() * (0.5 + 0.5 * in01( rng )), 0 );
+    starts[i].vel    = vec3( 60 * in01( rng ) - 30, 20 * in01( rng ) - 10, 0 );
+    starts[i].orient = 0.2 * in01( rng ) - 0.1;
+  }
+
+  struct End { float time, x, y; int loss; bool won; };
+  vector<End> ends[2];
+
+  for (int useCoast=0; useCoast<2; useCoast++) {
+
+    Session       session( &landscape );
+    ScriptedInput noInput;
+    long          steps = 0;
+
+    ends[useCoast].resize( n );
+
+    double start = now();
+
+    for (int i=0; i<n; i++) {
+
+      session.HardReset();
+      session.getLander()->place( starts[i].pos, starts[i].vel, starts[i].orient );
+      noInput.restart();
+
+      while (session.running() && session.getTime() < 300) {
+        if (useCoast) {
+          int skipped = session.coast( dt, noInput.idleSteps( session, dt ) );
+          noInput.skip( skipped, dt );
+        }
+        session.update( noInput, dt );
+        steps++;
+      }
+
+      End &e = ends[useCoast][i];
+      e.time = session.getTime();
+      e.x    = session.getLander()->centrePosition().x;
+      e.y    = session.getLander()->centrePosition().y;
+      e.loss = session.getLossReason();
+      e.won  = session.won();
+    }
+
+    double seconds = now() - start;
+
+    cout << (useCoast ? "  coast: " : "  step:  ") << seconds / n * 1e6 << " us/episode, "
+         << steps / (double) n << " steps computed per episode" << endl;
+  }
+
+  // Stepping adds up rounding errors (about 0.05 m in x over 1000
+  // steps at x = 500), which coasting does not, so an episode that
+  // only just touches may end a step earlier or later.  Likewise the
+  // lander may wrap around a step earlier or later, which moves it by
+  // up to one step's travel.
+
+  int outcomes = 0, late = 0;
+  float worst = 0;
+
+  for (int i=0; i<n; i++) {
+    End &a = ends[0][i];
+    End &b = ends[1][i];
+    if (a.loss != b.loss || a.won != b.won)
+      outcomes++;
+    if (fabs( a.time - b.time ) > 0.5 * dt)
+      late++;
+    else
+      worst = max( worst, max( fabs( a.x - b.x ), fabs( a.y - b.y ) ) );
+  }
+
+  cout << "  " << outcomes << " of " << n << " outcomes differ, " << late << " end on a different step, "
+       << "others end within " << worst << " m" << endl;
+}
+
+
+// ---------------- integrate ----------------
+
+
+// Each episode holds random controls for a second at a time.  The
+// steps tested all divide a second, so every integrator sees the same
+// controls.
+
+#define EPISODE_SECONDS 8
+#define REFERENCE_STEPS 3840	// reference steps per second
+
+struct Episode {
+  vec3     pos, vel;
+  float    orient;
+  Controls controls[EPISODE_SECONDS];
+};
+
+
+// The end of an episode with RK4 in double precision and tiny steps
+
+void referenceEnd( Episode &e, vec3 &pos, vec3 &vel )
+
+{
+  double px = e.pos.x, py = e.pos.y;
+  double vx = e.vel.x, vy = e.vel.y;
+  double o  = e.orient;
+  double h  = 1.0 / REFERENCE_STEPS;
+
+  for (int s=0; s<EPISODE_SECONDS; s++) {
+
+    Controls c = e.controls[s];
+    double w = ((c & CONTROL_ROTATE_CCW) ? ROTATION_SPEED : 0) - ((c & CONTROL_ROTATE_CW) ? ROTATION_SPEED : 0);
+    double thrust = ((c & CONTROL_THRUST) ? THRUST_ACCEL : 0);
+
+    for (int j=0; j<REFERENCE_STEPS; j++) {
+      double o0 = o + w * j * h;
+      double o1 = o + w * (j+1) * h;
+      RK4::advance< ScalarOps<double> >( px, py, vx, vy, o0, o1, thrust, thrust != 0, h );
+    }
+
+    o += w;
+  }
+
+  pos = vec3( px, py, 0 );
+  vel = vec3( vx, vy, 0 );
+}
+
+
+struct IntegratorResult {
+  const char *name;
+  vector<float> posError;	// max over the episodes, for each step
+  vector<float> velError;
+  float stepsPerSecond;		// lander-steps/s with the best kernel
+};
+
+
+template <class Integrator>
+IntegratorResult benchIntegrator( vector<Episode> &episodes, vector<vec3> &refPos, vector<vec3> &refVel,
+                                  vector<int> &stepsPerSecond, float maxX, float maxY )
+
+{
+  IntegratorResult r;
+  r.name = Integrator::name();
+
+  // Accuracy with Lander::step()
+
+  Lander lander( maxX, maxY );
+
+  for (unsigned int k=0; k<stepsPerSecond.size(); k++) {
+
+    int   m  = stepsPerSecond[k];
+    float dt = 1.0f / m;
+    float maxPos = 0, maxVel = 0;
+
+    for (unsigned int i=0; i<episodes.size(); i++) {
+
+      Episode &e = episodes[i];
+      lander.place( e.pos, e.vel, e.orient );
+      lander.resetFuel();
+
+      for (int s=0; s<EPISODE_SECONDS; s++)
+        for (int j=0; j<m; j++)
+          lander.step<Integrator>( e.controls[s], dt );
+
+      maxPos = max( maxPos, (lander.centrePosition() - refPos[i]).length() );
+      maxVel = max( maxVel, (lander.getVelocity() - refVel[i]).length() );
+    }
+
+    r.posError.push_back( maxPos );
+    r.velError.push_back( maxVel );
+  }
+
+  // Throughput with LanderBatch, for each kernel
+
+  int   n  = (count > 0 ? count : 100000);
+  int   s  = (steps > 0 ? steps : 200);
+  float dt = 1/60.0;
+
+  minstd_rand rng( 1 );
+  SimdKernel kernels[] = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+  cout << "  " << r.name << ":";
+
+  for (int k=0; k<3; k++) {
+
+    LanderBatch batch( n, maxX, maxY );
+
+    batch.setKernel( kernels[k] );
+    if (batch.getKernel() != kernels[k])
+      continue;			// not supported here
+
+    for (int i=0; i<n; i++)
+      batch.setControls( i, rng() % 8 );
+
+    double start = now();
+    for (int j=0; j<s; j++)
+      batch.step<Integrator>( dt );
+    double seconds = now() - start;
+
+    r.stepsPerSecond = n * (double) s / seconds;
+    cout << " " << simdKernelName( kernels[k] ) << " " << r.stepsPerSecond / 1e6;
+  }
+
+  // Difference of the best kernel from Lander::step()
+
+  int m = 64;
+  LanderBatch batch( m, maxX, maxY );
+  vector<Lander *> landers;
+
+  for (int i=0; i<m; i++)
+    landers.push_back( new Lander( maxX, maxY ) );
+
+  float maxPosDiff = 0;
+
+  for (int j=0; j<600; j++) {
+
+    for (int i=0; i<m; i++) {
+      Controls c = rng() % 8;
+      batch.setControls( i, c );
+      landers[i]->step<Integrator>( c, dt );
+    }
+
+    batch.step<Integrator>( dt );
+
+    for (int i=0; i<m; i++)
+      maxPosDiff = max( maxPosDiff, (batch.centrePosition( i ) - landers[i]->centrePosition()).length() );
+  }
+
+  cout << " M lander-steps/s; " << simdKernelName( batch.getKernel() ) << " vs Lander after 600 steps: "
+       << maxPosDiff << " m" << endl;
+
+  for (int i=0; i<m; i++)
+    delete landers[i];
+
+  return r;
+}
+
+
+void benchIntegrate()
+
+{
+  Session session;
+
+  int n = 200;
+
+  minstd_rand rng( 1 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  // Episodes start mid-air with random velocities, well away from the
+  // world edges so that the landers do not wrap around
+
+  vector<Episode> episodes( n );
+  vector<vec3> refPos( n ), refVel( n );
+
+  for (int i=0; i<n; i++) {
+    Episode &e = episodes[i];
+    e.pos    = vec3( 0.5 * session.maxX(), 0.5 * session.maxY(), 0 );
+    e.vel    = vec3( 20 * (2*in01( rng ) - 1), 20 * (2*in01( rng ) - 1), 0 );
+    e.orient = 0.5 * (2*in01( rng ) - 1);
+    for (int s=0; s<EPISODE_SECONDS; s++)
+      e.controls[s] = rng() % 8;
+    referenceEnd( e, refPos[i], refVel[i] );
+  }
+
+  int perSecond[] = { 15, 30, 60, 120, 240 };
+  vector<int> stepsPerSecond( perSecond, perSecond + sizeof(perSecond)/sizeof(perSecond[0]) );
+
+  cout << "integrate: " << n << " episodes of " << EPISODE_SECONDS << " s with random controls held for 1 s" << endl;
+
+  vector<IntegratorResult> results;
+
+  results.push_back( benchIntegrator<ExplicitEuler>( episodes, refPos, refVel, stepsPerSecond, session.maxX(), session.maxY() ) );
+  results.push_back( benchIntegrator<SemiImplicitEuler>( episodes, refPos, refVel, stepsPerSecond, session.maxX(), session.maxY() ) );
+  results.push_back( benchIntegrator<Verlet>( episodes, refPos, refVel, stepsPerSecond, session.maxX(), session.maxY() ) );
+  results.push_back( benchIntegrator<RK4>( episodes, refPos, refVel, stepsPerSecond, session.maxX(), session.maxY() ) );
+
+  // Errors against the reference at the end of the episodes.  With
+  // short steps, the float rounding of the position and orientation
+  // adds up over more steps, so the errors of Verlet and RK4 (a few
+  // cm at 1/60 s) grow as the step shrinks.
+
+  cout << "  max position error (m) / max velocity error (m/s) at each step:" << endl;
+
+  for (unsigned int r=0; r<results.size(); r++) {
+    cout << "    " << results[r].name << ":";
+    for (unsigned int k=0; k<stepsPerSecond.size(); k++)
+      cout << "  1/" << stepsPerSecond[k] << " " << results[r].posError[k] << " / " << results[r].velError[k];
+    cout << endl;
+  }
+
+  // The cheapest way to stay within TOUCHDOWN_ALTITUDE: the longest
+  // step with a small enough position error, and the time to simulate
+  // a second of flight with it
+
+  cout << "  longest step within " << TOUCHDOWN_ALTITUDE << " m, and lander-seconds/s with it:" << endl;
+
+  for (unsigned int r=0; r<results.size(); r++) {
+    unsigned int k;
+    for (k=0; k<stepsPerSecond.size(); k++)
+      if (results[r].posError[k] < TOUCHDOWN_ALTITUDE)
+        break;
+    cout << "    " << results[r].name << ": ";
+    if (k == stepsPerSecond.size())
+      cout << "none tested" << endl;
+    else
+      cout << "1/" << stepsPerSecond[k] << " s, " << results[r].stepsPerSecond / stepsPerSecond[k] / 1e6 << " M" << endl;
+  }
+}
+
+
+// ---------------- rewind ----------------
+
+
+bool sameState( const SessionState &a, const SessionState &b )
+
+{
+  return a.position.x == b.position.x && a.position.y == b.position.y &&
+         a.velocity.x == b.velocity.x && a.velocity.y == b.velocity.y &&
+         a.orientation == b.orientation && a.fuel == b.fuel && a.time == b.time &&
+         a.score == b.score && a.startFuel == b.startFuel &&
+         a.running == b.running && a.win == b.win && a.lossReason == b.lossReason;
+}
+
+
+void benchRewind()
+
+{
+  int   n  = (count > 0 ? count : 10000);	// seeks
+  int   s  = (steps > 0 ? steps : 20000);	// steps of the game
+  float dt = 1/60.0;
+
+  Session session;
+  minstd_rand rng( 3 );
+
+  // A small budget, so that the rings wrap around
+
+  RewindBuffer rewind( dt, 32 * 1024 );
+
+  cout << "rewind: " << s << " steps, " << n << " seeks, " << rewind.bytes() << " bytes" << endl;
+
+  // Random controls held for a few steps, starting a new game after
+  // each landing or crash, and the state after each step.  Half way,
+  // go back 1000 steps and play differently from there.
+
+  vector<SessionState> states;
+  Controls c = CONTROL_NONE;
+
+  states.push_back( session.getState() );
+
+  for (int j=0; j<s; j++) {
+
+    if (j == s/2) {
+      rewind.seek( session, j - 1000 );
+      states.resize( j - 1000 + 1 );
+    }
+
+    if (rng() % 8 == 0) {
+      Controls choices[] = { CONTROL_NONE, CONTROL_THRUST, CONTROL_THRUST | CONTROL_ROTATE_CW, CONTROL_THRUST | CONTROL_ROTATE_CCW };
+      c = choices[rng() % 4];
+    }
+
+    Controls stepControls = (session.running() ? c : CONTROL_NEW_GAME);
+
+    rewind.record( session, stepControls );
+    session.step( stepControls, dt );
+    states.push_back( session.getState() );
+  }
+
+  // Seek to random steps that are kept, and back to the end
+
+  long first = rewind.oldest(), last = rewind.newest();
+  int  same = 0;
+  double maxSeconds = 0, start = now();
+
+  for (int i=0; i<n; i++) {
+
+    long target = first + rng() % (last - first + 1);
+
+    double t0 = now();
+    long got = rewind.seek( session, target );
+    double seconds = now() - t0;
+    if (seconds > maxSeconds) maxSeconds = seconds;
+
+    if (got == target && sameState( session.getState(), states[got] ))
+      same++;
+  }
+
+  double seconds = now() - start;
+
+  rewind.seek( session, last );
+  if (sameState( session.getState(), states[last] ))
+    same++;
+
+  cout << "  steps " << first << " to " << last << " kept (" << (last - first) * dt << " s)" << endl
+       << "  " << same << " of " << n+1 << " seeks restored the exact state" << endl
+       << "  seek: mean " << seconds / n * 1e6 << " us, max " << maxSeconds * 1e6 << " us" << endl;
+}
+
+
+// ---------------- env ----------------
+
+
+void benchEnv()
+
+{
+  int n = (count > 0 ? count : 4096);
+  int s = (steps > 0 ? steps : 2000);
+
+  Landscape landscape;
+
+  // Random actions, changing every few steps as a policy's might
+
+  minstd_rand rng( 4 );
+  vector<Controls> actions( 16 * n );
+
+  for (unsigned int i=0; i<actions.size(); i++)
+    actions[i] = rng() % 8;
+
+  cout << "env: " << n << " environments, " << s << " steps" << endl;
+
+  int threadCounts[] = { 1, 0 };
+  uint64_t hashes[2];
+
+  for (int t=0; t<2; t++) {
+
+    VecEnv env( n, 1/60.0, threadCounts[t], &landscape );
+
+    env.reset( 1 );
+
+    long allocated = allocations;
+    long episodes  = 0;
+    double start = now();
+
+    for (int j=0; j<s; j++) {
+      env.step( &actions[(j / 8 % 16) * n] );
+      for (int i=0; i<n; i++)
+        episodes += (env.terminations()[i] || env.truncations()[i]);
+    }
+
+    double seconds = now() - start;
+    allocated = allocations - allocated;
+
+    // Hash the last observations, rewards and ends
+
+    uint64_t h = 14695981039346656037ULL;
+    const unsigned char *bytes[3] = { (const unsigned char *) env.observations(), (const unsigned char *) env.rewards(), env.terminations() };
+    size_t sizes[3] = { n * ENV_OBS_SIZE * sizeof(float), n * sizeof(float), (size_t) n };
+    for (int b=0; b<3; b++)
+      for (size_t k=0; k<sizes[b]; k++) {
+        h ^= bytes[b][k];
+        h *= 1099511628211ULL;
+      }
+    hashes[t] = h;
+
+    cout << "  " << env.threads() << " thread" << (env.threads() > 1 ? "s" : "") << ": "
+         << n * (double) s / seconds / 1e6 << " M env-steps/s, " << episodes << " episodes ended, "
+         << allocated / (double) s << " allocations per step" << endl;
+  }
+
+  cout << "  results are " << (hashes[0] == hashes[1] ? "the same" : "DIFFERENT") << " with one thread and with one per core" << endl;
+}
+
+
+// ---------------- shm ----------------
+
+
+// The controller process: thrust while falling faster than 2 m/s
+
+void shmAgent( const char *name )
+
+{
+  ShmAgent agent;
+
+  while (!agent.attach( name ))
+    usleep( 1000 );
+
+  const ShmObservation *obs;
+
+  while ((obs = agent.next()) != NULL) {
+    for (int i=0; i<agent.size(); i++)
+      agent.setAction( i, obs[i].vy < -2 ? CONTROL_THRUST : CONTROL_NONE );
+    agent.answer();
+  }
+
+  _exit(0);
+}
+
+
+void benchShm()
+
+{
+  int n = (count > 0 ? count : 4096);
+  int s = (steps > 0 ? steps : 2000);
+
+  const char *name = "/llbench_shm";
+  Landscape   landscape;
+
+  cout << "shm: " << n << " environments, " << s << " lockstep steps" << endl;
+
+  int threadCounts[] = { 1, 0 };
+  uint64_t hashes[2];
+
+  for (int t=0; t<2; t++) {
+
+    cout.flush();
+
+    pid_t child = fork();
+    if (child == 0)
+      shmAgent( name );
+
+    uint64_t h = 14695981039346656037ULL;
+    {
+      ShmEnv env( n, 1/60.0, true, threadCounts[t], &landscape );
+
+      if (!env.create( name, 1 )) {
+        cout << "  could not make the shared memory region" << endl;
+        kill( child, SIGKILL );
+        waitpid( child, NULL, 0 );
+        return;
+      }
+
+      double start = now();
+
+      for (int j=0; j<s; j++)
+        env.step();
+
+      double seconds = now() - start;
+
+      // Hash the final states
+
+      for (int i=0; i<n; i++) {
+        SessionState st = env.session( i )->getState();
+        float f[6] = { st.position.x, st.position.y, st.velocity.x, st.velocity.y, st.orientation, (float) st.fuel };
+        const unsigned char *b = (const unsigned char *) f;
+        for (unsigned int k=0; k<sizeof(f); k++) {
+          h ^= b[k];
+          h *= 1099511628211ULL;
+        }
+      }
+
+      cout << "  " << env.threads() << " thread" << (env.threads() > 1 ? "s" : "") << ": "
+           << s / seconds << " steps/s, " << seconds / s * 1e6 << " us per step and round trip, "
+           << n * (double) s / seconds / 1e6 << " M env-steps/s" << endl;
+    }
+    hashes[t] = h;
+
+    waitpid( child, NULL, 0 );
+  }
+
+  cout << "  results are " << (hashes[0] == hashes[1] ? "the same" : "DIFFERENT") << " with one thread and with one per core" << endl;
+}
+
+
+// ---------------- mpc ----------------
+
+
+void benchMpc()
+
+{
+  int   n  = (count > 0 ? count : 256);
+  int   s  = (steps > 0 ? steps : 18000);	// 300 s, as llsim allows an episode
+  float dt = 1/60.0;
+
+  Landscape landscape;
+  vector<Session *>      sessions;
+  vector<MpcAutopilot *> pilots;
+
+  // Starts spread across the world, with random horizontal speeds
+
+  minstd_rand rng( 5 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  for (int i=0; i<n; i++) {
+    Session *session = new Session( &landscape );
+    session->getLander()->place( vec3( (0.05 + 0.9 * (i + 0.5) / n) * session->maxX(), 0.7 * session->maxY(), 0 ),
+                                 vec3( 60 * in01( rng ) - 30, 0, 0 ), 0 );
+    sessions.push_back( session );
+  }
+
+  MpcTerrain terrain( &landscape, sessions[0]->getLander()->getDimensions() );
+
+  for (int i=0; i<n; i++) {
+    pilots.push_back( new MpcAutopilot( &terrain ) );
+    pilots[i]->restart( i + 1 );
+  }
+
+  cout << "mpc: " << n << " landers, up to " << s << " steps, budget " << MPC_BUDGET_US << " us per lander-step" << endl;
+
+  // Fly until every lander has landed or crashed, or for 's' steps
+
+  double total = 0, worstCall = 0, worstTick = 0;
+  long   calls = 0;
+  int    ticks = 0;
+
+  for (; ticks<s; ticks++) {
+
+    double tick = 0;
+    bool   flying = false;
+
+    for (int i=0; i<n; i++) {
+      if (!sessions[i]->running())
+        continue;
+      double start = now();
+      Controls c = pilots[i]->controls( *sessions[i], dt );
+      double t = now() - start;
+      sessions[i]->step( c, dt );
+      tick += t;
+      worstCall = max( worstCall, t );
+      calls++;
+      flying = true;
+    }
+
+    if (!flying)
+      break;
+
+    total += tick;
+    worstTick = max( worstTick, tick );
+  }
+
+  int  landed = 0, crashed = 0;
+  long iterations = 0, pilotSteps = 0;
+
+  for (int i=0; i<n; i++) {
+    if (!sessions[i]->running())
+      (sessions[i]->won() ? landed : crashed)++;
+    iterations += pilots[i]->iterations;
+    pilotSteps += pilots[i]->steps;
+    delete pilots[i];
+    delete sessions[i];
+  }
+
+  cout << "  " << total / max( 1L, calls ) * 1e6 << " us per lander-step (max " << worstCall * 1e6 << " us), "
+       << iterations / (double) max( 1L, pilotSteps ) << " plans tried per step" << endl
+       << "  " << total / max( 1, ticks ) * 1e3 << " ms per tick (max " << worstTick * 1e3 << " ms, frame is " << dt * 1e3 << " ms)" << endl
+       << "  after " << ticks * dt << " s: " << landed << " landed, " << crashed << " crashed, " << n - landed - crashed << " flying" << endl;
+}
+
+
+// ---------------- policy ----------------
+
+
+#define BENCH_POLICY_RES    0.2	// resolution of the table built
+#define BENCH_POLICY_SWEEPS 4
+
+
+void benchPolicy()
+
+{
+  int   n  = (count > 0 ? count : 256);
+  int   s  = (steps > 0 ? steps : 600);
+  float dt = 1/60.0;
+
+  Landscape  landscape;
+  Session    probe( &landscape );
+  MpcTerrain terrain( &landscape, probe.getLander()->getDimensions() );
+
+  if (terrain.pads.empty()) {
+    cout << "policy: no pads" << endl;
+    return;
+  }
+
+  // A few sweeps for one pad, with one thread and with one per core
+
+  int threadCounts[] = { 1, 0 };
+  PolicyBuilder *builders[2];
+
+  for (int t=0; t<2; t++) {
+
+    ThreadPool pool( threadCounts[t] );
+
+    builders[t] = new PolicyBuilder( &terrain, BENCH_POLICY_RES );
+
+    if (t == 0)
+      cout << "policy: " << builders[t]->cells() << " cells, " << BENCH_POLICY_SWEEPS << " sweeps" << endl;
+
+    double start = now();
+    int sweeps = builders[t]->solve( 0, pool, BENCH_POLICY_SWEEPS, 0 );
+    double seconds = now() - start;
+
+    cout << "  " << pool.size() << " thread" << (pool.size() > 1 ? "s" : "") << ": "
+         << builders[t]->cells() * (double) sweeps / seconds / 1e6 << " M cell-updates/s" << endl;
+  }
+
+  cout << "  tables are " << (builders[0]->tables[0] == builders[1]->tables[0] ? "the same" : "DIFFERENT")
+       << " with one thread and with one per core" << endl;
+
+  // Fly with the table (a coarse one, so this times the controller
+  // rather than testing its landings)
+
+  char path[] = "/tmp/llbenchXXXXXX";
+  int fd = mkstemp( path );
+
+  if (fd < 0) {
+    cout << "  could not make a temporary file" << endl;
+    return;
+  }
+  close( fd );
+
+  PolicyTable table;
+  bool ok = builders[0]->write( path, &landscape ) && table.open( path, &landscape );
+
+  unlink( path );
+  delete builders[0];
+  delete builders[1];
+
+  if (!ok)
+    return;
+
+  vector<Session *>          sessions;
+  vector<PolicyController *> pilots;
+  minstd_rand rng( 5 );
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  for (int i=0; i<n; i++) {
+    Session *session = new Session( &landscape );
+    session->getLander()->place( vec3( (0.05 + 0.9 * (i + 0.5) / n) * session->maxX(), 0.7 * session->maxY(), 0 ),
+                                 vec3( 60 * in01( rng ) - 30, 0, 0 ), 0 );
+    sessions.push_back( session );
+    pilots.push_back( new PolicyController( &table, &terrain ) );
+  }
+
+  double total = 0, worstTick = 0;
+  long   calls = 0;
+
+  for (int j=0; j<s; j++) {
+
+    double tick = 0;
+
+    for (int i=0; i<n; i++) {
+      if (!sessions[i]->running())
+        continue;
+      double start = now();
+      Controls c = pilots[i]->controls( *sessions[i], dt );
+      tick += now() - start;
+      sessions[i]->step( c, dt );
+      calls++;
+    }
+
+    total += tick;
+    worstTick = max( worstTick, tick );
+  }
+
+  for (int i=0; i<n; i++) {
+    delete pilots[i];
+    delete sessions[i];
+  }
+
+  cout << "  " << total / max( 1L, calls ) * 1e6 << " us per lander-step, "
+       << total / s * 1e3 << " ms per tick for " << n << " landers (max " << worstTick * 1e3 << " ms)" << endl;
+}
+
+
+// ---------------- mlp ----------------
+
+
+#define BENCH_MLP_CALIBRATION 4096 // observations for quantizing and checking
+#define BENCH_MLP_MIN_TIME    0.02 // least time per measurement (s)
+
+
+// Time per call of 'batch.evaluate()'
+
+double timeEvaluate( MlpBatch &batch )
+
+{
+  int    reps = 0;
+  double start = now(), t;
+
+  do {
+    batch.evaluate();
+    reps++;
+  } while ((t = now() - start) < BENCH_MLP_MIN_TIME);
+
+  return t / reps;
+}
+
+
+void benchMlp()
+
+{
+  int   n  = (count > 0 ? count : 1024);
+  int   s  = (steps > 0 ? steps : 600);
+  float dt = 1/60.0;
+
+  MlpPolicy policy;
+
+  cout << "mlp: layers";
+  for (int l=0; l<=policy.numLayers(); l++)
+    cout << (l > 0 ? "-" : " ") << policy.width( l );
+  cout << ", " << policy.numWeights() << " weights (random)" << endl;
+
+  // Observations from a few seconds of random play, to calibrate the
+  // int8 form and to compare the kernels
+
+  int m = BENCH_MLP_CALIBRATION;
+  VecEnv env( m, dt, 1 );
+  vector<Controls> random( m );
+  minstd_rand rng( 3 );
+
+  env.reset( 1 );
+  for (int j=0; j<300; j++) {
+    for (int i=0; i<m; i++)
+      random[i] = rng() % MLP_ACTIONS;
+    env.step( &random[0] );
+  }
+
+  policy.quantize( env.observations(), m );
+
+  MlpBatch reference( &policy, m );
+  reference.setKernel( SIMD_SCALAR );
+
+  for (int i=0; i<m; i++)
+    reference.setObservation( i, env.observations() + i * ENV_OBS_SIZE );
+  reference.evaluate();
+
+  float range = 0;		// of the reference outputs
+  for (int i=0; i<m; i++)
+    for (int k=0; k<MLP_ACTIONS; k++)
+      range = max( range, fabsf( reference.output( i, k ) ) );
+
+  SimdKernel   kernels[]    = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+  MlpPrecision precisions[] = { MLP_FP32, MLP_INT8 };
+  const char  *precisionNames[] = { "fp32", "int8" };
+
+  for (int p=0; p<2; p++)
+    for (int k=0; k<3; k++) {
+
+      if (p == 0 && k == 0)
+        continue;		// the reference
+
+      MlpBatch batch( &policy, m, precisions[p] );
+      batch.setKernel( kernels[k] );
+      if (batch.getKernel() != kernels[k])
+        continue;		// not supported here
+
+      for (int i=0; i<m; i++)
+        batch.setObservation( i, env.observations() + i * ENV_OBS_SIZE );
+      batch.evaluate();
+
+      int   same = 0;
+      float maxDiff = 0;
+
+      for (int i=0; i<m; i++) {
+        if (batch.action( i ) == reference.action( i ))
+          same++;
+        for (int a=0; a<MLP_ACTIONS; a++)
+          maxDiff = max( maxDiff, fabsf( batch.output( i, a ) - reference.output( i, a ) ) );
+      }
+
+      cout << "  " << simdKernelName( kernels[k] ) << " " << precisionNames[p] << ": same action as scalar fp32 for "
+           << same << " of " << m << ", max output difference " << maxDiff << " (outputs up to " << range << ")" << endl;
+    }
+
+  // Time per batch at each size
+
+  int sizes[] = { 1, 16, 64, 256, 1024, 4096, 16384, 65536 };
+
+  for (unsigned int z=0; z<sizeof(sizes)/sizeof(sizes[0]); z++) {
+
+    int    size = sizes[z];
+    double best = 1e30;
+
+    cout << "  " << size << " lander" << (size > 1 ? "s" : "") << ":";
+
+    for (int p=0; p<2; p++)
+      for (int k=0; k<3; k++) {
+
+        MlpBatch batch( &policy, size, precisions[p] );
+        batch.setKernel( kernels[k] );
+        if (batch.getKernel() != kernels[k])
+          continue;
+
+        for (int i=0; i<size; i++)
+          batch.setObservation( i, env.observations() + (i % m) * ENV_OBS_SIZE );
+
+        double t = timeEvaluate( batch );
+        best = min( best, t );
+
+        cout << " " << simdKernelName( kernels[k] ) << " " << precisionNames[p] << " " << t * 1e6 << " us,";
+      }
+
+    cout << " best " << best / size * 1e9 << " ns per lander, " << best / dt * 100 << "% of a frame" << endl;
+  }
+
+  // Sessions flown by a population, one evaluation per tick
+
+  for (int p=0; p<2; p++) {
+
+    Landscape landscape;
+    vector<Session *> sessions;
+    vector<InputSource *> inputs;
+    MlpPopulation population( &policy, precisions[p] );
+
+    for (int i=0; i<n; i++) {
+      Session *session = new Session( &landscape );
+      minstd_rand start( i + 1 );
+      VecEnv::randomStart( *session, start );
+      sessions.push_back( session );
+      inputs.push_back( population.add( session ) );
+    }
+
+    population.tick();		// (sizes the batch)
+
+    double tickTime = 0, stepTime = 0, worstTick = 0;
+    long   before = allocations;
+
+    for (int j=0; j<s; j++) {
+
+      double start = now();
+      population.tick();
+      double t = now() - start;
+
+      tickTime += t;
+      worstTick = max( worstTick, t );
+
+      start = now();
+      for (int i=0; i<n; i++)
+        if (sessions[i]->running())
+          sessions[i]->update( *inputs[i], dt );
+      stepTime += now() - start;
+    }
+
+    long allocated = allocations - before;
+
+    for (int i=0; i<n; i++)
+      delete sessions[i];
+
+    cout << "  population of " << n << " (" << precisionNames[p] << ", " << simdKernelName( population.getBatch().getKernel() ) << "): "
+         << tickTime / s * 1e3 << " ms per tick (max " << worstTick * 1e3 << " ms) to observe and evaluate, "
+         << stepTime / s * 1e3 << " ms to step the sessions, frame is " << dt * 1e3 << " ms; "
+         << allocated << " heap allocations in " << s << " ticks" << endl;
+  }
+}
+
+
+// ---------------- fixed ----------------
+
+
+void benchFixed()
+
+{
+  Session session;
+
+  int n = (count > 0 ? count : 100000);
+  int s = (steps > 0 ? steps : 1000);
+
+  cout << "fixed: " << n << " landers, " << s << " steps" << endl;
+
+  // Throughput for each kernel, and the state after 600 steps of
+  // changing controls, which must be the same bits for all
+
+  SimdKernel kernels[] = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+  uint64_t   hashes[3] = { 0, 0, 0 };
+
+  for (int k=0; k<3; k++) {
+
+    FixedLanderBatch batch( n, session.maxX(), session.maxY() );
+
+    batch.setKernel( kernels[k] );
+    if (batch.getKernel() != kernels[k])
+      continue;			// not supported here
+
+    minstd_rand rng( 1 );
+
+    for (int i=0; i<n; i++)
+      batch.setControls( i, rng() % 8 );
+
+    double start = now();
+    for (int j=0; j<s; j++)
+      batch.step();
+    double seconds = now() - start;
+
+    int m = 1000;
+    FixedLanderBatch check( m, session.maxX(), session.maxY() );
+    check.setKernel( kernels[k] );
+
+    for (int j=0; j<600; j++) {
+      for (int i=0; i<m; i++)
+        check.setControls( i, rng() % 8 );
+      check.step();
+    }
+
+    hashes[k] = check.stateHash();
+
+    cout << "  " << simdKernelName( kernels[k] ) << ": "
+         << n * (double) s / seconds / 1e6 << " M lander-steps/s, state hash " << hex << hashes[k] << dec << endl;
+  }
+
+  bool same = true;
+  for (int k=1; k<3; k++)
+    if (hashes[k] != 0 && hashes[k] != hashes[0])
+      same = false;
+
+  cout << "  kernels give " << (same ? "the same bits" : "DIFFERENT BITS") << endl;
+
+  // Difference from LanderBatch over changing controls, at the same step
+
+  int m = 64;
+  FixedLanderBatch fixedBatch( m, session.maxX(), session.maxY() );
+  LanderBatch      batch( m, session.maxX(), session.maxY() );
+  minstd_rand      rng( 2 );
+
+  float maxPosDiff = 0, maxVelDiff = 0, maxOrientDiff = 0;
+
+  for (int j=0; j<600; j++) {
+
+    for (int i=0; i<m; i++) {
+      Controls c = rng() % 8;
+      batch.setControls( i, c );
+      fixedBatch.setControls( i, c );
+    }
+
+    batch.step( FIXED_DT );
+    fixedBatch.step();
+
+    for (int i=0; i<m; i++) {
+      float dp = (batch.centrePosition( i ) - fixedBatch.centrePosition( i )).length();
+      float dv = (batch.getVelocity( i ) - fixedBatch.getVelocity( i )).length();
+      float dor = fabs( batch.getOrientation( i ) - fixedBatch.getOrientation( i ) );
+      if (dp > maxPosDiff) maxPosDiff = dp;
+      if (dv > maxVelDiff) maxVelDiff = dv;
+      if (dor > maxOrientDiff) maxOrientDiff = dor;
+    }
+  }
+
+  cout << "  vs LanderBatch after 600 steps of 1/" << (1 << FIXED_DT_SHIFT) << " s: max position difference "
+       << maxPosDiff << " m, max velocity difference " << maxVelDiff << " m/s, max orientation difference "
+       << maxOrientDiff << " rad" << endl;
+
+  // Altitude against the Landscape, at random points over the game
+  // landscape
+
+  Landscape   *landscape = session.getLandscape();
+  FixedTerrain terrain( landscape );
+  float        height = session.getLander()->getDimensions().y;
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  int   q = 100000, sameSegment = 0;
+  float maxAltDiff = 0;
+
+  for (int j=0; j<q; j++) {
+
+    vec3 p( in01( rng ) * session.maxX(), in01( rng ) * session.maxY(), 0 );
+    fix32 x = toFixed( p.x );
+
+    int i  = landscape->findSegmentBelow( p );
+    int fi = terrain.segmentBelow( x );
+
+    if (i == fi) {
+      sameSegment++;
+      float d = fabs( landscape->findLanderAltitude( i, p, height ) - fromFixed( terrain.altitude( fi, x, toFixed( p.y ), toFixed( height ) ) ) );
+      if (d > maxAltDiff) maxAltDiff = d;
+    }
+  }
+
+  cout << "  FixedTerrain: same segment below for " << sameSegment << " of " << q
+       << " points, max altitude difference " << maxAltDiff << " m" << endl;
+}
+
+
+// ---------------- main ----------------
+
+
+struct Test {
+  const char *name;
+  void (*run)();
+};
+
+Test tests[] = {
+  { "batch", benchBatch },
+  { "segment", benchSegment },
+  { "closest", benchClosest },
+  { "cursor", benchCursor },
+  { "sdf", benchSdf },
+  { "cspace", benchCspace },
+  { "collide", benchCollide },
+  { "coast", benchCoast },
+  { "integrate", benchIntegrate },
+  { "rewind", benchRewind },
+  { "env", benchEnv },
+  { "shm", benchShm },
+  { "mpc", benchMpc },
+  { "policy", benchPolicy },
+  { "mlp", benchMlp },
+  { "fixed", benchFixed },
+};
+
+int numTests = sizeof(tests) / sizeof(tests[0]);
+
+
+void usage()
+
+{
+  cerr << "Usage: llbench [test ...] [-n count] [-steps s]" << endl
+       << "Tests:";
+  for (int t=0; t<numTests; t++)
+    cerr << " " << tests[t].name;
+  cerr << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  vector<Test *> toRun;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-n" ) == 0 && i+1 < argc)
+      count = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-steps" ) == 0 && i+1 < argc)
+      steps = atoi( argv[++i] );
+    else {
+      int t;
+      for (t=0; t<numTests; t++)
+        if (strcmp( argv[i], tests[t].name ) == 0)
+          break;
+      if (t == numTests)
+        usage();
+      toRun.push_back( &tests[t] );
+    }
+
+  if (toRun.empty())
+    for (int t=0; t<numTests; t++)
+      toRun.push_back( &tests[t] );
+
+  for (unsigned int t=0; t<toRun.size(); t++)
+    toRun[t]->run();
+
+  return 0;
+}
@@ -0,0 +1,215 @@
+// llclient.cpp
+//
+// Load generator for llserve: opens many clients, each with many
+// sessions, flies every session with a simple policy (thrust while
+// falling faster than 2 m/s, restart when the game ends) and reports
+// how many frames arrived and how many ticks were missed.
+//
+// Usage: llclient [-socket path] [-clients c] [-sessions s] [-seconds t]
+
+
+#include "serverProtocol.h"
+#include "input.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+
+#define CLIENT_MAX_EVENTS 256
+
+
+struct LoadClient {
+  int             fd;
+  vector<uint8_t> controls;	// last sent to each session
+  vector<uint8_t> in;		// frame being read
+  size_t          inSize;	// bytes of it read
+  bool            started;	// a frame has arrived
+  uint32_t        lastTick;
+};
+
+
+long   frames = 0, missedTicks = 0, restarts = 0, wins = 0;
+double maxGap = 0;		// longest time between frames for one client (s)
+
+
+void sendMessage( LoadClient &c, int type, int session, uint32_t value )
+
+{
+  ClientMessage m;
+  m.type = type;
+  m.pad = 0;
+  m.session = session;
+  m.value = value;
+
+  if (send( c.fd, &m, sizeof(m), MSG_NOSIGNAL ) != sizeof(m)) { // (blocking, so whole)
+    cerr << "Lost the server: " << strerror( errno ) << endl;
+    exit(1);
+  }
+}
+
+
+// Act on a whole frame
+
+void handleFrame( LoadClient &c )
+
+{
+  TickHeader h;
+  memcpy( &h, &c.in[0], sizeof(h) );
+
+  if (c.started && h.tick > c.lastTick + 1)
+    missedTicks += h.tick - c.lastTick - 1;
+  c.started = true;
+  c.lastTick = h.tick;
+  frames++;
+
+  for (int i=0; i<h.numSessions; i++) {
+
+    SessionFrame f;
+    memcpy( &f, &c.in[sizeof(TickHeader) + i * sizeof(SessionFrame)], sizeof(f) );
+
+    if (!(f.flags & FRAME_RUNNING)) {
+      if (f.flags & FRAME_WON)
+        wins++;
+      restarts++;
+      sendMessage( c, MSG_RESTART, i, rand() );
+      c.controls[i] = CONTROL_NONE;
+      continue;
+    }
+
+    uint8_t ctl = (f.vy < -2 ? CONTROL_THRUST : CONTROL_NONE);
+
+    if (ctl != c.controls[i]) {
+      sendMessage( c, MSG_CONTROLS, i, ctl );
+      c.controls[i] = ctl;
+    }
+  }
+}
+
+
+void usage()
+
+{
+  cerr << "Usage: llclient [-socket path] [-clients c] [-sessions s] [-seconds t]" << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  const char *path = SERVER_SOCKET;
+  int    numClients = 10;
+  int    numSessions = 10;
+  double runSeconds = 10;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-socket" ) == 0 && i+1 < argc)
+      path = argv[++i];
+    else if (strcmp( argv[i], "-clients" ) == 0 && i+1 < argc && atoi( argv[i+1] ) > 0)
+      numClients = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-sessions" ) == 0 && i+1 < argc && atoi( argv[i+1] ) > 0 && atoi( argv[i+1] ) <= SERVER_MAX_SESSIONS)
+      numSessions = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-seconds" ) == 0 && i+1 < argc && atof( argv[i+1] ) > 0)
+      runSeconds = atof( argv[++i] );
+    else
+      usage();
+
+  sockaddr_un addr;
+  memset( &addr, 0, sizeof(addr) );
+  addr.sun_family = AF_UNIX;
+  strncpy( addr.sun_path, path, sizeof(addr.sun_path) - 1 );
+
+  int epollFd = epoll_create1( 0 );
+  vector<LoadClient> clients( numClients );
+
+  for (int i=0; i<numClients; i++) {
+
+    LoadClient &c = clients[i];
+
+    c.fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if (c.fd < 0 || connect( c.fd, (sockaddr *) &addr, sizeof(addr) ) < 0) {
+      cerr << "Could not connect to " << path << ": " << strerror( errno ) << endl;
+      exit(1);
+    }
+
+    c.controls.assign( numSessions, CONTROL_NONE );
+    c.in.resize( sizeof(TickHeader) + numSessions * sizeof(SessionFrame) );
+    c.inSize = 0;
+    c.started = false;
+    c.lastTick = 0;
+
+    for (int s=0; s<numSessions; s++)
+      sendMessage( c, MSG_OPEN, 0, i * numSessions + s );
+
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = i;
+    epoll_ctl( epollFd, EPOLL_CTL_ADD, c.fd, &ev );
+  }
+
+  typedef chrono::steady_clock Clock;
+
+  Clock::time_point start = Clock::now();
+  vector<Clock::time_point> lastFrame( numClients, start );
+  epoll_event events[CLIENT_MAX_EVENTS];
+
+  while (chrono::duration<double>( Clock::now() - start ).count() < runSeconds) {
+
+    int n = epoll_wait( epollFd, events, CLIENT_MAX_EVENTS, 100 );
+
+    for (int e=0; e<n; e++) {
+
+      int i = events[e].data.u32;
+      LoadClient &c = clients[i];
+
+      // Read until the socket is empty, acting on each whole frame.
+      // A frame has fewer sessions than were opened until the server
+      // has seen all of the MSG_OPENs.
+
+      for (;;) {
+        size_t want = sizeof(TickHeader);
+        if (c.inSize >= want) {
+          TickHeader h;
+          memcpy( &h, &c.in[0], sizeof(h) );
+          want += h.numSessions * sizeof(SessionFrame);
+          if (c.inSize == want) {
+            Clock::time_point now = Clock::now();
+            if (c.started)
+              maxGap = max( maxGap, chrono::duration<double>( now - lastFrame[i] ).count() );
+            lastFrame[i] = now;
+            handleFrame( c );
+            c.inSize = 0;
+            continue;
+          }
+        }
+        ssize_t r = recv( c.fd, &c.in[c.inSize], want - c.inSize, MSG_DONTWAIT );
+        if (r == 0) {
+          cerr << "The server closed the connection" << endl;
+          exit(1);
+        }
+        if (r < 0)
+          break;
+        c.inSize += r;
+      }
+    }
+  }
+
+  double seconds = chrono::duration<double>( Clock::now() - start ).count();
+
+  cout << numClients << " clients x " << numSessions << " sessions: "
+       << frames / seconds << " frames/s (" << frames * numSessions / seconds << " session states/s), "
+       << missedTicks << " ticks missed, longest gap " << maxGap * 1e3 << " ms, "
+       << restarts << " restarts, " << wins << " wins" << endl;
+
+  return 0;
+}
@@ -0,0 +1,93 @@
+// lldp.cpp
+//
+// Compute guidance tables for the landscape's pads by dynamic
+// programming on all cores (see policyTable.h), for llsim -c table.
+//
+// Usage: lldp [-o file] [-res r] [-sweeps s] [-tol cost] [-threads t] [-pads p]
+//
+// The table file defaults to policy.llt.  -res scales the number of
+// points on every axis away from zero (default 1; 0.5 has about 1/6
+// as many cells and takes about 1/6 as long).  Each pad is solved with at most 's'
+// sweeps (default 1000), until no cost changes by more than 'cost'
+// (default 0.05).  -pads solves only the first 'p' pads.
+
+
+#include "simHeaders.h"
+#include "policyTable.h"
+
+#include <chrono>
+
+
+typedef chrono::steady_clock Clock;
+
+
+void usage()
+
+{
+  cerr << "Usage: lldp [-o file] [-res r] [-sweeps s] [-tol cost] [-threads t] [-pads p]" << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  const char *path = "policy.llt";
+  float resolution = 1;
+  int   maxSweeps  = 1000;
+  float tolerance  = 0.05;
+  int   numThreads = 0;
+  int   maxPads    = -1;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-o" ) == 0 && i+1 < argc)
+      path = argv[++i];
+    else if (strcmp( argv[i], "-res" ) == 0 && i+1 < argc && atof( argv[i+1] ) > 0)
+      resolution = atof( argv[++i] );
+    else if (strcmp( argv[i], "-sweeps" ) == 0 && i+1 < argc)
+      maxSweeps = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-tol" ) == 0 && i+1 < argc)
+      tolerance = atof( argv[++i] );
+    else if (strcmp( argv[i], "-threads" ) == 0 && i+1 < argc)
+      numThreads = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-pads" ) == 0 && i+1 < argc)
+      maxPads = atoi( argv[++i] );
+    else
+      usage();
+
+  Landscape  landscape;
+  Session    probe( &landscape );	// for the lander size
+  MpcTerrain terrain( &landscape, probe.getLander()->getDimensions() );
+  ThreadPool pool( numThreads );
+
+  PolicyBuilder builder( &terrain, resolution );
+
+  int numPads = terrain.pads.size();
+  if (maxPads >= 0)
+    numPads = min( numPads, maxPads );
+
+  cout << builder.cells() << " cells per pad (" << builder.cells() * sizeof(uint16_t) / 1024
+       << " KB), " << numPads << " pads, " << pool.size() << " threads" << endl;
+
+  Clock::time_point start = Clock::now();
+
+  for (int p=0; p<numPads; p++) {
+
+    Clock::time_point t0 = Clock::now();
+    int sweeps = builder.solve( p, pool, maxSweeps, tolerance );
+    double seconds = chrono::duration<double>( Clock::now() - t0 ).count();
+
+    const MpcTerrain::Pad &pad = terrain.pads[p];
+
+    cout << "pad " << p << " at x " << pad.left << ".." << pad.right << ", y " << pad.y << ": "
+         << sweeps << " sweeps in " << seconds << " s ("
+         << builder.cells() * (double) sweeps / seconds / 1e6 << " M cell-updates/s)" << endl;
+  }
+
+  if (!builder.write( path, &landscape ))
+    return 1;
+
+  cout << "wrote " << path << " in " << chrono::duration<double>( Clock::now() - start ).count() << " s" << endl;
+
+  return 0;
+}
@@ -0,0 +1,175 @@
+// llmap.cpp
+//
+// Landing-success heatmap: play episodes from starts over a grid of
+// start positions (see heatmap.h) on all cores, and write the chance
+// of landing and the fuel used per cell as they are computed.
+//
+// Usage: llmap [-nx cells] [-ny cells] [-samples s] [-vx speed] [-vy speed]
+//              [-c free|descent] [-script file] [-dt seconds] [-maxtime seconds]
+//              [-threads t] [-every seconds] [-o prefix]
+//
+// Every 'every' seconds (default 2) and at the end, this writes
+// prefix.csv, prefix-success.ppm and prefix-fuel.ppm (prefix defaults
+// to 'heatmap').  Start velocities are in [-vx,vx] x [-vy,0].
+//
+// A script file has one line per change of the controls: the time
+// (in seconds from the start) and the controls as a number (see
+// input.h), e.g. "2.5 4" to start thrusting at 2.5 s.
+
+
+#include "simHeaders.h"
+#include "heatmap.h"
+#include "controllers.h"
+
+#include <chrono>
+#include <fstream>
+
+
+bool readScript( const char *path, ScriptedInput &script )
+
+{
+  ifstream in( path );
+  float    time;
+  int      controls;
+
+  if (!in) {
+    cerr << "Could not read " << path << endl;
+    return false;
+  }
+
+  while (in >> time >> controls)
+    script.add( time, controls );
+
+  return true;
+}
+
+
+bool writeResults( LandingHeatmap &heatmap, string prefix )
+
+{
+  return heatmap.writeCsv( (prefix + ".csv").c_str() ) &&
+         heatmap.writeSuccessPpm( (prefix + "-success.ppm").c_str() ) &&
+         heatmap.writeFuelPpm( (prefix + "-fuel.ppm").c_str() );
+}
+
+
+void usage()
+
+{
+  cerr << "Usage: llmap [-nx cells] [-ny cells] [-samples s] [-vx speed] [-vy speed]" << endl
+       << "             [-c free|descent] [-script file] [-dt seconds] [-maxtime seconds]" << endl
+       << "             [-threads t] [-every seconds] [-o prefix]" << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  int   nx = 64, ny = 32, samples = 16;
+  float vx = 30, vy = 5, dt = 1/60.0, maxTime = 300, every = 2;
+  int   numThreads = 0;
+  string prefix = "heatmap";
+
+  ControllerFunc controller = descentController;
+  ScriptedInput  script;
+  bool           useScript = false;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-nx" ) == 0 && i+1 < argc)
+      nx = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-ny" ) == 0 && i+1 < argc)
+      ny = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-samples" ) == 0 && i+1 < argc)
+      samples = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-vx" ) == 0 && i+1 < argc)
+      vx = atof( argv[++i] );
+    else if (strcmp( argv[i], "-vy" ) == 0 && i+1 < argc)
+      vy = atof( argv[++i] );
+    else if (strcmp( argv[i], "-dt" ) == 0 && i+1 < argc)
+      dt = atof( argv[++i] );
+    else if (strcmp( argv[i], "-maxtime" ) == 0 && i+1 < argc)
+      maxTime = atof( argv[++i] );
+    else if (strcmp( argv[i], "-threads" ) == 0 && i+1 < argc)
+      numThreads = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-every" ) == 0 && i+1 < argc)
+      every = atof( argv[++i] );
+    else if (strcmp( argv[i], "-o" ) == 0 && i+1 < argc)
+      prefix = argv[++i];
+    else if (strcmp( argv[i], "-script" ) == 0 && i+1 < argc) {
+      if (!readScript( argv[++i], script ))
+        return 1;
+      useScript = true;
+    } else if (strcmp( argv[i], "-c" ) == 0 && i+1 < argc) {
+      i++;
+      if (strcmp( argv[i], "free" ) == 0)
+        controller = freeFallController;
+      else if (strcmp( argv[i], "descent" ) == 0)
+        controller = descentController;
+      else
+        usage();
+    } else
+      usage();
+
+  if (numThreads < 1)
+    numThreads = thread::hardware_concurrency();
+  if (numThreads < 1)
+    numThreads = 1;
+
+  Landscape      landscape;
+  LandingHeatmap heatmap( &landscape, nx, ny, samples );
+
+  heatmap.maxVX      = vx;
+  heatmap.maxVY      = vy;
+  heatmap.deltaT     = dt;
+  heatmap.maxTime    = maxTime;
+  heatmap.controller = controller;
+  heatmap.script     = (useScript ? &script : NULL);
+
+  cout << heatmap.cellsX() << " x " << heatmap.cellsY() << " cells, " << samples << " samples each, on "
+       << numThreads << " threads" << endl;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  heatmap.start( numThreads );
+
+  // Write the results so far every so often
+
+  double lastWrite = 0;
+
+  while (!heatmap.done()) {
+
+    this_thread::sleep_for( chrono::milliseconds( 50 ) );
+
+    double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+    if (seconds - lastWrite >= every && !heatmap.done()) {
+      cout << heatmap.played() << " of " << heatmap.total() << " samples in " << seconds << " s" << endl;
+      writeResults( heatmap, prefix );
+      lastWrite = seconds;
+    }
+  }
+
+  heatmap.stop();
+
+  double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+  // Totals
+
+  long episodes = 0, landings = 0;
+  int  blocked = 0;
+
+  for (int j=0; j<heatmap.cellsY(); j++)
+    for (int i=0; i<heatmap.cellsX(); i++) {
+      episodes += heatmap.episodes( i, j );
+      landings += heatmap.landings( i, j );
+      if (heatmap.blocked( i, j ))
+        blocked++;
+    }
+
+  cout << episodes << " episodes in " << seconds << " s (" << episodes / seconds << " episodes/s): "
+       << landings << " landed (" << 100.0 * landings / max( 1L, episodes ) << "%), "
+       << blocked << " cells under the terrain" << endl;
+
+  return (writeResults( heatmap, prefix ) ? 0 : 1);
+}
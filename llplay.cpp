@@ -0,0 +1,193 @@
+// llplay.cpp
+//
+// Headless replay player: re-simulate recorded sessions (see
+// replay.h) as fast as possible and report the final score, fuel and
+// outcome of each, and whether it is the same as when it was
+// recorded.  Replays are recorded by 'll -record file' and
+// 'llsim -record prefix'.
+//
+// Usage: llplay [-threads t] [-q] replay ...
+//
+// -q reports only the totals and the replays that differ from their
+// recordings.
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "replay.h"
+
+#include <chrono>
+#include <thread>
+
+
+// The outcome of one replay
+
+struct Playback {
+  bool         ok;		// false if the replay could not be read or played
+  bool         same;		// the end state is the recorded one
+  SessionState end;
+  long         steps;
+  float        simTime;		// seconds simulated
+};
+
+
+Landscape      *landscape;
+ConfigObstacle *obstacle     = NULL; // shared by replays with REPLAY_SHAPE
+FixedTerrain   *fixedTerrain = NULL; // shared by replays with REPLAY_FIXED
+
+
+// The recorded state and the replayed state are the same
+
+bool sameState( const SessionState &a, const SessionState &b )
+
+{
+  return a.position.x == b.position.x && a.position.y == b.position.y &&
+         a.velocity.x == b.velocity.x && a.velocity.y == b.velocity.y &&
+         a.orientation == b.orientation && a.fuel == b.fuel && a.score == b.score &&
+         a.running == b.running && a.win == b.win;
+}
+
+
+// Play replays [first,last) in a session of their own.  Each thread
+// calls this with a different range.
+
+void playReplays( char **paths, int first, int last, Playback *results )
+
+{
+  Session session( landscape );
+  Replay  replay;
+  uint32_t hash = Replay::hashLandscape( landscape );
+
+  for (int i=first; i<last; i++) {
+
+    Playback &p = results[i];
+    p.ok = false;
+
+    if (!replay.read( paths[i] ))
+      continue;
+
+    if (replay.landscapeHash != hash) {
+      cerr << paths[i] << " was recorded on another landscape" << endl;
+      continue;
+    }
+
+    session.setConfigObstacle( replay.flags & REPLAY_SHAPE ? obstacle : NULL );
+    session.setFixedTerrain( replay.flags & REPLAY_FIXED ? fixedTerrain : NULL );
+    session.setContinuousCollision( replay.flags & REPLAY_CCD );
+    session.setOutlineCollision( replay.flags & REPLAY_OUTLINE );
+
+    replay.play( session );
+
+    p.ok      = true;
+    p.end     = session.getState();
+    p.same    = sameState( p.end, replay.end );
+    p.steps   = replay.steps.size();
+    p.simTime = replay.steps.size() * replay.stepTime;
+  }
+}
+
+
+void usage()
+
+{
+  cerr << "Usage: llplay [-threads t] [-q] replay ..." << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  int  numThreads = 1;
+  bool quiet      = false;
+
+  vector<char *> paths;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-threads" ) == 0 && i+1 < argc)
+      numThreads = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-q" ) == 0)
+      quiet = true;
+    else if (argv[i][0] == '-')
+      usage();
+    else
+      paths.push_back( argv[i] );
+
+  if (paths.empty())
+    usage();
+
+  if (numThreads < 1)
+    numThreads = thread::hardware_concurrency();
+  if (numThreads < 1)
+    numThreads = 1;
+  if (numThreads > (int) paths.size())
+    numThreads = paths.size();
+
+  // All sessions share one landscape and its helpers
+
+  landscape = new Landscape();
+
+  {
+    Session probe( landscape );	// for the lander outline
+    obstacle = new ConfigObstacle( landscape, probe.getLander()->getVertices() );
+    fixedTerrain = new FixedTerrain( landscape );
+  }
+
+  int n = paths.size();
+  vector<Playback> results( n );
+  vector<thread>   threads;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  for (int t=0; t<numThreads; t++)
+    threads.push_back( thread( playReplays, &paths[0], n * t / numThreads, n * (t+1) / numThreads, &results[0] ) );
+
+  for (int t=0; t<numThreads; t++)
+    threads[t].join();
+
+  double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+  // Report
+
+  int    played = 0, differ = 0, landed = 0, crashed = 0, running = 0;
+  long   steps = 0;
+  double simTime = 0;
+
+  for (int i=0; i<n; i++) {
+
+    Playback &p = results[i];
+
+    if (!p.ok)
+      continue;
+
+    played++;
+    steps   += p.steps;
+    simTime += p.simTime;
+
+    const char *outcome = (p.end.running ? "running" : p.end.win ? "landed" : "crashed");
+
+    if (p.end.running)
+      running++;
+    else if (p.end.win)
+      landed++;
+    else
+      crashed++;
+
+    if (!p.same)
+      differ++;
+
+    if (!quiet || !p.same)
+      cout << paths[i] << ": " << outcome << ", score " << p.end.score << ", fuel " << p.end.fuel
+           << ", " << p.simTime << " s" << (p.same ? "" : ", DIFFERS from the recording") << endl;
+  }
+
+  cout << played << " of " << n << " replays played on " << numThreads << " threads: "
+       << landed << " landed, " << crashed << " crashed, " << running << " still running, "
+       << differ << " differ from their recordings" << endl;
+
+  cout << steps << " steps in " << seconds << " s ("
+       << played / seconds << " replays/s, " << steps / seconds << " steps/s, "
+       << simTime / seconds << " times real time)" << endl;
+
+  return (played == n && differ == 0 ? 0 : 1);
+}
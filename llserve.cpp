@@ -0,0 +1,423 @@
+// llserve.cpp
+//
+// Simulation server: many independent game sessions in one process,
+// stepped together at a fixed tick rate for clients on a Unix domain
+// socket (see serverProtocol.h).  One epoll loop accepts clients and
+// reads their messages; each tick, the sessions are stepped on a
+// thread pool with the latest controls and every client is sent one
+// frame with the state of its sessions.  Sends never block: a client
+// that has not taken its last frame misses the next ones.
+//
+// Usage: llserve [-socket path] [-hz rate] [-threads t] [-seconds s]
+//
+// Every 5 seconds this reports the clients, the sessions and the time
+// the ticks took.  It runs for 's' seconds, or until interrupted if
+// 's' is 0 (the default).
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "vecEnv.h"
+#include "threadPool.h"
+#include "serverProtocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+#define SERVER_REPORT_SECONDS 5	 // between reports
+#define SERVER_CHUNK          64 // sessions per thread pool task
+#define SERVER_MAX_EVENTS     256 // events per epoll_wait()
+
+
+struct Client {
+  int          fd;
+  vector<int>  sessions;	// in the order opened
+  unsigned char partial[sizeof(ClientMessage)]; // start of a message not yet all read
+  int          partialSize;
+  vector<unsigned char> out;	// frame being sent
+  size_t       outSent;		// bytes of it sent
+};
+
+
+Landscape           *landscape;
+vector<Session *>    sessions;	// every session ever opened, by id
+vector<Controls>     controls;	// of each session, for the next tick
+vector<char>         active;	// of each session: false once its client has left
+vector<int>          freeIds;	// ids of inactive sessions, for reuse
+vector<Client *>     clients;
+long                 droppedFrames = 0;
+
+volatile sig_atomic_t quitting = 0;
+
+
+void interrupted( int sig ) { quitting = 1; }
+
+
+// ---------------- sessions ----------------
+
+
+void startSession( int id, uint32_t seed )
+
+{
+  minstd_rand rng( seed + 1 );	// (minstd_rand cannot be seeded with 0)
+
+  VecEnv::randomStart( *sessions[id], rng );
+  controls[id] = CONTROL_NONE;
+}
+
+
+int openSession( uint32_t seed )
+
+{
+  int id;
+
+  if (!freeIds.empty()) {
+    id = freeIds.back();
+    freeIds.pop_back();
+  }
+  else {
+    id = sessions.size();
+    sessions.push_back( new Session( landscape ) );
+    controls.push_back( CONTROL_NONE );
+    active.push_back( false );
+  }
+
+  active[id] = true;
+
+  startSession( id, seed );
+
+  return id;
+}
+
+
+void stepTask( void *dt, int chunk )
+
+{
+  int last = min( (int) sessions.size(), (chunk + 1) * SERVER_CHUNK );
+
+  for (int id=chunk*SERVER_CHUNK; id<last; id++)
+    if (active[id])
+      sessions[id]->step( controls[id], *(float *) dt );
+}
+
+
+// ---------------- clients ----------------
+
+
+void closeClient( Client *c )
+
+{
+  close( c->fd );		// (which also removes it from the epoll set)
+
+  for (unsigned int i=0; i<c->sessions.size(); i++) {
+    active[c->sessions[i]] = false;
+    freeIds.push_back( c->sessions[i] );
+  }
+
+  clients.erase( find( clients.begin(), clients.end(), c ) );
+  delete c;
+}
+
+
+void handleMessage( Client *c, const ClientMessage &m )
+
+{
+  switch (m.type) {
+
+  case MSG_OPEN:
+    if (c->sessions.size() < SERVER_MAX_SESSIONS)
+      c->sessions.push_back( openSession( m.value ) );
+    break;
+
+  case MSG_RESTART:
+    if (m.session < c->sessions.size())
+      startSession( c->sessions[m.session], m.value );
+    break;
+
+  case MSG_CONTROLS:
+    if (m.session < c->sessions.size())
+      controls[c->sessions[m.session]] = m.value & (CONTROL_ROTATE_CW | CONTROL_ROTATE_CCW | CONTROL_THRUST);
+    break;
+  }
+}
+
+
+// Read all that the client has sent.  Returns false if it has gone.
+
+bool readClient( Client *c )
+
+{
+  unsigned char buf[4096];
+
+  for (;;) {
+
+    ssize_t n = recv( c->fd, buf, sizeof(buf), 0 );
+
+    if (n == 0)
+      return false;
+    if (n < 0)
+      return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+
+    // Finish the partial message, then take whole messages
+
+    unsigned char *p = buf, *end = buf + n;
+
+    if (c->partialSize > 0) {
+      int take = min( (long) sizeof(ClientMessage) - c->partialSize, (long) (end - p) );
+      memcpy( c->partial + c->partialSize, p, take );
+      c->partialSize += take;
+      p += take;
+      if (c->partialSize < (int) sizeof(ClientMessage))
+        continue;
+      ClientMessage m;
+      memcpy( &m, c->partial, sizeof(m) );
+      handleMessage( c, m );
+      c->partialSize = 0;
+    }
+
+    for (; end - p >= (long) sizeof(ClientMessage); p += sizeof(ClientMessage)) {
+      ClientMessage m;
+      memcpy( &m, p, sizeof(m) );
+      handleMessage( c, m );
+    }
+
+    c->partialSize = end - p;
+    memcpy( c->partial, p, c->partialSize );
+  }
+}
+
+
+// Send as much of the client's frame as the socket takes.  Returns
+// false if the client has gone.
+
+bool flushClient( Client *c )
+
+{
+  while (c->outSent < c->out.size()) {
+    ssize_t n = send( c->fd, &c->out[c->outSent], c->out.size() - c->outSent, MSG_DONTWAIT | MSG_NOSIGNAL );
+    if (n < 0)
+      return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+    c->outSent += n;
+  }
+
+  return true;
+}
+
+
+// Start sending the client its frame for tick 't', unless it has not
+// taken the last one yet
+
+bool sendFrame( Client *c, uint32_t t )
+
+{
+  if (!flushClient( c ))
+    return false;
+
+  if (c->outSent < c->out.size()) {
+    droppedFrames++;
+    return true;
+  }
+
+  TickHeader h;
+  h.tick = t;
+  h.numSessions = c->sessions.size();
+  h.pad = 0;
+
+  c->out.resize( sizeof(TickHeader) + c->sessions.size() * sizeof(SessionFrame) ); // (no allocation once it has grown)
+  c->outSent = 0;
+
+  memcpy( &c->out[0], &h, sizeof(h) );
+
+  for (unsigned int i=0; i<c->sessions.size(); i++) {
+
+    Session *s = sessions[c->sessions[i]];
+    Lander  *l = s->getLander();
+
+    SessionFrame f;
+    f.x = l->centrePosition().x;
+    f.y = l->centrePosition().y;
+    f.vx = l->getVelocity().x;
+    f.vy = l->getVelocity().y;
+    f.orientation = l->getOrientation();
+    f.altitude = s->getAltitude();
+    f.fuel = l->fuel();
+    f.score = s->getScore();
+    f.flags = (s->running() ? FRAME_RUNNING : 0) | (s->won() ? FRAME_WON : 0);
+    f.lossReason = s->getLossReason();
+    f.pad = 0;
+
+    memcpy( &c->out[sizeof(TickHeader) + i * sizeof(SessionFrame)], &f, sizeof(f) );
+  }
+
+  return flushClient( c );
+}
+
+
+// ---------------- main ----------------
+
+
+int listenOn( const char *path )
+
+{
+  int fd = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0 );
+
+  sockaddr_un addr;
+  memset( &addr, 0, sizeof(addr) );
+  addr.sun_family = AF_UNIX;
+  strncpy( addr.sun_path, path, sizeof(addr.sun_path) - 1 );
+
+  unlink( path );
+
+  if (fd < 0 || bind( fd, (sockaddr *) &addr, sizeof(addr) ) < 0 || listen( fd, SOMAXCONN ) < 0) {
+    cerr << "Could not listen on " << path << ": " << strerror( errno ) << endl;
+    exit(1);
+  }
+
+  return fd;
+}
+
+
+void usage()
+
+{
+  cerr << "Usage: llserve [-socket path] [-hz rate] [-threads t] [-seconds s]" << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  const char *path = SERVER_SOCKET;
+  float  rate = 60;
+  int    numThreads = 0;
+  double runSeconds = 0;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-socket" ) == 0 && i+1 < argc)
+      path = argv[++i];
+    else if (strcmp( argv[i], "-hz" ) == 0 && i+1 < argc && atof( argv[i+1] ) > 0)
+      rate = atof( argv[++i] );
+    else if (strcmp( argv[i], "-threads" ) == 0 && i+1 < argc)
+      numThreads = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-seconds" ) == 0 && i+1 < argc)
+      runSeconds = atof( argv[++i] );
+    else
+      usage();
+
+  signal( SIGINT, interrupted );
+  signal( SIGTERM, interrupted );
+
+  landscape = new Landscape();
+
+  ThreadPool pool( numThreads );
+  float      dt = 1 / rate;
+
+  int listenFd = listenOn( path );
+  int epollFd  = epoll_create1( 0 );
+
+  epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;		// (the listening socket)
+  epoll_ctl( epollFd, EPOLL_CTL_ADD, listenFd, &ev );
+
+  cout << "serving on " << path << " at " << rate << " Hz with " << pool.size() << " threads" << endl;
+
+  typedef chrono::steady_clock Clock;
+
+  Clock::time_point start    = Clock::now();
+  Clock::time_point nextTick = start;
+  Clock::time_point nextReport = start + chrono::seconds( SERVER_REPORT_SECONDS );
+  Clock::duration   period   = chrono::duration_cast<Clock::duration>( chrono::duration<double>( 1 / rate ) );
+
+  uint32_t tick = 0;
+  long   ticks = 0, lateTicks = 0;
+  double tickSeconds = 0, maxTickSeconds = 0;
+
+  epoll_event events[SERVER_MAX_EVENTS];
+
+  while (!quitting) {
+
+    if (runSeconds > 0 && chrono::duration<double>( Clock::now() - start ).count() > runSeconds)
+      break;
+
+    // Wait for messages until the next tick
+
+    int timeout = max( 0L, (long) ceil( chrono::duration<double, milli>( nextTick - Clock::now() ).count() ) );
+    int n = epoll_wait( epollFd, events, SERVER_MAX_EVENTS, timeout );
+
+    for (int e=0; e<n; e++) {
+
+      Client *c = (Client *) events[e].data.ptr;
+
+      if (c == NULL) {
+
+        // New clients
+
+        int fd;
+        while ((fd = accept4( listenFd, NULL, NULL, SOCK_NONBLOCK )) >= 0) {
+          c = new Client();
+          c->fd = fd;
+          c->partialSize = 0;
+          c->outSent = 0;
+          ev.events = EPOLLIN;
+          ev.data.ptr = c;
+          epoll_ctl( epollFd, EPOLL_CTL_ADD, fd, &ev );
+          clients.push_back( c );
+        }
+      }
+      else if (!readClient( c ))
+        closeClient( c );
+    }
+
+    // Tick
+
+    Clock::time_point now = Clock::now();
+
+    if (now < nextTick)
+      continue;
+
+    pool.run( stepTask, &dt, (sessions.size() + SERVER_CHUNK - 1) / SERVER_CHUNK );
+
+    tick++;
+
+    for (unsigned int i=0; i<clients.size(); i++)
+      if (!sendFrame( clients[i], tick ))
+        closeClient( clients[i--] );
+
+    double seconds = chrono::duration<double>( Clock::now() - now ).count();
+    tickSeconds += seconds;
+    maxTickSeconds = max( maxTickSeconds, seconds );
+    ticks++;
+
+    // Keep to the schedule, but do not try to catch up after a stall
+
+    nextTick += period;
+    if (now - nextTick > period) {
+      nextTick = now + period;
+      lateTicks++;
+    }
+
+    if (now >= nextReport) {
+      cout << clients.size() << " clients, " << sessions.size() - freeIds.size() << " sessions, " << ticks << " ticks: mean "
+           << tickSeconds / max( 1L, ticks ) * 1e3 << " ms, max " << maxTickSeconds * 1e3 << " ms, "
+           << lateTicks << " late, " << droppedFrames << " frames dropped" << endl;
+      ticks = lateTicks = droppedFrames = 0;
+      tickSeconds = maxTickSeconds = 0;
+      nextReport += chrono::seconds( SERVER_REPORT_SECONDS );
+    }
+  }
+
+  close( listenFd );
+  unlink( path );
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+// llshm.cpp
+//
+// Host lander environments in shared memory for a controller in
+// another process (see shmEnv.h), or be that controller.
+//
+// Usage: llshm [-name region] [-n envs] [-steps s] [-hz rate] [-free] [-threads t] [-seed s]
+//        llshm -agent [-name region]
+//
+// The simulator steps 'n' environments 's' times (forever if 0), in
+// lockstep with the controller unless -free is given, and at most
+// 'rate' times a second if -hz is given.  It reports the steps/s and
+// the frames skipped every 5 seconds.
+//
+// With -agent this is an example controller: it thrusts each lander
+// while it falls faster than 2 m/s, and reports the frames answered
+// and the episodes that ended when the simulator stops.
+
+
+#include "simHeaders.h"
+#include "shmEnv.h"
+
+#include <chrono>
+#include <thread>
+
+
+#define REPORT_SECONDS 5
+
+
+typedef chrono::steady_clock Clock;
+
+
+double secondsSince( Clock::time_point t )
+
+{
+  return chrono::duration<double>( Clock::now() - t ).count();
+}
+
+
+int runAgent( const char *name )
+
+{
+  ShmAgent agent;
+
+  // Wait for the simulator to make the region
+
+  for (int tries=0; !agent.attach( name ); tries++) {
+    if (tries == 100) {
+      cerr << "No region " << name << endl;
+      return 1;
+    }
+    this_thread::sleep_for( chrono::milliseconds( 100 ) );
+  }
+
+  int  n = agent.size();
+  long frames = 0, ended = 0, landed = 0;
+  vector<Controls> last( n, CONTROL_NONE );
+
+  Clock::time_point start = Clock::now();
+  const ShmObservation *obs;
+
+  while ((obs = agent.next()) != NULL) {
+
+    for (int i=0; i<n; i++) {
+
+      if (obs[i].flags & SHM_ENDED) {
+        ended++;
+        landed += (obs[i].flags & SHM_WON) != 0;
+      }
+
+      Controls c = (obs[i].vy < -2 ? CONTROL_THRUST : CONTROL_NONE);
+
+      if (c != last[i]) {	// (saves writing cache lines the simulator reads)
+        agent.setAction( i, c );
+        last[i] = c;
+      }
+    }
+
+    agent.answer();
+    frames++;
+  }
+
+  double seconds = secondsSince( start );
+
+  cout << "agent: " << n << " environments, " << frames << " frames answered ("
+       << frames / seconds << "/s), " << ended << " episodes ended, " << landed << " landings" << endl;
+
+  return 0;
+}
+
+
+void usage()
+
+{
+  cerr << "Usage: llshm [-name region] [-n envs] [-steps s] [-hz rate] [-free] [-threads t] [-seed s]" << endl
+       << "       llshm -agent [-name region]" << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  const char *name = SHM_NAME;
+  bool   agent = false;
+  bool   lockstep = true;
+  int    n = 4096;
+  long   numSteps = 0;
+  float  rate = 0;
+  int    numThreads = 0;
+  unsigned int seed = 1;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-agent" ) == 0)
+      agent = true;
+    else if (strcmp( argv[i], "-free" ) == 0)
+      lockstep = false;
+    else if (strcmp( argv[i], "-name" ) == 0 && i+1 < argc)
+      name = argv[++i];
+    else if (strcmp( argv[i], "-n" ) == 0 && i+1 < argc && atoi( argv[i+1] ) > 0)
+      n = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-steps" ) == 0 && i+1 < argc)
+      numSteps = atol( argv[++i] );
+    else if (strcmp( argv[i], "-hz" ) == 0 && i+1 < argc)
+      rate = atof( argv[++i] );
+    else if (strcmp( argv[i], "-threads" ) == 0 && i+1 < argc)
+      numThreads = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-seed" ) == 0 && i+1 < argc)
+      seed = atoi( argv[++i] );
+    else
+      usage();
+
+  if (agent)
+    return runAgent( name );
+
+  ShmEnv env( n, (rate > 0 ? 1 / rate : 1/60.0), lockstep, numThreads );
+
+  if (!env.create( name, seed )) {
+    cerr << "Could not make the shared memory region " << name << ": " << strerror( errno ) << endl;
+    return 1;
+  }
+
+  cout << "simulating " << n << " environments in " << name << (lockstep ? " in lockstep" : "")
+       << " on " << env.threads() << " threads" << endl;
+
+  Clock::time_point start = Clock::now(), last = start;
+  Clock::time_point next = start;
+  long lastSteps = 0, lastSkipped = 0;
+
+  for (long s=0; numSteps == 0 || s < numSteps; s++) {
+
+    if (rate > 0) {
+      next += chrono::duration_cast<Clock::duration>( chrono::duration<double>( 1 / rate ) );
+      this_thread::sleep_until( next );
+    }
+
+    env.step();
+
+    if (secondsSince( last ) >= REPORT_SECONDS) {
+      double seconds = secondsSince( last );
+      cout << (s + 1 - lastSteps) / seconds << " steps/s (" << n * (s + 1 - lastSteps) / seconds / 1e6
+           << " M env-steps/s), " << env.framesSkipped() - lastSkipped << " frames skipped" << endl;
+      last = Clock::now();
+      lastSteps = s + 1;
+      lastSkipped = env.framesSkipped();
+    }
+  }
+
+  double seconds = secondsSince( start );
+
+  cout << numSteps << " steps in " << seconds << " s: " << numSteps / seconds << " steps/s, "
+       << env.framesSkipped() << " frames skipped" << endl;
+
+  return 0;
+}
@@ -0,0 +1,334 @@
+// llsim.cpp
+//
+// Headless lunar lander: run many episodes without a window and
+// report the outcomes and the simulation speed.
+//
+// Usage: llsim [-n episodes] [-dt seconds] [-c free|descent|mpc|table file]
+//              [-seed s] [-maxtime seconds] [-threads t] [-sdf] [-shape] [-ccd] [-outline] [-coast]
+//              [-adaptive maxsteps] [-fixed] [-record prefix]
+//
+// With -seed, each episode starts the lander at a random position
+// and horizontal velocity; otherwise every episode starts at the
+// normal reset position.  The start of each episode depends only on
+// the seed and the episode number, so the results do not depend on
+// the number of threads.
+//
+// -sdf gives the sessions a distance field (see distanceField.h), so
+// they skip the exact closest-point query far from the landscape.
+// -shape tests the whole lander outline against the landscape (see
+// configObstacle.h) instead of the base below the lander's centre.
+// -ccd sweeps the lander outline over each step and applies the
+// landing rules at the instant of contact, so long steps (-dt) do not
+// pass through the terrain.  -outline applies the landing rules when
+// any part of the outline touches the terrain after a step.  -coast
+// skips steps with no controls in one jump where the input allows it
+// (see Session::coast()); the free-fall controller always does.
+// -adaptive holds the controls for up to 'maxsteps' steps at once
+// while the lander is far from the terrain and the input would give
+// the same controls (see Session::stepAdaptive() and
+// InputSource::heldSteps()), so the outcomes are those of single
+// steps to within the integration error.  Controllers that decide
+// at every step take single steps.  -fixed steps the landers in fixed point
+// (see Session::setFixedTerrain()) with steps of FIXED_DT, and prints
+// a checksum of the final states, which is the same on every build.
+// -c mpc flies with the model-predictive autopilot (see
+// mpcAutopilot.h), limited by its iterations rather than by time so
+// that the results are the same on every run.  -c table flies with
+// the guidance table 'file' made by lldp (see policyTable.h).
+// -record writes each episode as a replay (see replay.h) named
+// 'prefix' followed by the episode number and .llr, for llplay.
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "controllers.h"
+#include "mpcAutopilot.h"
+#include "policyTable.h"
+#include "replay.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+
+int   numEpisodes = 100;
+float deltaT      = 1/60.0;
+float maxTime     = 300;
+int   seed        = -1;
+
+ControllerFunc controller = descentController;
+MpcTerrain    *mpcTerrain = NULL; // with -c mpc or -c table, which then take the place of 'controller'
+PolicyTable   *policyTable = NULL; // with -c table
+
+DistanceField  *field    = NULL;
+ConfigObstacle *obstacle = NULL;
+bool            ccd      = false;
+bool            outline  = false;
+bool            coast    = false;
+int             adaptive = 1;	// most steps in one adaptive step
+FixedTerrain   *fixedTerrain = NULL;
+const char     *recordPrefix = NULL;
+
+
+// Totals over a range of episodes
+
+struct Results {
+  int  wins, losses, timeouts;
+  long steps;
+  long coasted;			// steps skipped by Session::coast()
+  long longSteps;		// adaptive steps of more than one step
+  long inLongSteps;		// steps within those
+  long score;			// total score of the landings
+  uint64_t checksum;		// sum of the fixed-point state hashes at the end of each episode
+};
+
+
+// Run episodes [first,last) in a session of their own and add to
+// 'results'.  Each thread calls this with a different range.
+
+void runEpisodes( Landscape *landscape, int first, int last, Results *results )
+
+{
+  Session         session( landscape );
+  ControllerInput controllerInput( controller );
+  ScriptedInput   noInput;	// (an empty script, which coast() can skip)
+  MpcAutopilot    mpc( mpcTerrain, 0 );
+  PolicyController tableInput( policyTable, mpcTerrain );
+
+  // The free-fall controller gives the same controls as an empty
+  // script, but only the script can say so in advance
+
+  InputSource &source = (policyTable ? (InputSource &) tableInput :
+                         mpcTerrain ? (InputSource &) mpc :
+                         controller == freeFallController ? (InputSource &) noInput : controllerInput);
+
+  Replay         replay;
+  RecordingInput recorder( &source, &replay );
+
+  InputSource &input = (recordPrefix ? (InputSource &) recorder : source);
+
+  session.setDistanceField( field );
+  session.setConfigObstacle( obstacle );
+  session.setContinuousCollision( ccd );
+  session.setOutlineCollision( outline );
+  session.setFixedTerrain( fixedTerrain );
+
+  for (int e=first; e<last; e++) {
+
+    session.HardReset();
+
+    if (seed >= 0) {
+      minstd_rand rng( seed * 1000003 + e + 1 );
+      uniform_real_distribution<float> in01( 0, 1 );
+      float x  = (0.05 + 0.9 * in01( rng )) * session.maxX();
+      float vx = 60 * in01( rng ) - 30;
+      session.getLander()->place( vec3( x, 0.7 * session.maxY(), 0 ), vec3( vx, 0, 0 ), 0 );
+    }
+
+    noInput.restart();
+    mpc.restart( e + 1 );
+    tableInput.restart();
+
+    if (recordPrefix)
+      replay.begin( session, deltaT );
+
+    while (session.running() && session.getTime() < maxTime) {
+      if (coast) {
+        int n = min( input.idleSteps( session, deltaT ), (int) ((maxTime - session.getTime()) / deltaT) );
+        n = session.coast( deltaT, n );
+        input.skip( n, deltaT );
+        results->steps   += n;
+        results->coasted += n;
+      }
+      if (adaptive > 1) {
+        Controls c = input.controls( session, deltaT );
+        int hold = min( adaptive - 1, input.heldSteps( session, deltaT ) );
+        int n = session.stepAdaptive( c, deltaT, max( 1, min( hold + 1, (int) ((maxTime - session.getTime()) / deltaT) ) ) );
+        input.skip( n - 1, deltaT );
+        results->steps += n;
+        if (n > 1) {
+          results->longSteps++;
+          results->inLongSteps += n;
+        }
+        continue;
+      }
+      session.update( input, deltaT );
+      results->steps++;
+    }
+
+    if (recordPrefix) {
+      replay.finish( session );
+      replay.write( (string( recordPrefix ) + to_string( e ) + ".llr").c_str() );
+    }
+
+    if (fixedTerrain)
+      results->checksum += session.getFixedLander()->stateHash();
+
+    if (session.running())
+      results->timeouts++;
+    else if (session.won()) {
+      results->wins++;
+      results->score += session.getScore();
+    } else
+      results->losses++;
+  }
+}
+
+
+void usage()
+
+{
+  cerr << "Usage: llsim [-n episodes] [-dt seconds] [-c free|descent|mpc|table file] [-seed s] [-maxtime seconds] [-threads t] [-sdf] [-shape] [-ccd] [-outline] [-coast] [-adaptive maxsteps] [-fixed] [-record prefix]" << endl;
+  exit(1);
+}
+
+
+int main( int argc, char **argv )
+
+{
+  int  numThreads = 1;
+  bool useField   = false;
+  bool useShape   = false;
+  bool useFixed   = false;
+  bool useMpc     = false;
+  const char *tablePath = NULL;
+
+  for (int i=1; i<argc; i++)
+    if (strcmp( argv[i], "-n" ) == 0 && i+1 < argc)
+      numEpisodes = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-dt" ) == 0 && i+1 < argc)
+      deltaT = atof( argv[++i] );
+    else if (strcmp( argv[i], "-maxtime" ) == 0 && i+1 < argc)
+      maxTime = atof( argv[++i] );
+    else if (strcmp( argv[i], "-seed" ) == 0 && i+1 < argc)
+      seed = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-threads" ) == 0 && i+1 < argc)
+      numThreads = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-sdf" ) == 0)
+      useField = true;
+    else if (strcmp( argv[i], "-shape" ) == 0)
+      useShape = true;
+    else if (strcmp( argv[i], "-ccd" ) == 0)
+      ccd = true;
+    else if (strcmp( argv[i], "-outline" ) == 0)
+      outline = true;
+    else if (strcmp( argv[i], "-coast" ) == 0)
+      coast = true;
+    else if (strcmp( argv[i], "-adaptive" ) == 0 && i+1 < argc)
+      adaptive = atoi( argv[++i] );
+    else if (strcmp( argv[i], "-fixed" ) == 0)
+      useFixed = true;
+    else if (strcmp( argv[i], "-record" ) == 0 && i+1 < argc)
+      recordPrefix = argv[++i];
+    else if (strcmp( argv[i], "-c" ) == 0 && i+1 < argc) {
+      i++;
+      if (strcmp( argv[i], "free" ) == 0)
+        controller = freeFallController;
+      else if (strcmp( argv[i], "descent" ) == 0)
+        controller = descentController;
+      else if (strcmp( argv[i], "mpc" ) == 0)
+        useMpc = true;
+      else if (strcmp( argv[i], "table" ) == 0 && i+1 < argc)
+        tablePath = argv[++i];
+      else
+        usage();
+    } else
+      usage();
+
+  // A replay has the controls of every step
+
+  if (recordPrefix && (coast || adaptive > 1)) {
+    cerr << "-record cannot be used with -coast or -adaptive" << endl;
+    return 1;
+  }
+
+  if (numThreads < 1)
+    numThreads = thread::hardware_concurrency();
+  if (numThreads < 1)
+    numThreads = 1;
+
+  // All sessions share one landscape
+
+  Landscape landscape;
+
+  if (useField) {
+    Session probe( &landscape );	// for the world bounds
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    field = new DistanceField( &landscape, probe.minX(), probe.maxX(), probe.minY(), probe.maxY() );
+    cout << "distance field built in "
+         << chrono::duration<double>( chrono::steady_clock::now() - t0 ).count() << " s" << endl;
+  }
+
+  if (useShape) {
+    Session probe( &landscape );	// for the lander outline
+    obstacle = new ConfigObstacle( &landscape, probe.getLander()->getVertices() );
+  }
+
+  if (useMpc || tablePath) {
+    Session probe( &landscape );	// for the lander size
+    mpcTerrain = new MpcTerrain( &landscape, probe.getLander()->getDimensions() );
+  }
+
+  if (tablePath) {
+    policyTable = new PolicyTable();
+    if (!policyTable->open( tablePath, &landscape ))
+      return 1;
+  }
+
+  if (useFixed) {
+    fixedTerrain = new FixedTerrain( &landscape );
+    deltaT = FIXED_DT;
+  }
+
+  vector<Results> results( numThreads );
+  vector<thread>  threads;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  for (int t=0; t<numThreads; t++) {
+    memset( &results[t], 0, sizeof(Results) );
+    threads.push_back( thread( runEpisodes, &landscape,
+                               numEpisodes * t / numThreads, numEpisodes * (t+1) / numThreads,
+                               &results[t] ) );
+  }
+
+  Results total;
+  memset( &total, 0, sizeof(Results) );
+
+  for (int t=0; t<numThreads; t++) {
+    threads[t].join();
+    total.wins     += results[t].wins;
+    total.losses   += results[t].losses;
+    total.timeouts += results[t].timeouts;
+    total.steps    += results[t].steps;
+    total.coasted  += results[t].coasted;
+    total.longSteps   += results[t].longSteps;
+    total.inLongSteps += results[t].inLongSteps;
+    total.score    += results[t].score;
+    total.checksum += results[t].checksum;
+  }
+
+  double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+  cout << numEpisodes << " episodes on " << numThreads << " threads: "
+       << total.wins << " landed, " << total.losses << " crashed, " << total.timeouts << " timed out" << endl;
+
+  if (total.wins > 0)
+    cout << "mean score of landings " << total.score / (double) total.wins << endl;
+
+  cout << total.steps << " steps in " << seconds << " s ("
+       << numEpisodes / seconds << " episodes/s, "
+       << total.steps / seconds << " steps/s)" << endl;
+
+  if (coast)
+    cout << total.coasted << " of the steps were skipped by coasting" << endl;
+
+  if (adaptive > 1)
+    cout << total.inLongSteps << " of the steps were taken in " << total.longSteps << " long steps ("
+         << total.steps - total.coasted - total.inLongSteps + total.longSteps << " steps computed)" << endl;
+
+  if (fixedTerrain)
+    cout << "fixed-point checksum " << hex << total.checksum << dec << endl;
+
+  return 0;
+}
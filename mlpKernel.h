@@ -0,0 +1,241 @@
+// mlpKernel.h
+//
+// The SIMD kernels that evaluate an MlpPolicy for a batch of landers
+// (see mlpPolicy.h).  Like landerBatchKernel.h, they are compiled once
+// for SSE2 (in mlpPolicy.cpp) and once for AVX2 (in mlpPolicyAvx2.cpp),
+// so this only includes headers that are safe in either file.
+//
+// The activations are a structure of arrays: value k of every lander,
+// then value k+1, and so on, for 'n' landers (a multiple of
+// MLP_BATCH_ALIGN).  A layer broadcasts each weight and multiplies it
+// into vectors of landers, so there are no horizontal sums, and works
+// on MLP_BLOCK vectors at once so that each weight loaded is used
+// several times.
+//
+// In int8 form the weights have 8 bits and a scale per output, and the
+// activations are quantized to 8 bits with a scale per value.  Both
+// are stored as pairs of int16 (values 2k and 2k+1 in the low and high
+// halves of an int), so that madd16() multiplies and adds two of them
+// at once, and the sums are exact in 32 bits.
+
+
+#ifndef MLPKERNEL_H
+#define MLPKERNEL_H
+
+
+#include "simd.h"
+
+
+#define MLP_BLOCK       4	// vectors of landers per pass over a layer's weights
+#define MLP_BATCH_ALIGN 32	// MLP_BLOCK times the widest SIMD width
+
+
+// One layer (the numbers of inputs and outputs are even)
+
+struct MlpLayerArrays {
+  int   inputs, outputs;
+  bool  relu;			// ReLU on the outputs (otherwise linear)
+  const float *w;		// outputs x inputs
+  const float *bias;
+  const int   *qw;		// int8 form: outputs x inputs/2 pairs
+  const float *qScale;		// per output: the value of 1 in the int8 sums
+  const float *nextInvScale;	// per output: 1 / its scale as an input to the next layer (NULL for the last layer)
+};
+
+
+struct MlpBatchArrays {
+  int   numLayers;
+  const MlpLayerArrays *layers;
+  const float *inputInvScale;	// per input: 1 / its int8 scale
+
+  const float *input;		// layers[0].inputs x n
+  float *act[2];		// fp32 activations, widest layer x n (each)
+  int   *qact[2];		// int8 activation pairs, widest layer / 2 x n (each)
+  unsigned char *actions;	// n: the index of the largest output of each lander
+  int   n;
+};
+
+
+// One fp32 layer: out = relu( w in + bias )
+
+template <class S>
+void mlpDenseLayer( const MlpLayerArrays &l, const float *in, float *out, int n )
+
+{
+  typedef typename S::F F;
+
+  const F zero = S::set1( 0 );
+
+  for (int b=0; b<n; b+=MLP_BLOCK*S::WIDTH)
+    for (int j=0; j<l.outputs; j++) {
+
+      const float *w = l.w + j * l.inputs;
+      F acc[MLP_BLOCK];
+
+      for (int k=0; k<MLP_BLOCK; k++)
+        acc[k] = S::set1( l.bias[j] );
+
+      for (int i=0; i<l.inputs; i++) {
+        F wi = S::set1( w[i] );
+        const float *x = in + i * n + b;
+        for (int k=0; k<MLP_BLOCK; k++)
+          acc[k] = S::fmadd( wi, S::load( x + k * S::WIDTH ), acc[k] );
+      }
+
+      for (int k=0; k<MLP_BLOCK; k++)
+        S::store( out + j * n + b + k * S::WIDTH, (l.relu ? S::max( acc[k], zero ) : acc[k]) );
+    }
+}
+
+
+// Quantize values 'a' and 'b' of some landers (already divided by
+// their scales) to 8 bits and pack them into pairs
+
+template <class S>
+inline typename S::I mlpPack( typename S::F a, typename S::F b )
+
+{
+  typedef typename S::F F;
+
+  const F lo = S::set1( -127 ), hi = S::set1( 127 );
+
+  typename S::I qa = S::roundToInt( S::min( S::max( a, lo ), hi ) );
+  typename S::I qb = S::roundToInt( S::min( S::max( b, lo ), hi ) );
+
+  return S::ori( S::andi( qa, S::set1i( 0xffff ) ), S::slli( qb, 16 ) );
+}
+
+
+template <class S>
+void mlpQuantizeInput( const float *in, const float *invScale, int inputs, int *q, int n )
+
+{
+  for (int p=0; p<inputs/2; p++) {
+
+    typename S::F s0 = S::set1( invScale[2*p] ), s1 = S::set1( invScale[2*p+1] );
+
+    for (int b=0; b<n; b+=S::WIDTH)
+      S::storei( q + p * n + b, mlpPack<S>( S::mul( S::load( in + 2*p * n + b ), s0 ),
+                                            S::mul( S::load( in + (2*p+1) * n + b ), s1 ) ) );
+  }
+}
+
+
+// One int8 layer, on pairs of outputs.  Hidden layers write their
+// outputs quantized for the next layer to 'qout'; the last writes them
+// as floats to 'out'.
+
+template <class S>
+void mlpInt8Layer( const MlpLayerArrays &l, const int *in, int *qout, float *out, int n )
+
+{
+  typedef typename S::F F;
+  typedef typename S::I I;
+
+  const F zero  = S::set1( 0 );
+  const int pairs = l.inputs / 2;
+
+  for (int b=0; b<n; b+=MLP_BLOCK*S::WIDTH)
+    for (int j=0; j<l.outputs; j+=2) {
+
+      const int *w0 = l.qw + j * pairs, *w1 = w0 + pairs;
+      I acc0[MLP_BLOCK], acc1[MLP_BLOCK];
+
+      for (int k=0; k<MLP_BLOCK; k++)
+        acc0[k] = acc1[k] = S::set1i( 0 );
+
+      for (int p=0; p<pairs; p++) {
+        I a = S::set1i( w0[p] ), c = S::set1i( w1[p] );
+        const int *x = in + p * n + b;
+        for (int k=0; k<MLP_BLOCK; k++) {
+          I xk = S::loadi( x + k * S::WIDTH );
+          acc0[k] = S::addi( acc0[k], S::madd16( xk, a ) );
+          acc1[k] = S::addi( acc1[k], S::madd16( xk, c ) );
+        }
+      }
+
+      F scale0 = S::set1( l.qScale[j] ), scale1 = S::set1( l.qScale[j+1] );
+      F bias0  = S::set1( l.bias[j] ),   bias1  = S::set1( l.bias[j+1] );
+
+      for (int k=0; k<MLP_BLOCK; k++) {
+
+        F y0 = S::fmadd( S::toF( acc0[k] ), scale0, bias0 );
+        F y1 = S::fmadd( S::toF( acc1[k] ), scale1, bias1 );
+
+        if (l.relu) {
+          y0 = S::max( y0, zero );
+          y1 = S::max( y1, zero );
+        }
+
+        if (l.nextInvScale)
+          S::storei( qout + (j/2) * n + b + k * S::WIDTH,
+                     mlpPack<S>( S::mul( y0, S::set1( l.nextInvScale[j] ) ), S::mul( y1, S::set1( l.nextInvScale[j+1] ) ) ) );
+        else {
+          S::store( out + j * n + b + k * S::WIDTH, y0 );
+          S::store( out + (j+1) * n + b + k * S::WIDTH, y1 );
+        }
+      }
+    }
+}
+
+
+// The index of the largest of 'outputs' values of each lander (the
+// first, on a tie)
+
+template <class S>
+void mlpArgmax( const float *out, int outputs, unsigned char *actions, int n )
+
+{
+  typedef typename S::F F;
+  typedef typename S::I I;
+
+  for (int b=0; b<n; b+=S::WIDTH) {
+
+    F best = S::load( out + b );
+    I index = S::set1i( 0 );
+
+    for (int k=1; k<outputs; k++) {
+      F v = S::load( out + k * n + b );
+      F more = S::gt( v, best );
+      best  = S::select( more, v, best );
+      index = S::selecti( S::asI( more ), S::set1i( k ), index );
+    }
+
+    int lanes[S::WIDTH];
+    S::storei( lanes, index );
+    for (int i=0; i<S::WIDTH; i++)
+      actions[b+i] = lanes[i];
+  }
+}
+
+
+template <class S>
+void mlpForward( MlpBatchArrays &a, bool int8 )
+
+{
+  const MlpLayerArrays &last = a.layers[a.numLayers-1];
+
+  if (!int8) {
+    const float *in = a.input;
+    for (int l=0; l<a.numLayers; l++) {
+      mlpDenseLayer<S>( a.layers[l], in, a.act[l & 1], a.n );
+      in = a.act[l & 1];
+    }
+    mlpArgmax<S>( in, last.outputs, a.actions, a.n );
+  }
+  else {
+    mlpQuantizeInput<S>( a.input, a.inputInvScale, a.layers[0].inputs, a.qact[0], a.n );
+    for (int l=0; l<a.numLayers; l++)
+      mlpInt8Layer<S>( a.layers[l], a.qact[l & 1], a.qact[(l+1) & 1], a.act[0], a.n );
+    mlpArgmax<S>( a.act[0], last.outputs, a.actions, a.n );
+  }
+}
+
+
+// Entry points for each instruction set
+
+void mlpForwardSSE2( MlpBatchArrays &a, bool int8 );
+void mlpForwardAVX2( MlpBatchArrays &a, bool int8 );
+
+
+#endif
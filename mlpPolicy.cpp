@@ -0,0 +1,543 @@
+// mlpPolicy.cpp
+
+
+#include "mlpPolicy.h"
+
+#include <fstream>
+#include <random>
+
+
+// ---------------- MlpPolicy ----------------
+
+
+static int evenWidth( int w )
+
+{
+  return (w + 1) & ~1;
+}
+
+
+MlpPolicy::MlpPolicy( const vector<int> &hidden, unsigned int seed )
+
+{
+  int inputs = MLP_INPUTS;
+
+  quantized = false;
+
+  for (unsigned int l=0; l<hidden.size() && l+1<MLP_MAX_LAYERS; l++) {
+    addLayer( inputs, evenWidth( hidden[l] ) );
+    inputs = evenWidth( hidden[l] );
+  }
+  addLayer( inputs, MLP_ACTIONS );
+
+  // Uniform weights scaled for ReLU layers (He), and zero biases
+
+  minstd_rand rng( seed );
+
+  for (unsigned int l=0; l<layers.size(); l++) {
+    uniform_real_distribution<float> w( -1, 1 );
+    float scale = sqrt( 6.0f / layers[l].inputs );
+    for (unsigned int k=0; k<layers[l].w.size(); k++)
+      layers[l].w[k] = scale * w( rng );
+  }
+
+  makeArrays();
+}
+
+
+void MlpPolicy::addLayer( int inputs, int outputs )
+
+{
+  Layer l;
+
+  l.inputs  = inputs;
+  l.outputs = outputs;
+  l.w.assign( outputs * inputs, 0 );
+  l.bias.assign( outputs, 0 );
+
+  layers.push_back( l );
+}
+
+
+// Point the kernels' arrays at the layers
+
+void MlpPolicy::makeArrays()
+
+{
+  arrays.resize( layers.size() );
+
+  for (unsigned int l=0; l<layers.size(); l++) {
+
+    MlpLayerArrays &a = arrays[l];
+    Layer &layer = layers[l];
+
+    a.inputs  = layer.inputs;
+    a.outputs = layer.outputs;
+    a.relu    = (l+1 < layers.size());
+    a.w       = &layer.w[0];
+    a.bias    = &layer.bias[0];
+    a.qw      = (quantized ? &layer.qw[0] : NULL);
+    a.qScale  = (quantized ? &layer.qScale[0] : NULL);
+    a.nextInvScale = (quantized && a.relu ? &layer.nextInvScale[0] : NULL);
+  }
+}
+
+
+int MlpPolicy::widest()
+
+{
+  int w = 0;
+
+  for (unsigned int l=0; l<layers.size(); l++)
+    w = max( w, max( layers[l].inputs, layers[l].outputs ) );
+
+  return w;
+}
+
+
+long MlpPolicy::numWeights()
+
+{
+  long n = 0;
+
+  for (unsigned int l=0; l<layers.size(); l++)
+    n += layers[l].w.size() + layers[l].bias.size();
+
+  return n;
+}
+
+
+bool MlpPolicy::write( const char *path )
+
+{
+  MlpHeader h;
+
+  memset( &h, 0, sizeof(h) );
+
+  h.magic     = MLP_MAGIC;
+  h.version   = MLP_VERSION;
+  h.numLayers = layers.size();
+
+  for (unsigned int l=0; l<layers.size(); l++)
+    h.width[l] = layers[l].inputs;
+  h.width[layers.size()] = layers.back().outputs;
+
+  ofstream out( path, ios::binary );
+
+  out.write( (const char *) &h, sizeof(h) );
+
+  for (unsigned int l=0; l<layers.size(); l++) {
+    out.write( (const char *) &layers[l].w[0], layers[l].w.size() * sizeof(float) );
+    out.write( (const char *) &layers[l].bias[0], layers[l].bias.size() * sizeof(float) );
+  }
+
+  if (!out) {
+    cerr << "Could not write policy " << path << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool MlpPolicy::read( const char *path )
+
+{
+  ifstream in( path, ios::binary );
+  MlpHeader h;
+
+  if (!in.read( (char *) &h, sizeof(h) )) {
+    cerr << "Could not read policy " << path << endl;
+    return false;
+  }
+
+  if (h.magic != MLP_MAGIC || h.version != MLP_VERSION ||
+      h.numLayers < 1 || h.numLayers > MLP_MAX_LAYERS ||
+      h.width[0] != MLP_INPUTS || h.width[h.numLayers] != MLP_ACTIONS) {
+    cerr << path << " is not a lander policy" << endl;
+    return false;
+  }
+
+  for (unsigned int l=1; l<h.numLayers; l++)
+    if (h.width[l] < 1 || h.width[l] > 4096) {
+      cerr << path << " is not a lander policy" << endl;
+      return false;
+    }
+
+  // Odd widths are padded with an output (and an input of the next
+  // layer) whose weights are zero
+
+  vector<Layer> saved;
+  saved.swap( layers );
+
+  for (unsigned int l=0; l<h.numLayers; l++) {
+
+    addLayer( evenWidth( h.width[l] ), evenWidth( h.width[l+1] ) );
+
+    Layer &layer = layers[l];
+    vector<float> w( h.width[l+1] * h.width[l] );
+
+    in.read( (char *) &w[0], w.size() * sizeof(float) );
+    in.read( (char *) &layer.bias[0], h.width[l+1] * sizeof(float) );
+
+    for (unsigned int j=0; j<h.width[l+1]; j++)
+      for (unsigned int i=0; i<h.width[l]; i++)
+        layer.w[j * layer.inputs + i] = w[j * h.width[l] + i];
+  }
+
+  if (!in) {
+    cerr << path << " is truncated" << endl;
+    layers.swap( saved );
+    return false;
+  }
+
+  quantized = false;
+  makeArrays();
+
+  return true;
+}
+
+
+// Round 'x' times 'invScale' to 8 bits
+
+static int quantize8( float x, float invScale )
+
+{
+  return (int) lrintf( min( max( x * invScale, -127.0f ), 127.0f ) );
+}
+
+
+void MlpPolicy::quantize( const float *observations, int n )
+
+{
+  // The largest magnitude of each input and each hidden activation,
+  // from the fp32 policy
+
+  vector< vector<float> > largest( layers.size() );
+  vector<float> a, next;
+
+  for (unsigned int l=0; l<layers.size(); l++)
+    largest[l].assign( layers[l].inputs, 0 );
+
+  for (int s=0; s<n; s++) {
+
+    a.assign( observations + s * ENV_OBS_SIZE, observations + (s+1) * ENV_OBS_SIZE );
+
+    for (unsigned int l=0; l<layers.size(); l++) {
+
+      Layer &layer = layers[l];
+
+      for (int i=0; i<layer.inputs; i++)
+        largest[l][i] = max( largest[l][i], fabsf( a[i] ) );
+
+      if (l+1 == layers.size())
+        break;
+
+      next.assign( layer.outputs, 0 );
+      for (int j=0; j<layer.outputs; j++) {
+        float sum = layer.bias[j];
+        for (int i=0; i<layer.inputs; i++)
+          sum += layer.w[j * layer.inputs + i] * a[i];
+        next[j] = max( sum, 0.0f );
+      }
+      a.swap( next );
+    }
+  }
+
+  // Activation scales put the largest value at 127.  The scale of each
+  // input is folded into the weights, which then get a scale per
+  // output that puts the largest weight at 127.
+
+  vector< vector<float> > scale( layers.size() );
+
+  for (unsigned int l=0; l<layers.size(); l++) {
+    scale[l].resize( layers[l].inputs );
+    for (int i=0; i<layers[l].inputs; i++)
+      scale[l][i] = (largest[l][i] > 0 ? largest[l][i] / 127 : 1);
+  }
+
+  inputInvScale.resize( MLP_INPUTS );
+  for (int i=0; i<MLP_INPUTS; i++)
+    inputInvScale[i] = 1 / scale[0][i];
+
+  for (unsigned int l=0; l<layers.size(); l++) {
+
+    Layer &layer = layers[l];
+
+    layer.qw.assign( layer.outputs * layer.inputs / 2, 0 );
+    layer.qScale.resize( layer.outputs );
+    layer.nextInvScale.resize( layer.outputs );
+
+    for (int j=0; j<layer.outputs; j++) {
+
+      const float *w = &layer.w[j * layer.inputs];
+      float wMax = 0;
+
+      for (int i=0; i<layer.inputs; i++)
+        wMax = max( wMax, fabsf( w[i] * scale[l][i] ) );
+
+      float r = (wMax > 0 ? wMax / 127 : 1);
+
+      for (int i=0; i<layer.inputs; i+=2) {
+        int q0 = quantize8( w[i] * scale[l][i], 1 / r );
+        int q1 = quantize8( w[i+1] * scale[l][i+1], 1 / r );
+        layer.qw[(j * layer.inputs + i) / 2] = (int) ((q0 & 0xffff) | ((uint32_t) q1 << 16));
+      }
+
+      layer.qScale[j] = r;
+      layer.nextInvScale[j] = (l+1 < layers.size() ? 1 / scale[l+1][j] : 0);
+    }
+  }
+
+  quantized = true;
+  makeArrays();
+}
+
+
+// ---------------- kernels ----------------
+
+
+// Scalar versions of the kernels in mlpKernel.h, with the same layout
+// and rounding
+
+static void mlpForwardScalar( MlpBatchArrays &a, bool int8 )
+
+{
+  int n = a.n;
+  const float *out = NULL;
+
+  if (!int8) {
+
+    const float *in = a.input;
+
+    for (int l=0; l<a.numLayers; l++) {
+
+      const MlpLayerArrays &layer = a.layers[l];
+      float *o = a.act[l & 1];
+
+      for (int j=0; j<layer.outputs; j++)
+        for (int b=0; b<n; b++) {
+          float sum = layer.bias[j];
+          for (int i=0; i<layer.inputs; i++)
+            sum += layer.w[j * layer.inputs + i] * in[i * n + b];
+          o[j * n + b] = (layer.relu ? max( sum, 0.0f ) : sum);
+        }
+      in = o;
+    }
+    out = in;
+  }
+  else {
+
+    int inputs = a.layers[0].inputs;
+
+    for (int p=0; p<inputs/2; p++)
+      for (int b=0; b<n; b++)
+        a.qact[0][p * n + b] = (int) ((quantize8( a.input[2*p * n + b], a.inputInvScale[2*p] ) & 0xffff) |
+                                      ((uint32_t) quantize8( a.input[(2*p+1) * n + b], a.inputInvScale[2*p+1] ) << 16));
+
+    for (int l=0; l<a.numLayers; l++) {
+
+      const MlpLayerArrays &layer = a.layers[l];
+      const int *in = a.qact[l & 1];
+      int *qout = a.qact[(l+1) & 1];
+      int pairs = layer.inputs / 2;
+
+      for (int j=0; j<layer.outputs; j+=2)
+        for (int b=0; b<n; b++) {
+
+          int acc[2] = { 0, 0 };
+
+          for (int p=0; p<pairs; p++) {
+            int x = in[p * n + b];
+            for (int k=0; k<2; k++) {
+              int w = layer.qw[(j+k) * pairs + p];
+              acc[k] += (int16_t) x * (int16_t) w + (x >> 16) * (w >> 16);
+            }
+          }
+
+          float y[2];
+          for (int k=0; k<2; k++) {
+            y[k] = acc[k] * layer.qScale[j+k] + layer.bias[j+k];
+            if (layer.relu)
+              y[k] = max( y[k], 0.0f );
+          }
+
+          if (layer.nextInvScale)
+            qout[(j/2) * n + b] = (int) ((quantize8( y[0], layer.nextInvScale[j] ) & 0xffff) |
+                                         ((uint32_t) quantize8( y[1], layer.nextInvScale[j+1] ) << 16));
+          else {
+            a.act[0][j * n + b] = y[0];
+            a.act[0][(j+1) * n + b] = y[1];
+          }
+        }
+    }
+    out = a.act[0];
+  }
+
+  int outputs = a.layers[a.numLayers-1].outputs;
+
+  for (int b=0; b<n; b++) {
+    int best = 0;
+    for (int k=1; k<outputs; k++)
+      if (out[k * n + b] > out[best * n + b])
+        best = k;
+    a.actions[b] = best;
+  }
+}
+
+
+void mlpForwardSSE2( MlpBatchArrays &a, bool int8 )
+
+{
+#ifdef HAVE_SSE2
+  mlpForward<SimdSSE2>( a, int8 );
+#else
+  mlpForwardScalar( a, int8 );
+#endif
+}
+
+
+// ---------------- MlpBatch ----------------
+
+
+MlpBatch::MlpBatch( MlpPolicy *p, int n, MlpPrecision prec )
+
+{
+  policy     = p;
+  numLanders = -1;
+  paddedSize = 0;
+
+  resize( n );
+  setPrecision( prec );
+
+  kernel = bestSimdKernel();
+}
+
+
+void MlpBatch::resize( int n )
+
+{
+  if (n == numLanders)
+    return;
+
+  numLanders = n;
+  paddedSize = max( MLP_BATCH_ALIGN, (n + MLP_BATCH_ALIGN - 1) / MLP_BATCH_ALIGN * MLP_BATCH_ALIGN );
+
+  // Padding landers observe zeros, and their actions are ignored
+
+  int widest = policy->widest();
+
+  input.assign( MLP_INPUTS * paddedSize, 0 );
+  for (int k=0; k<2; k++) {
+    act[k].assign( widest * paddedSize, 0 );
+    qact[k].assign( widest / 2 * paddedSize, 0 );
+  }
+  chosen.assign( paddedSize, CONTROL_NONE );
+}
+
+
+void MlpBatch::setPrecision( MlpPrecision p )
+
+{
+  if (p == MLP_INT8 && !policy->isQuantized())
+    p = MLP_FP32;
+
+  precision = p;
+}
+
+
+void MlpBatch::setKernel( SimdKernel k )
+
+{
+  if (k == SIMD_AVX2 && !cpuHasAVX2())
+    k = SIMD_SSE2;
+
+#ifndef HAVE_SSE2
+  if (k == SIMD_SSE2)
+    k = SIMD_SCALAR;
+#endif
+
+  kernel = k;
+}
+
+
+MlpBatchArrays MlpBatch::arrays()
+
+{
+  MlpBatchArrays a;
+
+  a.numLayers = policy->numLayers();
+  a.layers    = policy->layerArrays();
+  a.inputInvScale = (policy->isQuantized() ? policy->inputInvScales() : NULL);
+  a.input     = &input[0];
+  a.act[0]    = &act[0][0];
+  a.act[1]    = &act[1][0];
+  a.qact[0]   = &qact[0][0];
+  a.qact[1]   = &qact[1][0];
+  a.actions   = &chosen[0];
+  a.n         = paddedSize;
+
+  return a;
+}
+
+
+void MlpBatch::evaluate()
+
+{
+  MlpBatchArrays a = arrays();
+  bool int8 = (precision == MLP_INT8);
+
+  switch (kernel) {
+  case SIMD_AVX2:
+    mlpForwardAVX2( a, int8 );
+    break;
+  case SIMD_SSE2:
+    mlpForwardSSE2( a, int8 );
+    break;
+  default:
+    mlpForwardScalar( a, int8 );
+    break;
+  }
+}
+
+
+// ---------------- MlpPopulation ----------------
+
+
+MlpPopulation::~MlpPopulation()
+
+{
+  for (unsigned int i=0; i<inputs.size(); i++)
+    delete inputs[i];
+}
+
+
+InputSource *MlpPopulation::add( Session *s )
+
+{
+  Input *input = new Input();
+
+  input->population = this;
+  input->slot = sessions.size();
+
+  sessions.push_back( s );
+  inputs.push_back( input );
+
+  return input;
+}
+
+
+void MlpPopulation::tick()
+
+{
+  batch.resize( sessions.size() );
+
+  float o[ENV_OBS_SIZE];
+
+  for (unsigned int i=0; i<sessions.size(); i++) {
+    VecEnv::observation( *sessions[i], sessions[i]->getTime() == 0, o );
+    batch.setObservation( i, o );
+  }
+
+  batch.evaluate();
+}
@@ -0,0 +1,191 @@
+// mlpPolicy.h
+//
+// Small multilayer perceptron policies, evaluated for many landers at
+// once.  A policy maps a lander's observation (as VecEnv writes it; see
+// vecEnv.h) through hidden ReLU layers to a value for each of the
+// MLP_ACTIONS combinations of the rotate and thrust controls, and the
+// lander takes the one with the largest value.
+//
+// The policies are trained elsewhere (e.g. against VecEnv or ShmEnv)
+// and loaded with read(), or made with random weights for testing.
+//
+// MlpBatch evaluates a policy for a batch of observations with one call
+// (see mlpKernel.h), in fp32 or, after MlpPolicy::quantize(), in int8.
+// MlpPopulation drives a set of sessions with one evaluation per tick:
+// each session's InputSource returns its lander's action from the last
+// tick.
+
+
+#ifndef MLPPOLICY_H
+#define MLPPOLICY_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "input.h"
+#include "vecEnv.h"
+#include "mlpKernel.h"
+#include <stdint.h>
+#include <vector>
+
+
+#define MLP_MAGIC   0x504c4d4c	// "LMLP"
+#define MLP_VERSION 1
+
+#define MLP_INPUTS     ENV_OBS_SIZE // the observation
+#define MLP_ACTIONS    8	// one for each Controls value of CW, CCW and thrust
+#define MLP_HIDDEN     64	// default width of the hidden layers
+#define MLP_MAX_LAYERS 8
+
+
+typedef enum { MLP_FP32, MLP_INT8 } MlpPrecision;
+
+
+// A policy file is an MlpHeader followed by the weights (outputs x
+// inputs) and the biases of each layer in turn, as little-endian floats
+
+struct MlpHeader {
+  uint32_t magic, version;
+  uint32_t numLayers;
+  uint32_t width[MLP_MAX_LAYERS+1]; // inputs of each layer, then outputs of the last
+};
+
+
+class MlpPolicy {
+
+  struct Layer {
+    int inputs, outputs;	// even (odd widths are padded with a zero)
+    vector<float> w, bias;
+    vector<int>   qw;		// int8 form (see mlpKernel.h)
+    vector<float> qScale, nextInvScale;
+  };
+
+  vector<Layer> layers;
+  vector<float> inputInvScale;	// int8 form
+  vector<MlpLayerArrays> arrays;
+  bool quantized;
+
+  void addLayer( int inputs, int outputs );
+  void makeArrays();
+
+ public:
+
+  // Hidden layers of the given widths, with random weights from 'seed'
+
+  MlpPolicy( const vector<int> &hidden = vector<int>( 2, MLP_HIDDEN ), unsigned int seed = 1 );
+
+  bool read( const char *path );
+  bool write( const char *path );
+
+  // Make the int8 form, with the activation scales set by the largest
+  // values seen over 'n' observations (ENV_OBS_SIZE floats each, as
+  // VecEnv::observations() holds them)
+
+  void quantize( const float *observations, int n );
+
+  bool isQuantized() { return quantized; }
+
+  int numLayers() { return layers.size(); }
+  int width( int l ) { return (l < numLayers() ? layers[l].inputs : layers.back().outputs); }
+  int widest();
+  long numWeights();
+
+  const MlpLayerArrays *layerArrays() { return &arrays[0]; }
+  const float *inputInvScales() { return &inputInvScale[0]; }
+};
+
+
+// Buffers for evaluating a policy for 'n' landers
+
+class MlpBatch {
+
+  MlpPolicy *policy;
+  int numLanders;
+  int paddedSize;		// numLanders rounded up to MLP_BATCH_ALIGN
+
+  vector<float> input;		// MLP_INPUTS x paddedSize
+  vector<float> act[2];
+  vector<int>   qact[2];
+  vector<unsigned char> chosen;	// index of the largest output of each lander
+
+  MlpPrecision precision;
+  SimdKernel   kernel;
+
+  MlpBatchArrays arrays();
+
+ public:
+
+  MlpBatch( MlpPolicy *p, int n = 0, MlpPrecision prec = MLP_FP32 );
+
+  // Change the number of landers (this allocates only when it grows)
+
+  void resize( int n );
+  int  size() { return numLanders; }
+
+  // Set the observation of lander 'i' (ENV_OBS_SIZE floats)
+
+  void setObservation( int i, const float *o ) {
+    for (int k=0; k<MLP_INPUTS; k++)
+      input[k * paddedSize + i] = o[k];
+  }
+
+  // Evaluate the policy for every lander
+
+  void evaluate();
+
+  Controls action( int i ) { return chosen[i]; }
+  const unsigned char *actions() { return &chosen[0]; }
+
+  // The last layer's output 'k' for lander 'i' from the last evaluate()
+
+  float output( int i, int k ) { return act[(precision == MLP_INT8 ? 0 : (policy->numLayers() - 1) & 1)][k * paddedSize + i]; }
+
+  // MLP_INT8 needs a quantized policy; otherwise this gives MLP_FP32
+
+  void setPrecision( MlpPrecision p );
+  MlpPrecision getPrecision() { return precision; }
+
+  // The kernel used by evaluate().  By default this is the widest one
+  // the CPU supports.
+
+  void setKernel( SimdKernel k );
+  SimdKernel getKernel() { return kernel; }
+};
+
+
+// Sessions flown by one policy
+
+class MlpPopulation {
+
+  class Input : public InputSource {
+   public:
+    MlpPopulation *population;
+    int slot;
+    Controls controls( Session &session, float deltaT ) { return population->batch.action( slot ); }
+  };
+
+  MlpBatch batch;
+  vector<Session *> sessions;
+  vector<Input *>   inputs;
+
+ public:
+
+  MlpPopulation( MlpPolicy *p, MlpPrecision prec = MLP_FP32 ) : batch( p, 0, prec ) {}
+  ~MlpPopulation();
+
+  // Add 's' to the population.  Returns the InputSource to update it
+  // with, which gives the action chosen at the last tick().
+
+  InputSource *add( Session *s );
+
+  int size() { return sessions.size(); }
+
+  // Observe every session and evaluate the policy for all of them
+
+  void tick();
+
+  MlpBatch &getBatch() { return batch; }
+};
+
+
+#endif
@@ -0,0 +1,18 @@
+// mlpPolicyAvx2.cpp
+//
+// The AVX2 instance of the MLP policy kernels.  This file is built
+// with -mavx2 -mfma, so it must only be called when cpuHasAVX2().
+
+
+#include "mlpKernel.h"
+
+
+void mlpForwardAVX2( MlpBatchArrays &a, bool int8 )
+
+{
+#ifdef HAVE_AVX2
+  mlpForward<SimdAVX2>( a, int8 );
+#else
+  mlpForwardSSE2( a, int8 );
+#endif
+}
@@ -0,0 +1,320 @@
+// mpcAutopilot.cpp
+
+
+#include "mpcAutopilot.h"
+
+
+#define MPC_LAND_REWARD   1e4	// for a plan that lands
+#define MPC_CRASH_COST    1e4	// for a plan that touches the terrain any other way
+#define MPC_MAX_TILT      0.8	// plans tilting further than this cost MPC_TILT_COST (radians)
+#define MPC_TILT_COST     1e3
+#define MPC_UPRIGHT_ALT   15	// the orientation costs more below this height over the pad (m)
+
+#define MPC_VX_GAIN       0.15	// target horizontal speed per m from the pad
+#define MPC_MAX_VX        12	// fastest target horizontal speed (m/s)
+#define MPC_VY_GAIN       0.15	// target vertical speed per m from the glide path
+#define MPC_MAX_DESCENT   10	// fastest target descent (m/s)
+#define MPC_MAX_CLIMB     4	// fastest target climb (m/s)
+#define MPC_TOUCHDOWN_VY  0.5	// target descent over the pad (m/s)
+#define MPC_GLIDE_SLOPE   1.0	// glide path height per m from the pad
+#define MPC_APPROACH_HEIGHT 5	// glide path height at the edge of the pad (m)
+#define MPC_MIN_VX        0.3	// slowest target horizontal speed beyond the pad (m/s)
+
+#define MPC_ORIENT_WEIGHT 2	// of the squared orientation
+#define MPC_FUEL_WEIGHT   0.001	// per unit of fuel
+
+
+const Controls MpcAutopilot::options[MPC_OPTIONS] = {
+  CONTROL_NONE, CONTROL_ROTATE_CW, CONTROL_ROTATE_CCW,
+  CONTROL_THRUST, CONTROL_THRUST | CONTROL_ROTATE_CW, CONTROL_THRUST | CONTROL_ROTATE_CCW
+};
+
+
+// ---------------- MpcTerrain ----------------
+
+
+MpcTerrain::MpcTerrain( Landscape *landscape, vec3 landerDimensions )
+
+{
+  landerWidth  = landerDimensions.x;
+  landerHeight = landerDimensions.y;
+
+  int n = landscape->numSegments();
+
+  heights.assign( (int) ceil( landscape->vertex( n ).x / MPC_CELL ) + 1, -MAXFLOAT );
+
+  for (int i=0; i<n; i++) {
+
+    vec3 a = landscape->vertex( i ), b = landscape->vertex( i+1 );
+
+    // The highest point of the segment within each cell it crosses
+    // is at one end of the part in the cell
+
+    for (int c=max( 0, (int) floor( a.x / MPC_CELL ) ); c<(int) heights.size() && c * MPC_CELL <= b.x; c++) {
+      float x0 = max( a.x, (float) (c * MPC_CELL) );
+      float x1 = min( b.x, (float) ((c+1) * MPC_CELL) );
+      float slope = (b.x > a.x ? (b.y - a.y) / (b.x - a.x) : 0);
+      heights[c] = max( heights[c], max( a.y + slope * (x0 - a.x), a.y + slope * (x1 - a.x) ) );
+    }
+
+    if (a.y == b.y && b.x - a.x > landerWidth + 2 * MPC_PAD_MARGIN) {
+      Pad p = { a.x, b.x, a.y };
+      pads.push_back( p );
+    }
+  }
+}
+
+
+float MpcTerrain::highest( float x0, float x1 )
+
+{
+  if (x0 > x1)
+    swap( x0, x1 );
+
+  int c0 = max( 0, (int) (x0 / MPC_CELL) );
+  int c1 = min( (int) heights.size() - 1, (int) (x1 / MPC_CELL) );
+
+  float h = -MAXFLOAT;
+  for (int c=c0; c<=c1; c++)
+    h = max( h, heights[c] );
+
+  return h;
+}
+
+
+int MpcTerrain::nearestPad( float x )
+
+{
+  int   best = -1;
+  float bestDist = MAXFLOAT;
+
+  for (unsigned int i=0; i<pads.size(); i++) {
+    float d = fabs( x - 0.5f * (pads[i].left + pads[i].right) );
+    if (d < bestDist) {
+      best = i;
+      bestDist = d;
+    }
+  }
+
+  return best;
+}
+
+
+// ---------------- MpcAutopilot ----------------
+
+
+MpcAutopilot::MpcAutopilot( MpcTerrain *t, double budgetMicroseconds, int iterationLimit )
+
+{
+  terrain       = t;
+  budget        = budgetMicroseconds * 1e-6;
+  maxIterations = iterationLimit;
+  iterations    = 0;
+  steps         = 0;
+
+  restart();
+}
+
+
+void MpcAutopilot::restart( unsigned int seed )
+
+{
+  for (int b=0; b<MPC_BLOCKS; b++)
+    plan[b] = 0;
+
+  stepInBlock = 0;
+  lastTime    = MAXFLOAT;
+  pad         = -1;
+  rng.seed( seed );
+}
+
+
+// Cost of holding the velocity that glides to the pad, at one state
+
+float MpcAutopilot::guidance( float x, float y, float vx, float vy, float o )
+
+{
+  float dx   = x - padCentre;
+  bool  over = (fabs( dx ) < padFree);
+
+  float vxTarget = -min( (float) MPC_MAX_VX, max( (float) -MPC_MAX_VX, (float) MPC_VX_GAIN * dx ) );
+
+  if (!over && fabs( vxTarget ) < MPC_MIN_VX)
+    vxTarget = (dx > 0 ? -MPC_MIN_VX : MPC_MIN_VX);
+
+  // Glide down toward the pad, above the terrain on the way
+
+  float yTarget = (over ? padTop : max( padTop + MPC_APPROACH_HEIGHT + (float) MPC_GLIDE_SLOPE * (fabs( dx ) - padFree), clearY ));
+  float vyTarget = min( (float) MPC_MAX_CLIMB, max( (float) -MPC_MAX_DESCENT, (float) MPC_VY_GAIN * (yTarget - y) ) );
+
+  if (over)
+    vyTarget = min( vyTarget, (float) -MPC_TOUCHDOWN_VY );
+
+  // Upright near the pad
+
+  float upright = (over ? 1 + 10 * max( 0.0f, 1 - (y - padTop) / MPC_UPRIGHT_ALT ) : 1);
+
+  return (vx - vxTarget) * (vx - vxTarget) + (vy - vyTarget) * (vy - vyTarget)
+         + MPC_ORIENT_WEIGHT * upright * o * o + (fabs( o ) > MPC_MAX_TILT ? MPC_TILT_COST : 0);
+}
+
+
+// Simulate the lander through plan 'p' and return its cost.  The
+// steps are as Session::step() takes them with the explicit Euler
+// update.
+
+float MpcAutopilot::cost( const unsigned char *p )
+
+{
+  PredictedLander l;
+  float total = 0;
+  const MpcTerrain::Pad &target = terrain->pads[pad];
+
+  l.start( x0, y0, vx0, vy0, o0, fuel0 );
+
+  for (int b=0; b<MPC_BLOCKS; b++) {
+
+    Controls ctl = options[p[b]];
+    int      n   = (b == 0 ? MPC_BLOCK_STEPS - stepInBlock : MPC_BLOCK_STEPS);
+
+    for (int j=0; j<n; j++) {
+
+      l.step( ctl, dt );
+
+      // Touching the terrain ends the plan
+
+      bool onPad;
+
+      if (terrain->altitude( target, l.x, l.y, onPad ) < TOUCHDOWN_ALTITUDE) {
+        if (onPad && l.canLand())
+          return total - MPC_LAND_REWARD + MPC_FUEL_WEIGHT * (fuel0 - l.fuel);
+        return total + MPC_CRASH_COST + 100 * (fabs( l.vx ) + fabs( l.vy )) + 10 * fabs( l.x - padCentre );
+      }
+    }
+
+    total += guidance( l.x, l.y, l.vx, l.vy, l.o );
+  }
+
+  return total + MPC_FUEL_WEIGHT * (fuel0 - l.fuel);
+}
+
+
+Controls MpcAutopilot::controls( Session &session, float deltaT )
+
+{
+  if (!session.running())
+    return CONTROL_NONE;
+
+  typedef chrono::steady_clock Clock;
+  Clock::time_point start = (budget > 0 ? Clock::now() : Clock::time_point());
+
+  Lander *lander = session.getLander();
+
+  // A new game, or a jump in time (e.g. a rewind), starts a new plan
+
+  if (session.getTime() < lastTime || session.getTime() > lastTime + 1.5 * deltaT) {
+    for (int b=0; b<MPC_BLOCKS; b++)
+      plan[b] = 0;
+    stepInBlock = 0;
+    pad = -1;
+  }
+  lastTime = session.getTime();
+
+  x0    = lander->centrePosition().x;
+  y0    = lander->centrePosition().y;
+  vx0   = lander->getVelocity().x;
+  vy0   = lander->getVelocity().y;
+  o0    = lander->getOrientation();
+  fuel0 = lander->fuel();
+  dt    = deltaT;
+
+  // Head for the nearest pad (chosen once per game, so that the
+  // lander does not hesitate between two)
+
+  if (pad < 0)
+    pad = terrain->nearestPad( x0 );
+  if (pad < 0)
+    return CONTROL_NONE;
+
+  const MpcTerrain::Pad &target = terrain->pads[pad];
+
+  padCentre = 0.5f * (target.left + target.right);
+  padFree   = 0.5f * (target.right - target.left) - 0.5f * terrain->landerWidth - MPC_PAD_MARGIN;
+  padTop    = target.y + 0.5f * terrain->landerHeight;
+
+  // Terrain between here and the pad, apart from the pad itself
+
+  if (x0 < target.left)
+    clearY = terrain->highest( x0, target.left - MPC_CELL );
+  else if (x0 > target.right)
+    clearY = terrain->highest( target.right + MPC_CELL, x0 );
+  else
+    clearY = -MAXFLOAT;
+
+  clearY += 0.5f * terrain->landerHeight + MPC_CLEARANCE;
+
+  // Improve the plan by changing one block at a time (a block may be
+  // the same as its neighbour, so the search can also lengthen or
+  // shorten a manoeuvre).  A block once started is kept to its end,
+  // so that heldSteps() can promise its controls.
+
+  // With a budget, the time of the warm start's cost() is the estimate
+  // of an iteration, and the search stops before one would overrun.
+
+  Clock::time_point costStart = (budget > 0 ? Clock::now() : Clock::time_point());
+  float best = cost( plan );
+  double estimate = (budget > 0 ? chrono::duration<double>( Clock::now() - costStart ).count() : 0);
+
+  uniform_int_distribution<int> anyBlock( (stepInBlock > 0 ? 1 : 0), MPC_BLOCKS - 1 );
+  uniform_int_distribution<int> otherOption( 1, MPC_OPTIONS - 1 );
+
+  for (int i=0; i<maxIterations; i++) {
+
+    if (budget > 0 && chrono::duration<double>( Clock::now() - start ).count() + estimate > budget)
+      break;
+
+    int b = anyBlock( rng );
+    unsigned char old = plan[b];
+
+    plan[b] = (old + otherOption( rng )) % MPC_OPTIONS;
+
+    float c = cost( plan );
+
+    if (c < best)
+      best = c;
+    else
+      plan[b] = old;
+
+    iterations++;
+  }
+
+  steps++;
+
+  Controls c = options[plan[0]];
+
+  advance( 1 );
+
+  return c;
+}
+
+
+// Move the plan on by 'numSteps' steps
+
+void MpcAutopilot::advance( int numSteps )
+
+{
+  for (int i=0; i<numSteps; i++)
+    if (++stepInBlock == MPC_BLOCK_STEPS) {
+      for (int b=1; b<MPC_BLOCKS; b++)
+        plan[b-1] = plan[b];
+      stepInBlock = 0;
+    }
+}
+
+
+void MpcAutopilot::skip( int numSteps, float deltaT )
+
+{
+  advance( numSteps );
+  lastTime += numSteps * deltaT;
+}
@@ -0,0 +1,188 @@
+// mpcAutopilot.h
+//
+// A model-predictive autopilot: at each step it improves a short plan
+// of controls that flies the lander toward a landing pad, and applies
+// the first step of the plan.
+//
+// A plan is MPC_BLOCKS blocks of MPC_BLOCK_STEPS steps, each block
+// holding one of the MPC_OPTIONS control combinations.  A plan is
+// scored by simulating the lander through it with the Lander's own
+// update (rotation, then thrust, then the explicit Euler step of
+// Lander::updatePose()) over a coarse profile of the terrain, with a
+// reward for a landing, a cost for a crash, and a guidance cost at
+// the end of each block for the velocity that glides to the pad.
+//
+// Each step starts from the last plan moved on by one step (a warm
+// start) and tries changing single blocks, keeping the best plan so
+// far, until a time budget or an iteration limit is reached.  So a
+// plan is always ready and the cost per step is bounded, and hundreds
+// of landers can fly at once.  With no time budget the controls
+// depend only on the session and the seed.
+//
+// The pad is the nearest flat segment wide enough to land on with
+// MPC_PAD_MARGIN to spare on each side (see
+// Landscape::isSegmentGoodToLand()).
+
+
+#ifndef MPCAUTOPILOT_H
+#define MPCAUTOPILOT_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "input.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+#define MPC_BLOCKS        8	// blocks in a plan
+#define MPC_BLOCK_STEPS   10	// steps in a block
+#define MPC_OPTIONS       6	// control combinations for a block
+#define MPC_BUDGET_US     20	// default time per step (microseconds)
+#define MPC_MAX_ITERATIONS 64	// default most plans tried per step
+
+#define MPC_CELL          1	// width of the cells of the terrain profile (m)
+#define MPC_PAD_MARGIN    1	// room to spare on each side of a pad (m)
+#define MPC_CLEARANCE     25	// height kept above the terrain on the way to the pad (m)
+#define MPC_LAND_TILT     (4 * M_PI / 180) // largest tilt aimed for at touchdown (radians)
+
+
+// A lander in a prediction, stepped as Session::step() steps it with
+// the explicit Euler update, without the terrain
+
+struct PredictedLander {
+  float x, y, vx, vy, o;
+  int   fuel;
+  float sinO, cosO, trigO;	// sin and cos of trigO, kept between steps
+
+  void start( float px, float py, float pvx, float pvy, float orient, int f ) {
+    x = px; y = py; vx = pvx; vy = pvy; o = orient; fuel = f;
+    trigO = o; sinO = sin( o ); cosO = cos( o );
+  }
+
+  void step( Controls ctl, float dt ) {
+    if ((ctl & CONTROL_ROTATE_CW) && fuel > 0) {
+      o -= ROTATION_SPEED * dt;
+      fuel--;
+    }
+    if ((ctl & CONTROL_ROTATE_CCW) && fuel > 0) {
+      o += ROTATION_SPEED * dt;
+      fuel--;
+    }
+    if ((ctl & CONTROL_THRUST) && fuel > 0) {
+      if (o != trigO) {
+        trigO = o; sinO = sin( o ); cosO = cos( o );
+      }
+      vx -= THRUST_ACCEL * sinO * dt;
+      vy += THRUST_ACCEL * cosO * dt;
+      fuel--;
+    }
+    x += dt * vx;
+    y += dt * vy;
+    vy -= GRAVITY_ACCEL * dt;
+  }
+
+  // Slow and upright enough to land
+
+  bool canLand() { return fabs( vx ) < LANDING_MAX_VX && fabs( vy ) < LANDING_MAX_VY && fabs( o ) < MPC_LAND_TILT; }
+};
+
+
+// The terrain as the autopilot sees it: the highest point in each
+// cell, and the pads.  One is shared by all the autopilots over a
+// landscape.
+
+class MpcTerrain {
+
+  vector<float> heights;	// highest terrain in each MPC_CELL-wide cell
+
+ public:
+
+  struct Pad {
+    float left, right;		// x range (m)
+    float y;			// height (m)
+  };
+
+  vector<Pad> pads;
+  float landerWidth, landerHeight;
+
+  MpcTerrain( Landscape *landscape, vec3 landerDimensions );
+
+  // Highest terrain in the cell of 'x', or over [x0,x1]
+
+  float height( float x ) {
+    int c = (int) (x * (1.0f / MPC_CELL));
+    return heights[c < 0 ? 0 : c >= (int) heights.size() ? heights.size() - 1 : c];
+  }
+
+  float highest( float x0, float x1 );
+
+  // Altitude of the base of a lander centred at (x,y): exact where the
+  // lander is wholly over pad 'p' (and 'onPad' is set), and otherwise
+  // above the highest terrain in the cell
+
+  float altitude( const Pad &p, float x, float y, bool &onPad ) {
+    onPad = (x - 0.5f * landerWidth > p.left && x + 0.5f * landerWidth < p.right);
+    return y - 0.5f * landerHeight - (onPad ? p.y : height( x ));
+  }
+
+  // The pad nearest to 'x' (-1 if there are none)
+
+  int nearestPad( float x );
+};
+
+
+class MpcAutopilot : public InputSource {
+
+  MpcTerrain *terrain;
+  double      budget;		// seconds per step (0 for no limit)
+  int         maxIterations;
+
+  unsigned char plan[MPC_BLOCKS]; // option of each block
+  int         stepInBlock;	// steps of the first block already taken
+  float       lastTime;		// session time at the last step, to see restarts
+  minstd_rand rng;
+
+  // The state the plans start from, and the target
+
+  float x0, y0, vx0, vy0, o0;
+  int   fuel0;
+  float dt;
+  int   pad;
+  float padCentre, padFree, padTop; // centre, room for the lander's centre, and the centre's height on it
+  float clearY;			// lowest safe height for the centre on the way to the pad
+
+  float cost( const unsigned char *p );
+  void  advance( int numSteps );
+  float guidance( float x, float y, float vx, float vy, float o );
+
+ public:
+
+  long  iterations;		// plans tried, over all steps
+  long  steps;
+
+  static const Controls options[MPC_OPTIONS];
+
+  // 'budgetMicroseconds' of 0 limits each step by 'iterationLimit' alone
+
+  MpcAutopilot( MpcTerrain *t, double budgetMicroseconds = MPC_BUDGET_US, int iterationLimit = MPC_MAX_ITERATIONS );
+
+  // Forget the plan, and draw later changes from 'seed'
+
+  void restart( unsigned int seed = 1 );
+
+  Controls controls( Session &session, float deltaT );
+
+  // The rest of the block in progress, which the search keeps.  Held
+  // steps (see Session::stepAdaptive()) move the plan on, rather than
+  // looking like a jump in time.
+
+  int  heldSteps( Session &session, float deltaT ) { return (stepInBlock > 0 ? MPC_BLOCK_STEPS - stepInBlock : 0); }
+  void skip( int numSteps, float deltaT );
+
+  int target() { return pad; }
+};
+
+
+#endif
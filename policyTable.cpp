@@ -0,0 +1,592 @@
+// policyTable.cpp
+
+
+#include "policyTable.h"
+#include "replay.h"
+
+#include <algorithm>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// Each axis runs from -lo to hi with points spaced 'step' apart at
+// zero, and the spacing growing by 'growth' from one to the next (at
+// a resolution of 1)
+
+#define POLICY_H_AXIS   0, 600, 0.25, 1.5	// m
+#define POLICY_DX_AXIS  LANDSCAPE_WIDTH, LANDSCAPE_WIDTH, 1, 1.6 // m
+#define POLICY_VX_AXIS  40, 40, 0.25, 1.5	// m/s
+#define POLICY_VY_AXIS  40, 10, 0.25, 1.4	// m/s
+#define POLICY_O_AXIS   1.2, 1.2, 0.035, 1.6	// radians
+
+
+// ---------------- PolicyGrid ----------------
+
+
+void PolicyGrid::setAxes( const int *sizes, const float *const *axes )
+
+{
+  numCells = 1;
+
+  for (int d=POLICY_DIMS-1; d>=0; d--) {
+    size[d]   = sizes[d];
+    axis[d]   = axes[d];
+    stride[d] = numCells;
+    numCells *= size[d];
+  }
+}
+
+
+void PolicyGrid::relativeState( const PredictedLander &l, const MpcTerrain::Pad &pad, float halfHeight, float *state )
+
+{
+  state[0] = l.y - halfHeight - pad.y;
+  state[1] = l.x - 0.5f * (pad.left + pad.right);
+  state[2] = l.vx;
+  state[3] = l.vy;
+  state[4] = l.o;
+}
+
+
+float PolicyGrid::corners( const float *state, long *cells, float *weights )
+
+{
+  long  base = 0;
+  float t[POLICY_DIMS];
+  float outside = 0;
+
+  for (int d=0; d<POLICY_DIMS; d++) {
+
+    const float *a = axis[d];
+    int n = size[d];
+    float v = min( a[n-1], max( a[0], state[d] ) );
+
+    outside += (state[d] - v) / (v > 0 ? a[n-1] - a[n-2] : a[0] - a[1]);
+
+    // The last point at or below v (but not the last point, so that
+    // there is one above)
+
+    int i = (int) (upper_bound( a, a + n, v ) - a) - 1;
+    i = min( n-2, max( 0, i ) );
+
+    t[d] = (v - a[i]) / (a[i+1] - a[i]);
+    base += i * stride[d];
+  }
+
+  // Corner c takes the upper point on axis d if bit d of c is set.
+  // Build the weights and cells up one axis at a time.
+
+  weights[0] = 1;
+  cells[0]   = base;
+
+  for (int d=0; d<POLICY_DIMS; d++)
+    for (int c=0; c<(1 << d); c++) {
+      weights[c + (1 << d)] = weights[c] * t[d];
+      weights[c]           *= 1 - t[d];
+      cells[c + (1 << d)]   = cells[c] + stride[d];
+    }
+
+  return outside;
+}
+
+
+template <class T>
+float PolicyGrid::interpolate( const T *costs, const float *state, float scale )
+
+{
+  long  cells[1 << POLICY_DIMS];
+  float weights[1 << POLICY_DIMS];
+
+  float outside = corners( state, cells, weights );
+
+  float sum = 0;
+  for (int c=0; c<(1 << POLICY_DIMS); c++)
+    sum += weights[c] * costs[cells[c]];
+
+  return sum * scale + POLICY_OUTSIDE_COST * outside;
+}
+
+
+// ---------------- holdCost ----------------
+
+
+// Cost of touching down at 'l': nothing within the safe limits, and
+// rising steadily to POLICY_MISS_COST at the limits of a landing and
+// beyond (so that the cost to go has no cliff at the edge of a
+// landing for the interpolation to blur), plus POLICY_CRASH_COST off
+// the pad
+
+static float touchdownCost( const PredictedLander &l, bool onPad )
+
+{
+  float miss = max( 0.0f, fabs( l.vx ) - (float) POLICY_SAFE_VX ) / (float) (LANDING_MAX_VX - POLICY_SAFE_VX)
+             + max( 0.0f, fabs( l.vy ) - (float) POLICY_SAFE_VY ) / (float) (LANDING_MAX_VY - POLICY_SAFE_VY)
+             + max( 0.0f, fabs( l.o ) - (float) POLICY_SAFE_TILT ) / (float) (MPC_LAND_TILT - POLICY_SAFE_TILT);
+
+  return POLICY_MISS_COST * miss + (onPad ? 0 : POLICY_CRASH_COST);
+}
+
+
+float holdCost( PredictedLander &l, Controls c, int steps, float dt, MpcTerrain &terrain, const MpcTerrain::Pad &pad, bool &ended )
+
+{
+  int   fuel0 = l.fuel;
+  float touchdown = 0;
+  int   j;
+
+  ended = false;
+
+  for (j=0; j<steps && !ended; j++) {
+
+    l.step( c, dt );
+
+    bool onPad;
+
+    if (terrain.altitude( pad, l.x, l.y, onPad ) < TOUCHDOWN_ALTITUDE) {
+      ended = true;
+      touchdown = touchdownCost( l, onPad );
+    }
+  }
+
+  return j * dt * POLICY_TIME_COST + POLICY_FUEL_COST * (fuel0 - l.fuel) + touchdown;
+}
+
+
+// ---------------- PolicyTable ----------------
+
+
+PolicyTable::~PolicyTable()
+
+{
+  if (base)
+    munmap( base, bytes );
+}
+
+
+// Whether 'count' items of 'itemSize' bytes from 'offset' fit in a file
+// of 'size' bytes
+
+static bool fits( uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t size )
+
+{
+  return offset <= size && count <= (size - offset) / itemSize;
+}
+
+
+bool PolicyTable::open( const char *path, Landscape *landscape )
+
+{
+  int fd = ::open( path, O_RDONLY );
+  if (fd < 0) {
+    cerr << "Could not open policy table " << path << endl;
+    return false;
+  }
+
+  struct stat st;
+  void *p = MAP_FAILED;
+
+  if (fstat( fd, &st ) == 0 && st.st_size >= (off_t) sizeof(PolicyHeader))
+    p = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+
+  if (p == MAP_FAILED) {
+    cerr << "Could not read policy table " << path << endl;
+    return false;
+  }
+
+  const PolicyHeader *h = (const PolicyHeader *) p;
+
+  if (h->magic != POLICY_MAGIC || h->version != POLICY_VERSION) {
+    cerr << path << " is not a policy table" << endl;
+    munmap( p, st.st_size );
+    return false;
+  }
+
+  if (h->landscapeHash != Replay::hashLandscape( landscape )) {
+    cerr << path << " is for another landscape" << endl;
+    munmap( p, st.st_size );
+    return false;
+  }
+
+  // The axes, pads and tables must be where the grid will read them
+
+  uint64_t cells = 1, axisFloats = 0;
+  bool     valid = true;
+
+  for (int d=0; d<POLICY_DIMS; d++) {
+    if (h->axisSize[d] < 2 || h->axisSize[d] > POLICY_MAX_AXIS)
+      valid = false;
+    cells *= h->axisSize[d];
+    axisFloats += h->axisSize[d];
+  }
+
+  if (!valid || cells != h->cellsPerTable ||
+      h->axisOffset % sizeof(float) != 0 || h->padOffset % sizeof(float) != 0 || h->tableOffset % sizeof(uint16_t) != 0 ||
+      !fits( h->axisOffset, axisFloats, sizeof(float), st.st_size ) ||
+      !fits( h->padOffset, h->numPads, sizeof(MpcTerrain::Pad), st.st_size )) {
+    cerr << path << " is not a policy table" << endl;
+    munmap( p, st.st_size );
+    return false;
+  }
+
+  if (h->cellsPerTable == 0 || !fits( h->tableOffset, h->numPads, h->cellsPerTable * sizeof(uint16_t), st.st_size )) {
+    cerr << path << " is truncated" << endl;
+    munmap( p, st.st_size );
+    return false;
+  }
+
+  base   = (char *) p;
+  bytes  = st.st_size;
+  header = h;
+  pads   = (const MpcTerrain::Pad *) (base + h->padOffset);
+  tables = (const uint16_t *) (base + h->tableOffset);
+
+  int          sizes[POLICY_DIMS];
+  const float *axes[POLICY_DIMS];
+  const float *a = (const float *) (base + h->axisOffset);
+
+  for (int d=0; d<POLICY_DIMS; d++) {
+    sizes[d] = h->axisSize[d];
+    axes[d]  = a;
+    a += sizes[d];
+  }
+
+  grid.setAxes( sizes, axes );
+
+  return true;
+}
+
+
+int PolicyTable::nearestPad( float x )
+
+{
+  int   best = -1;
+  float bestDist = MAXFLOAT;
+
+  for (unsigned int i=0; i<header->numPads; i++) {
+    float d = fabs( x - 0.5f * (pads[i].left + pads[i].right) );
+    if (d < bestDist) {
+      best = i;
+      bestDist = d;
+    }
+  }
+
+  return best;
+}
+
+
+float PolicyTable::costToGo( int p, const PredictedLander &l )
+
+{
+  float state[POLICY_DIMS];
+
+  PolicyGrid::relativeState( l, pads[p], 0.5f * header->landerHeight, state );
+
+  return grid.interpolate( tables + p * header->cellsPerTable, state, header->maxCost / 0xffff );
+}
+
+
+// ---------------- PolicyBuilder ----------------
+
+
+// Points over [-lo,hi] spaced 'step' apart at zero, further apart by
+// 'growth' each time.  A higher 'resolution' makes the growth smaller
+// (but not the step, which is what a landing needs).
+
+static void makeAxis( vector<float> &a, float lo, float hi, float step, float growth, float resolution )
+
+{
+  growth = 1 + (growth - 1) / resolution;
+
+  vector<float> side;		// distances from zero
+  float d = step;
+
+  while (d < max( lo, hi )) {
+    side.push_back( d );
+    step *= growth;
+    d += step;
+  }
+  side.push_back( d );
+
+  a.clear();
+
+  for (int i=side.size()-1; i>=0; i--)
+    if (lo > 0 && (i == 0 || side[i-1] < lo))
+      a.push_back( -min( side[i], lo ) );
+
+  a.push_back( 0 );
+
+  for (unsigned int i=0; i<side.size(); i++)
+    if (hi > 0 && (i == 0 || side[i-1] < hi))
+      a.push_back( min( side[i], hi ) );
+}
+
+
+PolicyBuilder::PolicyBuilder( MpcTerrain *t, float resolution )
+
+{
+  terrain = t;
+  pad     = -1;
+
+  makeAxis( axes[0], POLICY_H_AXIS, resolution );
+  makeAxis( axes[1], POLICY_DX_AXIS, resolution );
+  makeAxis( axes[2], POLICY_VX_AXIS, resolution );
+  makeAxis( axes[3], POLICY_VY_AXIS, resolution );
+  makeAxis( axes[4], POLICY_O_AXIS, resolution );
+
+  int          sizes[POLICY_DIMS];
+  const float *a[POLICY_DIMS];
+
+  for (int d=0; d<POLICY_DIMS; d++) {
+    sizes[d] = axes[d].size();
+    a[d]     = &axes[d][0];
+  }
+
+  grid.setAxes( sizes, a );
+}
+
+
+// Update the cells of one chunk of the current slab from 'cost' into
+// 'next'
+
+void PolicyBuilder::sweepCells( int chunk )
+
+{
+  const MpcTerrain::Pad &p = terrain->pads[pad];
+
+  float centre     = 0.5f * (p.left + p.right);
+  float halfHeight = 0.5f * terrain->landerHeight;
+  float largest    = 0;
+
+  long first = slab * grid.stride[0] + (long) chunk * POLICY_CHUNK;
+  long last  = min( (slab + 1) * grid.stride[0], first + POLICY_CHUNK );
+
+  for (long cell=first; cell<last; cell++) {
+
+    float s[POLICY_DIMS];
+    for (int d=0; d<POLICY_DIMS; d++)
+      s[d] = grid.axis[d][(cell / grid.stride[d]) % grid.size[d]];
+
+    float best = POLICY_MAX_COST;
+
+    for (int a=0; a<MPC_OPTIONS; a++) {
+
+      PredictedLander l;
+      l.start( centre + s[1], p.y + halfHeight + s[0], s[2], s[3], s[4], INITIAL_FUEL );
+
+      bool  ended;
+      float c = holdCost( l, MpcAutopilot::options[a], POLICY_HOLD_STEPS, POLICY_STEP_TIME, *terrain, p, ended );
+
+      if (!ended && c < best) {
+
+        float state[POLICY_DIMS];
+        long  cells[1 << POLICY_DIMS];
+        float weights[1 << POLICY_DIMS];
+
+        PolicyGrid::relativeState( l, p, halfHeight, state );
+        c += POLICY_OUTSIDE_COST * grid.corners( state, cells, weights );
+
+        // A hold that ends near where it started (as it does over the
+        // coarse cells far from the pad) leans mostly on this cell's
+        // own cost, which would take many sweeps to settle, so solve
+        // for it: c' = c + w c' + (the rest)
+
+        float rest = 0, own = 0;
+
+        for (int k=0; k<(1 << POLICY_DIMS); k++)
+          if (cells[k] == cell)
+            own += weights[k];
+          else
+            rest += weights[k] * cost[cells[k]];
+
+        c = (own < 0.999f ? (c + rest) / (1 - own) : POLICY_MAX_COST);
+      }
+
+      best = min( best, c );
+    }
+
+    next[cell] = best;
+    largest = max( largest, fabs( best - cost[cell] ) );
+  }
+
+  change[chunk] = largest;
+}
+
+
+void PolicyBuilder::sweepTask( void *builder, int chunk )
+
+{
+  ((PolicyBuilder *) builder)->sweepCells( chunk );
+}
+
+
+int PolicyBuilder::solve( int p, ThreadPool &pool, int maxSweeps, float tolerance )
+
+{
+  long slabCells = grid.stride[0];
+  int  chunks = (slabCells + POLICY_CHUNK - 1) / POLICY_CHUNK;
+
+  // Start from the cost of a crash everywhere, so that the costs only
+  // fall as landings are found, and a state that cannot land keeps
+  // about the cost of a crash rather than growing by the hold time at
+  // every sweep
+
+  pad = p;
+  cost.assign( grid.numCells, POLICY_CRASH_COST );
+  next.assign( grid.numCells, POLICY_CRASH_COST );
+  change.assign( chunks, 0 );
+
+  int sweeps = 0;
+
+  while (sweeps < maxSweeps) {
+
+    // A sweep goes up through the slabs of equal height, and each slab
+    // sees the slabs below it as they are after this sweep, so that a
+    // descent to the pad is costed in one sweep rather than one sweep
+    // per hold.  The cells of a slab see each other as they were, so
+    // the threads do not change the result.
+
+    float largest = 0;
+
+    for (slab=0; slab<grid.size[0]; slab++) {
+
+      pool.run( sweepTask, this, chunks );
+
+      copy( next.begin() + slab * slabCells, next.begin() + (slab + 1) * slabCells, cost.begin() + slab * slabCells );
+      largest = max( largest, *max_element( change.begin(), change.end() ) );
+    }
+
+    sweeps++;
+
+    if (largest <= tolerance)
+      break;
+  }
+
+  // Store the costs in 16 bits
+
+  vector<uint16_t> table( grid.numCells );
+
+  for (long i=0; i<grid.numCells; i++)
+    table[i] = (uint16_t) (min( 1.0f, max( 0.0f, cost[i] / (float) POLICY_MAX_COST ) ) * 0xffff + 0.5f);
+
+  tables.push_back( table );
+  padsSolved.push_back( p );
+
+  return sweeps;
+}
+
+
+bool PolicyBuilder::write( const char *path, Landscape *landscape )
+
+{
+  PolicyHeader h;
+
+  memset( &h, 0, sizeof(h) );
+
+  h.magic         = POLICY_MAGIC;
+  h.version       = POLICY_VERSION;
+  h.landscapeHash = Replay::hashLandscape( landscape );
+  h.numPads       = tables.size();
+  h.holdSteps     = POLICY_HOLD_STEPS;
+  h.stepTime      = POLICY_STEP_TIME;
+  h.maxCost       = POLICY_MAX_COST;
+  h.landerWidth   = terrain->landerWidth;
+  h.landerHeight  = terrain->landerHeight;
+
+  uint64_t axisFloats = 0;
+  for (int d=0; d<POLICY_DIMS; d++) {
+    h.axisSize[d] = axes[d].size();
+    axisFloats += axes[d].size();
+  }
+
+  // Layout: the header, the axes, the pads, then the tables (starting
+  // on a cache line)
+
+  h.axisOffset    = sizeof(PolicyHeader);
+  h.padOffset     = h.axisOffset + axisFloats * sizeof(float);
+  h.tableOffset   = (h.padOffset + tables.size() * sizeof(MpcTerrain::Pad) + 63) & ~(uint64_t) 63;
+  h.cellsPerTable = grid.numCells;
+
+  ofstream out( path, ios::binary );
+
+  out.write( (const char *) &h, sizeof(h) );
+
+  for (int d=0; d<POLICY_DIMS; d++)
+    out.write( (const char *) &axes[d][0], axes[d].size() * sizeof(float) );
+
+  for (unsigned int i=0; i<padsSolved.size(); i++)
+    out.write( (const char *) &terrain->pads[padsSolved[i]], sizeof(MpcTerrain::Pad) );
+
+  char zeros[64] = { 0 };
+  out.write( zeros, h.tableOffset - (h.padOffset + tables.size() * sizeof(MpcTerrain::Pad)) );
+
+  for (unsigned int i=0; i<tables.size(); i++)
+    out.write( (const char *) &tables[i][0], tables[i].size() * sizeof(uint16_t) );
+
+  if (!out) {
+    cerr << "Could not write policy table " << path << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+// ---------------- PolicyController ----------------
+
+
+PolicyController::PolicyController( PolicyTable *t, MpcTerrain *tr )
+
+{
+  table   = t;
+  terrain = tr;
+
+  restart();
+}
+
+
+Controls PolicyController::controls( Session &session, float deltaT )
+
+{
+  if (!session.running())
+    return CONTROL_NONE;
+
+  if (session.getTime() < lastTime || session.getTime() > lastTime + 1.5 * deltaT)
+    pad = -1;
+  lastTime = session.getTime();
+
+  Lander *lander = session.getLander();
+  vec3    p = lander->centrePosition(), v = lander->getVelocity();
+
+  if (pad < 0)
+    pad = table->nearestPad( p.x );
+  if (pad < 0)
+    return CONTROL_NONE;
+
+  // The action whose hold (as the table was made with) ends best
+
+  Controls best = CONTROL_NONE;
+  float    bestCost = MAXFLOAT;
+
+  for (int a=0; a<MPC_OPTIONS; a++) {
+
+    PredictedLander l;
+    l.start( p.x, p.y, v.x, v.y, lander->getOrientation(), lander->fuel() );
+
+    bool  ended;
+    float c = holdCost( l, MpcAutopilot::options[a], table->holdSteps(), table->stepTime(), *terrain, table->pad( pad ), ended );
+
+    if (!ended)
+      c += table->costToGo( pad, l );
+
+    if (c < bestCost) {
+      best = MpcAutopilot::options[a];
+      bestCost = c;
+    }
+  }
+
+  return best;
+}
@@ -0,0 +1,217 @@
+// policyTable.h
+//
+// Guidance tables computed offline: for each pad, the cost to go
+// (the time, fuel and risk of the best landing) over a grid of states
+// relative to the pad, found by dynamic programming (value iteration)
+// and stored in a file that is used in place through mmap().
+//
+// The state is the lander's height h (of its base above the pad) and
+// position dx (from the pad's centre), its velocity and its
+// orientation.  The points on each axis are closest together near
+// zero, where a landing needs precision, and the positions span the
+// world.  Fuel is not an axis: a full tank is nearly three minutes of
+// thrust, so it is a cost instead.
+//
+// An action is one of the autopilot's control combinations (see
+// mpcAutopilot.h) held for POLICY_HOLD_STEPS steps.  The cost to go
+// of a cell is the least, over the actions, of the cost of the hold
+// plus the cost to go from where it ends (interpolated multilinearly
+// between the cells around it), or of the touchdown if the lander
+// touches down during it.  A touchdown costs more the further it is
+// from the safe limits, rather than all or nothing, so that the cost
+// to go is smooth enough to interpolate.
+//
+// Sweeps update the cells a slab of equal height at a time, from the
+// bottom up, until nothing changes by more than a tolerance.  The
+// cells of a slab are shared out among threads, and see the slabs
+// below as updated and their own slab as it was, so the result does
+// not depend on the threads.
+//
+// PolicyController flies with a table: at each step it takes the
+// action whose hold from the current state ends with the least cost
+// to go, which is six short simulations and interpolations.
+
+
+#ifndef POLICYTABLE_H
+#define POLICYTABLE_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "input.h"
+#include "mpcAutopilot.h"
+#include "threadPool.h"
+#include <stdint.h>
+#include <vector>
+
+
+#define POLICY_MAGIC   0x54504c4c	// "LLPT"
+#define POLICY_VERSION 1
+
+#define POLICY_DIMS       5	// h, dx, vx, vy, orientation
+#define POLICY_HOLD_STEPS 15	// steps an action is held for
+#define POLICY_STEP_TIME  (1/60.0) // of each step (s)
+
+#define POLICY_TIME_COST  1	// per second
+#define POLICY_FUEL_COST  0.002	// per unit of fuel
+#define POLICY_CRASH_COST 500	// for touching down off the pad
+#define POLICY_MISS_COST  100	// for touching down at the limits of a landing
+#define POLICY_SAFE_VX    0.25	// touchdowns within these cost nothing (m/s)
+#define POLICY_SAFE_VY    0.5
+#define POLICY_SAFE_TILT  (2 * M_PI / 180) // (radians)
+#define POLICY_OUTSIDE_COST 10	// per cell beyond the edge of the grid
+#define POLICY_MAX_COST   1000	// largest cost to go stored (costs are stored in 16 bits)
+#define POLICY_CHUNK      4096	// cells per thread pool task
+#define POLICY_MAX_AXIS   4096	// most points on an axis in a table file
+
+
+// The file starts with a PolicyHeader.  The offsets are in bytes from
+// the start of the file; everything is little-endian.
+
+struct PolicyHeader {
+  uint32_t magic, version;
+  uint32_t landscapeHash;	// of the landscape (see Replay::hashLandscape())
+  uint32_t numPads;
+  uint32_t holdSteps;
+  float    stepTime;
+  float    maxCost;		// cost to go of a stored 0xffff
+  float    landerWidth, landerHeight;
+  uint32_t axisSize[POLICY_DIMS];
+  uint64_t axisOffset;		// float values of each axis in turn
+  uint64_t padOffset;		// MpcTerrain::Pad of each table
+  uint64_t tableOffset;		// uint16_t cost to go of each cell, one table per pad
+  uint64_t cellsPerTable;
+};
+
+
+// Axes and multilinear interpolation over a grid of costs
+
+class PolicyGrid {
+
+ public:
+
+  int          size[POLICY_DIMS];
+  const float *axis[POLICY_DIMS];
+  long         stride[POLICY_DIMS];
+  long         numCells;
+
+  void setAxes( const int *sizes, const float *const *axes );
+
+  // The state of 'l' relative to 'pad'
+
+  static void relativeState( const PredictedLander &l, const MpcTerrain::Pad &pad, float halfHeight, float *state );
+
+  // The cells around 'state' (which is clamped to the grid) and their
+  // weights.  Returns how far 'state' is outside the grid, in cells.
+
+  float corners( const float *state, long *cells, float *weights );
+
+  // The cost to go at 'state' from 'costs' (with 'scale' per unit),
+  // plus POLICY_OUTSIDE_COST per cell outside the grid
+
+  template <class T>
+  float interpolate( const T *costs, const float *state, float scale );
+};
+
+
+// A table file, mapped into memory
+
+class PolicyTable {
+
+  char *base;			// the mapped file (NULL until open())
+  size_t bytes;
+  const PolicyHeader *header;
+  PolicyGrid grid;
+  const MpcTerrain::Pad *pads;
+  const uint16_t *tables;
+
+ public:
+
+  PolicyTable() { base = NULL; bytes = 0; header = NULL; }
+  ~PolicyTable();
+
+  // Map the file 'path', made for 'landscape'.  Returns false if it
+  // cannot be read or is for another landscape.
+
+  bool open( const char *path, Landscape *landscape );
+
+  int numPads() { return header->numPads; }
+  const MpcTerrain::Pad &pad( int i ) { return pads[i]; }
+  int nearestPad( float x );
+
+  int   holdSteps() { return header->holdSteps; }
+  float stepTime() { return header->stepTime; }
+
+  // The cost to go for a lander at 'l' to pad 'p'
+
+  float costToGo( int p, const PredictedLander &l );
+};
+
+
+// Hold 'c' for 'steps' steps of 'dt' from 'l', over 'terrain' toward
+// 'pad'.  Returns the cost of the steps, and sets 'ended' if the
+// lander touched down (with the cost of the touchdown added).
+
+float holdCost( PredictedLander &l, Controls c, int steps, float dt, MpcTerrain &terrain, const MpcTerrain::Pad &pad, bool &ended );
+
+
+// Computes the tables
+
+class PolicyBuilder {
+
+  MpcTerrain   *terrain;
+  vector<float> axes[POLICY_DIMS];
+  PolicyGrid    grid;
+  vector<float> cost, next;	// of each cell, and the new costs of the slab being updated
+  vector<float> change;		// largest change in each chunk of a slab
+  int           pad;		// being solved
+  int           slab;		// cells at one height being updated
+
+  void sweepCells( int chunk );
+
+  static void sweepTask( void *builder, int chunk );
+
+ public:
+
+  vector< vector<uint16_t> > tables; // for each pad solved
+
+  vector<int> padsSolved;	// indices in terrain->pads
+
+  // 'resolution' scales the number of points on every axis (away
+  // from zero)
+
+  PolicyBuilder( MpcTerrain *t, float resolution = 1 );
+
+  long cells() { return grid.numCells; }
+
+  // Solve for pad 'p' with at most 'maxSweeps' sweeps, stopping once
+  // no cost changes by more than 'tolerance'.  Returns the sweeps.
+
+  int solve( int p, ThreadPool &pool, int maxSweeps, float tolerance );
+
+  // Write the tables solved so far
+
+  bool write( const char *path, Landscape *landscape );
+};
+
+
+// Flies the lander to the pad nearest its start with a table
+
+class PolicyController : public InputSource {
+
+  PolicyTable *table;
+  MpcTerrain  *terrain;
+  int          pad;		// in the table (-1 until chosen)
+  float        lastTime;	// session time at the last step, to see restarts
+
+ public:
+
+  PolicyController( PolicyTable *t, MpcTerrain *terrain );
+
+  void restart() { pad = -1; lastTime = MAXFLOAT; }
+
+  Controls controls( Session &session, float deltaT );
+};
+
+
+#endif
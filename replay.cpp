@@ -0,0 +1,263 @@
+// replay.cpp
+
+
+#include "replay.h"
+#include <cstring>
+#include <fstream>
+
+
+void Replay::begin( Session &session, float deltaT )
+
+{
+  stepTime      = deltaT;
+  flags         = ((session.getConfigObstacle() ? REPLAY_SHAPE : 0) | (session.getFixedTerrain() ? REPLAY_FIXED : 0) |
+                   (session.getContinuousCollision() ? REPLAY_CCD : 0) | (session.getOutlineCollision() ? REPLAY_OUTLINE : 0));
+  landscapeHash = hashLandscape( session.getLandscape() );
+  start         = session.getState();
+  end           = start;
+
+  steps.clear();
+}
+
+
+void Replay::play( Session &session )
+
+{
+  restart( session );
+
+  for (unsigned int i=0; i<steps.size(); i++)
+    session.step( steps[i], stepTime );
+}
+
+
+// FNV-1a over the model vertices
+
+uint32_t Replay::hashLandscape( Landscape *landscape )
+
+{
+  const unsigned char *p = (const unsigned char *) landscape->modelVertices();
+  size_t n = 2 * (landscape->numSegments() + 1) * sizeof(float);
+
+  uint32_t h = 2166136261u;
+
+  for (size_t i=0; i<n; i++) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+
+  return h;
+}
+
+
+// ---------------- encoding ----------------
+
+
+static void putVarint( vector<unsigned char> &b, uint64_t v )
+
+{
+  while (v >= 0x80) {
+    b.push_back( (v & 0x7f) | 0x80 );
+    v >>= 7;
+  }
+  b.push_back( v );
+}
+
+
+static void putFloat( vector<unsigned char> &b, float f )
+
+{
+  uint32_t v;
+  memcpy( &v, &f, 4 );
+
+  for (int i=0; i<4; i++)
+    b.push_back( (v >> (8*i)) & 0xff );
+}
+
+
+static void putInt( vector<unsigned char> &b, int v ) // zigzag, so small negatives are short
+
+{
+  putVarint( b, ((uint32_t) v << 1) ^ (uint32_t) (v >> 31) );
+}
+
+
+static void putState( vector<unsigned char> &b, const SessionState &s )
+
+{
+  putFloat( b, s.position.x );
+  putFloat( b, s.position.y );
+  putFloat( b, s.velocity.x );
+  putFloat( b, s.velocity.y );
+  putFloat( b, s.orientation );
+  putFloat( b, s.time );
+  putInt( b, s.fuel );
+  putInt( b, s.score );
+  putInt( b, s.startFuel );
+  putVarint( b, (s.running ? 1 : 0) | (s.win ? 2 : 0) );
+  putInt( b, s.lossReason );
+}
+
+
+void Replay::encode( vector<unsigned char> &b )
+
+{
+  b.clear();
+
+  for (int i=0; i<4; i++)
+    b.push_back( REPLAY_MAGIC[i] );
+
+  putVarint( b, REPLAY_VERSION );
+  putVarint( b, flags );
+  putFloat( b, stepTime );
+  putVarint( b, landscapeHash );
+  putState( b, start );
+  putState( b, end );
+  putVarint( b, steps.size() );
+
+  for (unsigned int i=0; i<steps.size(); ) {
+    unsigned int j = i+1;
+    while (j < steps.size() && steps[j] == steps[i])
+      j++;
+    putVarint( b, ((uint64_t) (j-i) << 6) | (steps[i] & 0x3f) );
+    i = j;
+  }
+}
+
+
+// ---------------- decoding ----------------
+
+
+// Reads from a buffer, and remembers if it ran past the end
+
+struct ReplayReader {
+
+  const unsigned char *p, *end;
+  bool ok;
+
+  ReplayReader( const unsigned char *b, size_t n ) { p = b; end = b + n; ok = true; }
+
+  uint64_t varint() {
+    uint64_t v = 0;
+    for (int shift=0; shift<64; shift+=7) {
+      if (p == end) {
+        ok = false;
+        return 0;
+      }
+      unsigned char c = *p++;
+      v |= (uint64_t) (c & 0x7f) << shift;
+      if (!(c & 0x80))
+        return v;
+    }
+    ok = false;
+    return 0;
+  }
+
+  float real() {
+    if (end - p < 4) {
+      ok = false;
+      return 0;
+    }
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    p += 4;
+    float f;
+    memcpy( &f, &v, 4 );
+    return f;
+  }
+
+  int integer() {
+    uint32_t v = varint();
+    return (int) ((v >> 1) ^ -(v & 1));
+  }
+
+  void state( SessionState &s ) {
+    s.position.x  = real();
+    s.position.y  = real();
+    s.position.z  = 0;
+    s.velocity.x  = real();
+    s.velocity.y  = real();
+    s.velocity.z  = 0;
+    s.orientation = real();
+    s.time        = real();
+    s.fuel        = integer();
+    s.score       = integer();
+    s.startFuel   = integer();
+    int f         = varint();
+    s.running     = (f & 1) != 0;
+    s.win         = (f & 2) != 0;
+    s.lossReason  = integer();
+  }
+};
+
+
+bool Replay::decode( const unsigned char *bytes, size_t size )
+
+{
+  if (size < 4 || memcmp( bytes, REPLAY_MAGIC, 4 ) != 0)
+    return false;
+
+  ReplayReader r( bytes + 4, size - 4 );
+
+  if (r.varint() != REPLAY_VERSION)
+    return false;
+
+  flags         = r.varint();
+  stepTime      = r.real();
+  landscapeHash = r.varint();
+  r.state( start );
+  r.state( end );
+
+  uint64_t n = r.varint();
+
+  if (!r.ok || n > REPLAY_MAX_STEPS)
+    return false;
+
+  steps.clear();
+  steps.reserve( n );
+
+  while (steps.size() < n && r.ok) {
+    uint64_t run = r.varint();
+    if ((run >> 6) == 0 || (run >> 6) > n - steps.size())
+      return false;
+    steps.insert( steps.end(), run >> 6, (Controls) (run & 0x3f) );
+  }
+
+  return r.ok && r.p == r.end;
+}
+
+
+bool Replay::write( const char *path )
+
+{
+  vector<unsigned char> bytes;
+  encode( bytes );
+
+  ofstream out( path, ios::binary );
+  out.write( (const char *) &bytes[0], bytes.size() );
+
+  if (!out) {
+    cerr << "Could not write replay " << path << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool Replay::read( const char *path )
+
+{
+  ifstream in( path, ios::binary );
+  vector<unsigned char> bytes( (istreambuf_iterator<char>( in )), istreambuf_iterator<char>() );
+
+  if (!in && !in.eof()) {
+    cerr << "Could not read replay " << path << endl;
+    return false;
+  }
+
+  if (bytes.empty() || !decode( &bytes[0], bytes.size() )) {
+    cerr << path << " is not a replay" << endl;
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,99 @@
+// replay.h
+//
+// Recorded sessions: the session state when recording started, the
+// controls of each step, and the state at the end, so that a replay
+// can be re-simulated headless (see llplay.cpp) and checked against
+// the recorded outcome.
+//
+// In a file, the controls are stored as runs of equal controls, each
+// a varint of (run length << 6 | controls), so a replay takes a byte
+// or two per change of the controls.  Floats are stored as their
+// bits, so the start state is exact.
+
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "input.h"
+#include <vector>
+#include <stdint.h>
+
+
+#define REPLAY_MAGIC   "LLRP"
+#define REPLAY_VERSION 1
+#define REPLAY_MAX_STEPS (1 << 28) // longest replay read (about 52 days at 60 Hz)
+
+// Session options that change the outcome, which playback must match
+
+#define REPLAY_SHAPE 0x01	// with a ConfigObstacle (see Session::setConfigObstacle())
+#define REPLAY_FIXED 0x02	// in fixed point (see Session::setFixedTerrain())
+#define REPLAY_CCD   0x04	// with continuous collision (see Session::setContinuousCollision())
+#define REPLAY_OUTLINE 0x08	// with outline collision (see Session::setOutlineCollision())
+
+
+class Replay {
+
+ public:
+
+  float        stepTime;	// seconds per step
+  unsigned int flags;		// REPLAY_*
+  uint32_t     landscapeHash;	// of the landscape recorded on (see hashLandscape())
+  SessionState start, end;
+  vector<Controls> steps;	// controls for each step
+
+  Replay() { stepTime = 0; flags = 0; landscapeHash = 0; }
+
+  // Start recording 'session', which is stepped by 'deltaT'
+
+  void begin( Session &session, float deltaT );
+
+  void add( Controls controls ) { steps.push_back( controls ); }
+
+  // Record the final state
+
+  void finish( Session &session ) { end = session.getState(); }
+
+  // Put 'session' in the start state
+
+  void restart( Session &session ) { session.setState( start ); }
+
+  // Step 'session' (from the start state) through the whole replay
+
+  void play( Session &session );
+
+  // Returns false (with a message on cerr) if the file cannot be
+  // written or read, or is not a replay
+
+  bool write( const char *path );
+  bool read( const char *path );
+
+  void encode( vector<unsigned char> &bytes );
+  bool decode( const unsigned char *bytes, size_t size );
+
+  static uint32_t hashLandscape( Landscape *landscape );
+};
+
+
+// An input source that records the controls of another in a replay
+
+class RecordingInput : public InputSource {
+
+  InputSource *source;
+  Replay      *replay;
+
+ public:
+
+  RecordingInput( InputSource *s, Replay *r ) { source = s; replay = r; }
+
+  Controls controls( Session &session, float deltaT ) {
+    Controls c = source->controls( session, deltaT );
+    replay->add( c );
+    return c;
+  }
+};
+
+
+#endif
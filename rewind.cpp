@@ -0,0 +1,71 @@
+// rewind.cpp
+
+
+#include "rewind.h"
+
+
+RewindBuffer::RewindBuffer( float deltaT, size_t budget, int snapshotInterval )
+
+{
+  stepTime = deltaT;
+  interval = max( 1, snapshotInterval );
+  capacity = max( 2, (int) (budget / (sizeof(SessionState) + interval * sizeof(Controls))) );
+
+  snapshots.resize( capacity );
+  controls.resize( (size_t) capacity * interval );
+
+  clear();
+}
+
+
+// The oldest snapshot that has not been overwritten.  The snapshot
+// ring holds the last 'capacity' snapshots written, and the controls
+// ring holds the steps from the oldest of them.
+
+long RewindBuffer::oldest()
+
+{
+  return max( 0L, written - capacity ) * interval;
+}
+
+
+void RewindBuffer::record( Session &session, Controls c )
+
+{
+  if (pos % interval == 0) {
+    snapshots[(pos / interval) % capacity] = session.getState();
+    written = max( written, pos / interval + 1 );
+  }
+
+  controls[pos % controls.size()] = c;
+
+  pos++;
+  end = pos;
+}
+
+
+long RewindBuffer::seek( Session &session, long step )
+
+{
+  step = min( max( step, oldest() ), end );
+
+  // From the snapshot at or before 'step' (or from the current state,
+  // if that is closer), step forward with the recorded controls
+
+  long from = step / interval * interval;
+
+  if (from == end && from > 0)	// (its snapshot is taken at its step)
+    from -= interval;
+
+  if (pos > step || pos < from) {
+    session.setState( snapshots[(from / interval) % capacity] );
+    pos = from;
+  }
+
+  while (pos < step) {
+    session.step( controls[pos % controls.size()], stepTime );
+    pos++;
+  }
+
+  return pos;
+}
@@ -0,0 +1,68 @@
+// rewind.h
+//
+// Rewind for a session: snapshots of the session state every
+// 'interval' steps, and the controls of every step since the oldest
+// snapshot, in rings that are allocated once, within a fixed memory
+// budget.  To go back to any step in the rings, the nearest snapshot
+// at or before it is restored (as SoftReset() restores a lander) and
+// the steps after it are simulated again with their recorded controls,
+// which is at most 'interval' steps.  Recording and seeking do no heap
+// allocation.
+
+
+#ifndef REWIND_H
+#define REWIND_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "input.h"
+#include <vector>
+
+
+#define REWIND_BUDGET   (256 * 1024) // default memory for a RewindBuffer (bytes)
+#define REWIND_INTERVAL 30	     // default steps between snapshots
+
+
+class RewindBuffer {
+
+  vector<SessionState> snapshots; // the state before step k*interval is in slot k % capacity
+  vector<Controls>     controls;  // the controls of step j are in slot j % (capacity*interval)
+  int   capacity;		// number of snapshots
+  int   interval;		// steps between snapshots
+  float stepTime;		// seconds per step
+  long  pos;			// steps from the start to the session's current state
+  long  end;			// steps recorded
+  long  written;		// one more than the highest snapshot written (which may be
+				// after 'end', after a seek back), or 0
+
+ public:
+
+  // Keep as many snapshots as fit in 'budget' bytes (at least two)
+
+  RewindBuffer( float deltaT, size_t budget = REWIND_BUDGET, int snapshotInterval = REWIND_INTERVAL );
+
+  // Forget all steps, and start again from the session's next step
+
+  void clear() { pos = end = written = 0; }
+
+  // Record that 'session' is about to take a step with 'controls'.
+  // This forgets any steps after the current one (from an earlier
+  // seek()).
+
+  void record( Session &session, Controls c );
+
+  // Put 'session' in its state after 'step' steps, or the nearest
+  // step kept, and return that step
+
+  long seek( Session &session, long step );
+
+  long position() { return pos; }	 // steps to the session's current state
+  long newest()   { return end; }	 // last step that can be sought
+  long oldest();			 // first step that can be sought
+
+  size_t bytes() { return snapshots.capacity() * sizeof(SessionState) + controls.capacity() * sizeof(Controls); }
+};
+
+
+#endif
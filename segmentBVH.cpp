@@ -0,0 +1,136 @@
+// segmentBVH.cpp
+
+
+#include "segmentBVH.h"
+
+
+void SegmentBVH::build( const float *v, int numVerts )
+
+{
+  verts   = v;
+  numSegs = (numVerts > 1 ? numVerts - 1 : 0);
+
+  nodes.clear();
+  nodes.reserve( 2 * (numSegs / BVH_LEAF_SIZE + 1) );
+
+  if (numSegs > 0)
+    build( 0, numSegs );
+}
+
+
+// Build the subtree over segments [first,last) and return its index
+
+int SegmentBVH::build( int first, int last )
+
+{
+  int index = nodes.size();
+  nodes.push_back( Node() );
+
+  Node n;
+
+  n.minX = n.maxX = verts[2*first];
+  n.minY = n.maxY = verts[2*first+1];
+
+  for (int i=first+1; i<=last; i++) { // vertices of segments first..last-1
+    float x = verts[2*i];
+    float y = verts[2*i+1];
+    if (x < n.minX) n.minX = x;
+    if (x > n.maxX) n.maxX = x;
+    if (y < n.minY) n.minY = y;
+    if (y > n.maxY) n.maxY = y;
+  }
+
+  n.first = first;
+  n.right = -1;
+
+  if (last - first <= BVH_LEAF_SIZE)
+    n.count = last - first;
+  else {
+    n.count = 0;
+    int mid = (first + last) / 2;
+    build( first, mid );	// left child is at index+1
+    n.right = build( mid, last );
+  }
+
+  nodes[index] = n;
+
+  return index;
+}
+
+
+// Squared distance from (px,py) to a node's bounding box
+
+static inline float boxDist2( float px, float py, float minX, float minY, float maxX, float maxY )
+
+{
+  float dx = (px < minX ? minX - px : (px > maxX ? px - maxX : 0));
+  float dy = (py < minY ? minY - py : (py > maxY ? py - maxY : 0));
+
+  return dx*dx + dy*dy;
+}
+
+
+// Depth-first search that visits the nearer child first and skips
+// any node whose box is no closer than the best segment so far.
+
+int SegmentBVH::nearestSegment( float px, float py, float &dist2, float maxDist2 ) const
+
+{
+  int   best      = -1;
+  float bestDist2 = maxDist2;
+
+  if (nodes.empty()) {
+    dist2 = bestDist2;
+    return -1;
+  }
+
+  int stack[BVH_MAX_DEPTH];
+  int top = 0;
+
+  stack[top++] = 0;
+
+  while (top > 0) {
+
+    int index = stack[--top];
+    const Node &n = nodes[index];
+
+    if (boxDist2( px, py, n.minX, n.minY, n.maxX, n.maxY ) >= bestDist2)
+      continue;
+
+    if (n.count > 0) {
+
+      for (int i=n.first; i<n.first+n.count; i++) {
+        float t;
+        float d2 = pointSegmentDist2( px, py, verts[2*i], verts[2*i+1], verts[2*i+2], verts[2*i+3], t );
+        if (d2 < bestDist2) {
+          bestDist2 = d2;
+          best = i;
+        }
+      }
+
+    } else {
+
+      int left  = index + 1;
+      int right = n.right;
+
+      const Node &l = nodes[left];
+      const Node &r = nodes[right];
+
+      float dl = boxDist2( px, py, l.minX, l.minY, l.maxX, l.maxY );
+      float dr = boxDist2( px, py, r.minX, r.minY, r.maxX, r.maxY );
+
+      // Push the farther child first, so the nearer one is searched first
+
+      if (dl < dr) {
+        if (dr < bestDist2) stack[top++] = right;
+        if (dl < bestDist2) stack[top++] = left;
+      } else {
+        if (dl < bestDist2) stack[top++] = left;
+        if (dr < bestDist2) stack[top++] = right;
+      }
+    }
+  }
+
+  dist2 = bestDist2;
+  return best;
+}
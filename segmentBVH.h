@@ -0,0 +1,118 @@
+// segmentBVH.h
+//
+// A bounding volume hierarchy over the segments of a polyline (the
+// landscape).  Since the landscape segments are in x order, each node
+// covers a contiguous run of segments, and the tree is stored in
+// preorder with the left child right after its parent.
+
+
+#ifndef SEGMENTBVH_H
+#define SEGMENTBVH_H
+
+
+#include "simHeaders.h"
+#include <vector>
+
+
+#define BVH_LEAF_SIZE 8		// maximum segments in a leaf
+#define BVH_MAX_DEPTH 64	// tree depth is about log2(segments/BVH_LEAF_SIZE)
+
+
+// Squared distance from (px,py) to the segment (x0,y0)-(x1,y1), and
+// the parameter 't' in [0,1] of the closest point on the segment
+
+inline float pointSegmentDist2( float px, float py, float x0, float y0, float x1, float y1, float &t )
+
+{
+  float dx = x1 - x0;
+  float dy = y1 - y0;
+  float len2 = dx*dx + dy*dy;
+
+  t = (len2 > 0 ? ((px - x0) * dx + (py - y0) * dy) / len2 : 0);
+
+  if (t < 0) t = 0;
+  if (t > 1) t = 1;
+
+  float ex = x0 + t*dx - px;
+  float ey = y0 + t*dy - py;
+
+  return ex*ex + ey*ey;
+}
+
+
+class SegmentBVH {
+
+  struct Node {
+    float minX, minY, maxX, maxY; // bounds of the node's segments
+    int   first;		// first segment
+    int   count;		// number of segments (leaves only; 0 for inner nodes)
+    int   right;		// index of right child (inner nodes only)
+  };
+
+  vector<Node> nodes;
+  const float *verts;		// polyline vertices as x,y pairs
+  int          numSegs;
+
+  int build( int first, int last );
+
+ public:
+
+  SegmentBVH() { verts = NULL; numSegs = 0; }
+
+  // Build over the 'numVerts'-1 segments of the polyline 'v' (x,y
+  // pairs).  'v' must stay valid while the tree is used.
+
+  void build( const float *v, int numVerts );
+
+  // Return the segment closest to (px,py), and its squared distance
+  // in 'dist2'.  Subtrees no closer than 'maxDist2' are skipped, so
+  // this returns -1 if no segment is closer than that.
+
+  int nearestSegment( float px, float py, float &dist2, float maxDist2 = MAXFLOAT ) const;
+
+  // Call visit(i) for each segment i whose bounding box overlaps the
+  // box [minX,maxX] x [minY,maxY], in increasing order of i
+
+  template <class Visitor>
+  void forSegmentsInBox( float minX, float minY, float maxX, float maxY, Visitor &visit ) const;
+
+  int numNodes() const { return nodes.size(); }
+};
+
+
+template <class Visitor>
+void SegmentBVH::forSegmentsInBox( float minX, float minY, float maxX, float maxY, Visitor &visit ) const
+
+{
+  if (nodes.empty())
+    return;
+
+  int stack[BVH_MAX_DEPTH];
+  int top = 0;
+
+  stack[top++] = 0;
+
+  while (top > 0) {
+
+    const Node &n = nodes[stack[--top]];
+
+    if (n.minX > maxX || n.maxX < minX || n.minY > maxY || n.maxY < minY)
+      continue;
+
+    if (n.count > 0) {
+      for (int i=n.first; i<n.first+n.count; i++) {
+        float x0 = verts[2*i],   y0 = verts[2*i+1];
+        float x1 = verts[2*i+2], y1 = verts[2*i+3];
+        if (min( x0, x1 ) <= maxX && max( x0, x1 ) >= minX &&
+            min( y0, y1 ) <= maxY && max( y0, y1 ) >= minY)
+          visit( i );
+      }
+    } else {
+      stack[top++] = n.right;	// left child (pushed last) is visited first
+      stack[top++] = &n - &nodes[0] + 1;
+    }
+  }
+}
+
+
+#endif
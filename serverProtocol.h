@@ -0,0 +1,67 @@
+// serverProtocol.h
+//
+// The binary protocol between llserve and its clients, over a Unix
+// domain stream socket.  All fields are little-endian.
+//
+// A client sends fixed-size messages: open a session (which is then
+// known by its index among the sessions this client has opened),
+// restart one, or set its controls.  Controls stay set until changed,
+// so a client only needs to send them when they change.
+//
+// After each tick the server sends every client one frame: a
+// TickHeader, then a SessionFrame for each of its sessions.  A client
+// that has not read its last frame yet misses the frames of later
+// ticks (the tick numbers show how many), so a slow client does not
+// hold up the others.
+
+
+#ifndef SERVERPROTOCOL_H
+#define SERVERPROTOCOL_H
+
+
+#include <stdint.h>
+
+
+#define SERVER_SOCKET "/tmp/llserve.sock" // default socket path
+
+#define MSG_OPEN     1		// open a session; 'value' is the seed of its start
+#define MSG_RESTART  2		// restart 'session' from a start with seed 'value'
+#define MSG_CONTROLS 3		// set the controls of 'session' to 'value' (see input.h)
+
+#define FRAME_RUNNING 0x01	// SessionFrame flags
+#define FRAME_WON     0x02
+
+#define SERVER_MAX_SESSIONS 0xffff // per client
+
+
+#pragma pack(push, 1)
+
+struct ClientMessage {
+  uint8_t  type;		// MSG_*
+  uint8_t  pad;
+  uint16_t session;		// index among this client's sessions
+  uint32_t value;
+};
+
+struct TickHeader {
+  uint32_t tick;		// ticks since the server started
+  uint16_t numSessions;		// SessionFrames that follow
+  uint16_t pad;
+};
+
+struct SessionFrame {
+  float    x, y;		// position (m)
+  float    vx, vy;		// velocity (m/s)
+  float    orientation;		// radians CCW
+  float    altitude;		// of the base above the terrain (m)
+  int32_t  fuel;
+  int32_t  score;
+  uint8_t  flags;		// FRAME_*
+  uint8_t  lossReason;		// as Session::getLossReason()
+  uint16_t pad;
+};
+
+#pragma pack(pop)
+
+
+#endif
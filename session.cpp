@@ -0,0 +1,455 @@
+// session.cpp
+
+
+#include "session.h"
+#include "ll.h"
+
+
+float Session::maxY()
+
+{
+  return (landscape->maxX() - landscape->minX()) / SCREEN_ASPECT * (2 - BOTTOM_SPACE) / 2;
+}
+
+
+void Session::step( Controls controls, float elapsedTime )
+
+{	// Checking if the game is currently running
+	if (gameRunning && fixedTerrain)
+		stepFixed(controls);
+	else if (gameRunning) {
+		// Increment the time counter
+		gameTime += elapsedTime;
+
+		if (controls & CONTROL_RESET)
+			resetLander();
+
+		// Apply the controls for rotation and thrust
+
+		if (controls & CONTROL_ROTATE_CW)
+			lander->rotateCW(elapsedTime);
+
+		if (controls & CONTROL_ROTATE_CCW)
+			lander->rotateCCW(elapsedTime);
+
+		if (controls & CONTROL_THRUST)
+			lander->addThrust(elapsedTime);
+
+		// Update the position and velocity.  With continuous
+		// collision, stop the lander where it first touches the
+		// terrain during the step, with its velocity at that instant.
+
+		float fraction;
+		bool  touched = false;
+		vec3  p = lander->centrePosition();
+		vec3  v = lander->getVelocity();
+
+		if (continuousCollision && sweepOutline(landscape, lander->getVertices(), p, lander->getOrientation(), elapsedTime * v, fraction)) {
+			float t = fraction * elapsedTime;
+			lander->place(p + t * v, v + t * vec3(0, -GRAVITY_ACCEL, 0), lander->getOrientation());
+			gameTime -= elapsedTime - t;
+			touched = true;
+		}
+		else
+			lander->updatePose(elapsedTime);
+
+		checkTerrain(touched);
+	}
+	else {		
+		// wait for a new game or a continue
+		if (controls & CONTROL_NEW_GAME) {
+			// start new game
+			HardReset();
+		}
+		else if (controls & CONTROL_CONTINUE) {
+			if (startfuel != 0) {
+				// continue
+				SoftReset();
+			}
+		}
+	}
+
+}
+
+// Update the distance to the terrain and the altitude after the
+// lander has moved, and apply the landing rules.  'touched' is true
+// if a sweep found that the lander touched the terrain.
+
+void Session::checkTerrain(bool touched)
+
+{
+	// See if the lander has touched the terrain
+
+	float approxDistance = (field ? field->distance(lander->centrePosition()) : 0);
+
+	if (field && approxDistance - field->maxError() > ZOOM_RADIUS)
+		terrainDistance = approxDistance;
+	else {
+		vec3 closestTerrainPoint = cursor.findClosestPoint(lander->centrePosition());
+		terrainDistance = (closestTerrainPoint - lander->centrePosition()).length();
+	}
+
+	// Check for landing or collision and let the user know
+	int segmentIndex = cursor.findSegmentBelow(lander->centrePosition());
+	segmentBelow = segmentIndex;
+	// Getting the altitude for current position
+	if (obstacle)
+		altitude = obstacle->clearance(lander->centrePosition(), lander->getOrientation());
+	else
+		altitude = landscape->findLanderAltitude(segmentIndex, lander->centrePosition(), lander->getDimensions().y);
+	// Check if altitude is close enough to land (or, with
+	// continuous collision, if the lander touched during the step,
+	// or, with outline collision, if the outline touches)
+	if (touched || !continuousCollision && (abs(altitude) < TOUCHDOWN_ALTITUDE ||
+	                                        outlineCollision && outlineOverlaps(landscape, lander->getVertices(), lander->centrePosition(), lander->getOrientation()))) {
+		Touchdown(segmentIndex);
+	}
+	else if (altitude < 0) {
+		// game over
+		GameOver("You crashed");
+	}
+}
+
+void Session::setFixedTerrain( FixedTerrain *t )
+
+{
+	fixedTerrain = t;
+
+	if (t && !fixedLander)
+		fixedLander = new FixedLanderBatch(1, maxX(), maxY());
+
+	fixedFuel = -1;		// take the Lander's state at the next step
+}
+
+// One step of 2^-FIXED_DT_SHIFT s in fixed point, with the landing
+// rules of checkTerrain() and Touchdown() (without the collision
+// helpers) applied in fixed point.  The distance to the terrain is
+// only for display, so it is found in float.
+
+void Session::stepFixed(Controls controls)
+
+{
+	gameTime += FIXED_DT;
+
+	if (controls & CONTROL_RESET)
+		resetLander();
+
+	// Take the lander's state if it has changed since the last step
+
+	if (lander->centrePosition().x != fixedPos.x || lander->centrePosition().y != fixedPos.y ||
+	    lander->getVelocity().x != fixedVel.x || lander->getVelocity().y != fixedVel.y ||
+	    lander->getOrientation() != fixedOrient || lander->fuel() != fixedFuel) {
+		fixedLander->place(0, lander->centrePosition(), lander->getVelocity(), lander->getOrientation());
+		fixedLander->setFuel(0, lander->fuel());
+	}
+
+	fixedLander->setControls(0, controls);
+	fixedLander->step();
+
+	fixedPos    = fixedLander->centrePosition(0);
+	fixedVel    = fixedLander->getVelocity(0);
+	fixedOrient = fixedLander->getOrientation(0);
+	fixedFuel   = fixedLander->fuel(0);
+
+	lander->place(fixedPos, fixedVel, fixedOrient);
+	lander->useFuel(lander->fuel() - fixedFuel);
+
+	vec3 closestTerrainPoint = cursor.findClosestPoint(fixedPos);
+	terrainDistance = (closestTerrainPoint - fixedPos).length();
+
+	// Landing rules
+
+	fix32 x = fixedLander->positionX(0);
+	int segmentIndex = fixedTerrain->segmentBelow(x);
+	fix32 alt = fixedTerrain->altitude(segmentIndex, x, fixedLander->positionY(0), toFixed(lander->getDimensions().y));
+
+	altitude = fromFixed(alt);
+	segmentBelow = segmentIndex;
+
+	if (abs(alt) < toFixed(TOUCHDOWN_ALTITUDE)) {
+		bool slow = (abs(fixedLander->velocityX(0)) < toFixed(LANDING_MAX_VX) && abs(fixedLander->velocityY(0)) < toFixed(LANDING_MAX_VY));
+		Landing(slow, slow ? fixedTerrain->goodToLand(segmentIndex, fixedLander->orientation(0), x, toFixed(lander->getDimensions().x)) : 0);
+	}
+	else if (alt < 0) {
+		// game over
+		GameOver("You crashed");
+	}
+}
+
+SessionState Session::getState()
+
+{
+	SessionState s;
+
+	s.position    = lander->centrePosition();
+	s.velocity    = lander->getVelocity();
+	s.orientation = lander->getOrientation();
+	s.fuel        = lander->fuel();
+	s.time        = gameTime;
+	s.score       = score;
+	s.startFuel   = startfuel;
+	s.running     = gameRunning;
+	s.win         = gameWin;
+	s.lossReason  = lossReason;
+
+	return s;
+}
+
+void Session::setState( const SessionState &s )
+
+{
+	lander->place(s.position, s.velocity, s.orientation);
+	lander->setFuel(s.fuel);
+	cursor.reset();
+
+	gameTime    = s.time;
+	score       = s.score;
+	startfuel   = s.startFuel;
+	gameRunning = s.running;
+	gameWin     = s.win;
+	lossReason  = s.lossReason;
+}
+
+void Session::SoftReset() {
+	// Set the starting fuel to current fuel
+	startfuel = lander->fuel();
+	// Reset game time
+	gameTime = 0;
+	// reset the lander velocity and position
+	resetLander();
+	// set game to run again
+	gameRunning = true;
+}
+
+void Session::HardReset() {
+	// Soft reset
+	SoftReset();
+	// reset the score
+	score = 0;
+	// reset the fuel
+	startfuel = INITIAL_FUEL;
+	lander->resetFuel();
+}
+
+// Advance up to 'maxSteps' steps of 'deltaT' with no controls, in one
+// jump, and return the number of steps taken.  This stops before any
+// step that might touch the terrain or wrap around, so those steps
+// can be taken by step() as usual.
+//
+// After n steps of Lander::updatePose() with no controls, the lander
+// is at
+//
+//     p + n dt v + n (n-1)/2 dt^2 g
+//
+// which is the parabola p + t (v - dt g/2) + t^2 g/2 at t = n dt.
+// Between steps the lander moves in a straight line, which is below
+// the parabola by at most g dt^2 / 8.  So the first step that might
+// touch is found by intersecting the parabola with the terrain (or,
+// with a ConfigObstacle, the obstacle boundary for the lander's
+// orientation), raised by the touchdown altitude and that sag.
+
+int Session::coast( float deltaT, int maxSteps )
+
+{
+	if (!gameRunning || fixedTerrain || maxSteps <= 0 || deltaT <= 0)
+		return 0;
+
+	// The outline tests need the obstacle boundary, which bounds the
+	// whole outline; the terrain only bounds the base
+	if ((continuousCollision || outlineCollision) && !obstacle)
+		return 0;
+
+	vec3  p = lander->centrePosition();
+	vec3  v = lander->getVelocity();
+	float orientation = lander->getOrientation();
+
+	// Steps before the lander wraps around (less one, for rounding)
+	double limit = maxSteps;
+	if (v.x > 0)
+		limit = min(limit, floor((maxX() + WRAP_MARGIN - p.x) / (v.x * (double) deltaT)) - 1);
+	else if (v.x < 0)
+		limit = min(limit, floor((-WRAP_MARGIN - p.x) / (v.x * (double) deltaT)) - 1);
+	if (limit <= 0)
+		return 0;
+
+	vec3  u = v + vec3(0, 0.5 * GRAVITY_ACCEL * deltaT, 0); // v - dt g/2
+	float margin = TOUCHDOWN_ALTITUDE + GRAVITY_ACCEL * deltaT * deltaT / 8;
+	float tMax = limit * deltaT;
+	float t;
+
+	if (obstacle) {
+		const vector<float> &x = obstacle->envelopeX(orientation);
+		const vector<float> &y = obstacle->envelopeY(orientation);
+		t = firstTimeBelow(&x[0], &y[0], 1, x.size(), false, p, u, -GRAVITY_ACCEL, margin, tMax);
+	}
+	else
+		t = firstTimeBelow(landscape->vertices(), landscape->vertices() + 1, 2, landscape->numSegments() + 1, true,
+		                   p, u, -GRAVITY_ACCEL, margin + lander->getDimensions().y / 2, tMax);
+
+	int n = (int) limit;
+	if (t != MAXFLOAT)
+		n = min(n, (int) ceil(t / deltaT) - 1);
+	if (n <= 0)
+		return 0;
+
+	double T = n * (double) deltaT;
+	double drop = 0.5 * GRAVITY_ACCEL * n * (n - 1) * (double) deltaT * deltaT;
+
+	lander->place(vec3(p.x + T * v.x, p.y + T * v.y - drop, 0), vec3(v.x, v.y - GRAVITY_ACCEL * T, 0), orientation);
+	gameTime += n * deltaT;
+
+	return n;
+}
+
+// The difference between Verlet and RK4 over a step of 'deltaT'
+// with the given thrust, turning from o0 to o1.  This estimates the
+// error of the RK4 step (see integrators.h).
+
+static float embeddedError(vec3 p, vec3 v, float o0, float o1, float thrust, float deltaT)
+
+{
+	float px1 = p.x, py1 = p.y, vx1 = v.x, vy1 = v.y;
+	float px2 = p.x, py2 = p.y, vx2 = v.x, vy2 = v.y;
+
+	Verlet::advance< ScalarOps<float> >(px1, py1, vx1, vy1, o0, o1, thrust, thrust != 0, deltaT);
+	RK4::advance< ScalarOps<float> >(px2, py2, vx2, vy2, o0, o1, thrust, thrust != 0, deltaT);
+
+	return (vec3(px1, py1, 0) - vec3(px2, py2, 0)).length();
+}
+
+// Apply 'controls' for up to 'maxSteps' steps of 'deltaT' at once,
+// and return the number of steps taken.
+//
+// The steps are taken at once only if no part of the lander can come
+// within TOUCHDOWN_ALTITUDE of the terrain, or reach a wrap-around
+// edge, before the end.  In time t the centre moves at most
+// |v| t + a t^2/2 (a being the size of the acceleration, or gravity
+// plus thrust if the lander turns), and the outline is within half
+// the diagonal of the lander's box around the centre.  Controls are
+// held for at most 1/ADAPTIVE_HOLD of the time that takes.
+//
+// The long step is taken with RK4, which is exact in free fall.  If
+// the lander thrusts while it turns, the step is halved until the
+// difference from Verlet (an embedded estimate of its error) is
+// within ADAPTIVE_TOLERANCE.
+//
+// Otherwise one step is taken with step(), so close to the terrain
+// this is the same as stepping with fixed steps.
+
+int Session::stepAdaptive(Controls controls, float deltaT, int maxSteps)
+
+{
+	int n = 1;
+
+	if (gameRunning && !fixedTerrain && maxSteps > 1 && deltaT > 0 &&
+	    !(controls & ~(CONTROL_ROTATE_CW | CONTROL_ROTATE_CCW | CONTROL_THRUST))) {
+
+		vec3 p = lander->centrePosition();
+		vec3 v = lander->getVelocity();
+
+		// Distance the centre can move
+
+		float d = (field ? field->distance(p) - field->maxError() : 0);
+		if (!field || d < ZOOM_RADIUS)
+			d = (cursor.findClosestPoint(p) - p).length();
+
+		d -= lander->getDimensions().length() / 2 + TOUCHDOWN_ALTITUDE;
+		d = min(d, min(maxX() + WRAP_MARGIN - p.x, p.x + WRAP_MARGIN));
+
+		// Controls (which use one unit of fuel per step each) and the
+		// largest acceleration over the step
+
+		int   numControls = (controls & CONTROL_ROTATE_CW ? 1 : 0) + (controls & CONTROL_ROTATE_CCW ? 1 : 0) + (controls & CONTROL_THRUST ? 1 : 0);
+		float thrust = (controls & CONTROL_THRUST ? THRUST_ACCEL : 0);
+		float o = lander->getOrientation();
+		float turn = ((controls & CONTROL_ROTATE_CCW ? ROTATION_SPEED : 0) - (controls & CONTROL_ROTATE_CW ? ROTATION_SPEED : 0));
+		float a = (turn != 0 ? GRAVITY_ACCEL + thrust : vec3(-thrust * sin(o), thrust * cos(o) - GRAVITY_ACCEL, 0).length());
+
+		if (d > 0 && lander->fuel() >= maxSteps * numControls) {
+
+			float speed = v.length();
+			float t = 2 * d / (speed + sqrt(speed * speed + 2 * a * d)); // |v| t + a t^2/2 = d
+			n = (int) min((float) maxSteps, floor(t / deltaT));
+
+			// The input would have a chance to change the controls
+			// every step, so hold them for only a small part of the
+			// time to reach the terrain
+
+			n = min(n, (int) (t / ADAPTIVE_HOLD / deltaT));
+
+			// Keep the error of a long step within tolerance
+
+			if (thrust != 0 && turn != 0)
+				while (n > 1 && embeddedError(p, v, o, o + turn * n * deltaT, thrust, n * deltaT) > ADAPTIVE_TOLERANCE)
+					n /= 2;
+		}
+
+		if (n > 1) {
+			gameTime += n * deltaT;
+			lander->step<RK4>(controls, n * deltaT);
+			lander->useFuel((n - 1) * numControls);
+			checkTerrain(false);
+			return n;
+		}
+	}
+
+	step(controls, deltaT);
+	return 1;
+}
+
+// Apply the landing rules when the lander touches the terrain above
+// segment 'segmentIndex'
+
+void Session::Touchdown(int segmentIndex) {
+	// check speed
+	vec3 v = lander->getVelocity();
+	bool slow = (abs(v.x) < LANDING_MAX_VX && abs(v.y) < LANDING_MAX_VY);
+	// check segment is flat and lander is contained
+	Landing(slow, slow ? landscape->isSegmentGoodToLand(segmentIndex, lander->getOrientation(), lander->centrePosition(), lander->getDimensions().x) : 0);
+}
+
+// Win or lose a touchdown.  'reason' is from
+// Landscape::isSegmentGoodToLand() if the lander was slow enough.
+
+void Session::Landing(bool slowEnough, int reason) {
+	if (slowEnough) {
+		lossReason = reason;
+		if (lossReason == 0) {
+			lander->stopLander();
+			GameWin();
+		}
+		else {
+			// Report why they lost
+			switch (lossReason) {
+			case 1:
+				GameOver("You attempted to land on a segment that was not flat");
+				break;
+			case 2:
+			case 3:
+				GameOver("You did not fit on the surface");
+				break;
+			default:
+				GameOver("You crashed");
+				break;
+			}
+		}
+	}
+	else {
+		// game over
+		GameOver("You were moving too fast");
+	}
+}
+
+void Session::GameWin() {
+	// Game needs to stop
+	gameRunning = false;
+	gameWin = true;
+	// Calculate and add score, score is split 30% for time to land, 30% for fuel used, 40% for size of platform landed on
+	score += 300 - gameTime  + 300 * (startfuel - lander->fuel()) / startfuel*10 + 400 * lander->getDimensions().y / landscape->getSegmentWidth(cursor.findSegmentBelow(lander->centrePosition()));
+}
+
+void Session::GameOver(const char *reason) {
+	// Game needs to stop
+	gameRunning = false;
+	gameWin = false;
+}
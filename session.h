@@ -0,0 +1,227 @@
+// session.h
+//
+// One game of lunar lander: the landscape, the lander, and the rules
+// for landing and crashing.  Nothing in here uses OpenGL, so a
+// session can be stepped without a window (see llsim.cpp).  The
+// World draws a session and feeds it keyboard input.
+
+
+#ifndef SESSION_H
+#define SESSION_H
+
+
+#include "simHeaders.h"
+#include "landscape.h"
+#include "lander.h"
+#include "input.h"
+#include "terrainCursor.h"
+#include "distanceField.h"
+#include "configObstacle.h"
+#include "collision.h"
+#include "fixedTerrain.h"
+#include "fixedLanderBatch.h"
+
+
+#define BOTTOM_SPACE 0.1f // amount of blank space below terrain (in viewing coordinates) 
+
+#define TOUCHDOWN_ALTITUDE 0.1	// landing rules apply below this altitude (m)
+#define LANDING_MAX_VX 0.5	// fastest horizontal speed for a landing (m/s)
+#define LANDING_MAX_VY 1	// fastest vertical speed for a landing (m/s)
+
+#define ADAPTIVE_TOLERANCE 0.01	// largest error estimate of a long step in stepAdaptive() (m)
+#define ADAPTIVE_HOLD 32	// stepAdaptive() holds controls for 1/32 of the time to reach the terrain
+
+
+// The state of a session, apart from its landscape and helpers (e.g.
+// to start a replay from; see replay.h)
+
+struct SessionState {
+  vec3  position, velocity;	// of the lander
+  float orientation;
+  int   fuel;
+  float time;
+  int   score;
+  int   startFuel;
+  bool  running;
+  bool  win;
+  int   lossReason;
+};
+
+
+// All of the game state lives in the session, so any number of
+// sessions can be stepped at once on different threads.  Sessions
+// may share one Landscape, since landscape queries do not modify it.
+
+class Session {
+
+  Landscape *landscape;
+  bool       ownLandscape;	// true if this session created the landscape
+  Lander    *lander;
+  TerrainCursor cursor;		// landscape queries near the lander's last position
+  DistanceField *field;		// optional; not owned by the session
+  ConfigObstacle *obstacle;	// optional; not owned by the session
+  bool       continuousCollision; // sweep the lander outline over each step
+  bool       outlineCollision;	// test the lander outline after each step
+  float      terrainDistance; // distance from lander centre to closest terrain point
+
+  FixedTerrain     *fixedTerrain; // optional; not owned by the session
+  FixedLanderBatch *fixedLander;  // the lander in fixed point, when fixedTerrain is set
+  vec3  fixedPos, fixedVel;	// the lander's state as last copied from fixedLander
+  float fixedOrient;
+  int   fixedFuel;
+
+  float gameTime;		// time since the lander was last reset (s)
+  float altitude;		// altitude of the lander base above the terrain (m)
+  int   segmentBelow;		// index of the segment below the lander (-1 if none)
+  int   score;
+  int   startfuel;		// fuel at the start of this landing
+  bool  gameRunning;
+  bool  gameWin;
+  int   lossReason;		// from Landscape::isSegmentGoodToLand()
+
+  void Touchdown(int segmentIndex);
+  void Landing(bool slowEnough, int reason);
+  void checkTerrain(bool touched);
+  void stepFixed(Controls controls);
+
+ public:
+
+  Session( Landscape *sharedLandscape = NULL ) {
+    ownLandscape = (sharedLandscape == NULL);
+    landscape = (ownLandscape ? new Landscape() : sharedLandscape);
+    lander    = new Lander( maxX(), maxY() ); // provide world size to help position lander
+    cursor    = TerrainCursor( landscape );
+    field     = NULL;
+    obstacle  = NULL;
+    continuousCollision = false;
+    outlineCollision    = false;
+    terrainDistance = MAXFLOAT;
+    fixedTerrain = NULL;
+    fixedLander  = NULL;
+
+    gameTime    = 0;
+    altitude    = 0;
+    segmentBelow = -1;
+    score       = 0;
+    startfuel   = INITIAL_FUEL;
+    gameRunning = true;
+    gameWin     = false;
+    lossReason  = 0;
+  }
+
+  ~Session() {
+    delete lander;
+    delete fixedLander;
+    if (ownLandscape)
+      delete landscape;
+  }
+
+  // Advance the game by 'deltaT' seconds with the given controls
+
+  void step( Controls controls, float deltaT );
+
+  void update( InputSource &input, float deltaT ) {
+    step( input.controls( *this, deltaT ), deltaT );
+  }
+
+  // Advance up to 'maxSteps' steps with no controls in one jump,
+  // stopping before any step on which the lander might touch the
+  // terrain or wrap around.  Returns the number of steps taken.  The
+  // distance to the terrain and the altitude are not updated until
+  // the next step().
+
+  int coast( float deltaT, int maxSteps );
+
+  // Apply 'controls' for up to 'maxSteps' steps of 'deltaT' in one
+  // longer step, where the lander is far enough from the terrain that
+  // no landing rule can apply, and return the number of steps taken.
+  // Close to the terrain this takes one step with step().  Fuel is
+  // used per step of 'deltaT', as with step().
+
+  int stepAdaptive( Controls controls, float deltaT, int maxSteps );
+
+  void SoftReset();
+
+  void HardReset();
+
+  void GameWin();
+
+  void GameOver(const char *reason);
+
+  SessionState getState();
+  void setState( const SessionState &state );
+
+  void resetLander() {
+    lander->reset();
+    cursor.reset();
+  }
+
+  // Use 'f' (which must be for this session's landscape) to avoid
+  // the exact closest-point query when the lander is more than
+  // ZOOM_RADIUS from the landscape.  distanceToTerrain() is then
+  // only approximate beyond ZOOM_RADIUS.
+
+  void setDistanceField( DistanceField *f ) { field = f; }
+  DistanceField *getDistanceField() { return field; }
+
+  // Use 'o' (which must be for this session's landscape and lander)
+  // to test the whole lander outline against the landscape.  The
+  // altitude is then the distance the outline can drop before it
+  // touches.  Without it, the altitude is that of the lander's base
+  // above the landscape directly below its centre.
+
+  void setConfigObstacle( ConfigObstacle *o ) { obstacle = o; }
+  ConfigObstacle *getConfigObstacle() { return obstacle; }
+
+  // Sweep the lander outline against the terrain over each step, so
+  // that it cannot pass through a thin spike in a long step, and apply
+  // the landing rules at the instant it first touches.  Without this,
+  // the rules are applied once the altitude is within 0.1 m.
+
+  void setContinuousCollision( bool on ) { continuousCollision = on; }
+  bool getContinuousCollision() { return continuousCollision; }
+
+  // Also apply the landing rules when any part of the lander outline
+  // touches the terrain after a step (e.g. a leg catching a slope or
+  // the body clipping a cliff), not only its base.
+
+  void setOutlineCollision( bool on ) { outlineCollision = on; }
+  bool getOutlineCollision() { return outlineCollision; }
+
+  // Step the lander in Q16.16 fixed point against 't' (which must be
+  // for this session's landscape), so that a run with the same
+  // controls gives the same bits on every build.  Each step() is then
+  // 2^-FIXED_DT_SHIFT s, whatever its 'deltaT', coast() takes no
+  // steps and stepAdaptive() takes one.  The collision helpers above
+  // are not used.  The Lander is kept up to date after each step, and
+  // changes made through it (e.g. Lander::place()) are taken at the
+  // next step.  NULL goes back to float.
+
+  void setFixedTerrain( FixedTerrain *t );
+  FixedTerrain *getFixedTerrain() { return fixedTerrain; }
+  FixedLanderBatch *getFixedLander() { return fixedLander; }
+
+  Landscape *getLandscape() { return landscape; }
+  Lander    *getLander()    { return lander; }
+
+  bool  running()           { return gameRunning; }
+  bool  won()               { return gameWin; }
+  float getTime()           { return gameTime; }
+  float getAltitude()       { return altitude; }
+  int   getSegmentBelow()   { return segmentBelow; }
+  int   getScore()          { return score; }
+  int   getStartFuel()      { return startfuel; }
+  int   getLossReason()     { return lossReason; }
+  float distanceToTerrain() { return terrainDistance; }
+
+  // World extremes (in world coordinates)
+
+  float minX() { return 0; }
+  float maxX() { return landscape->maxX(); }
+
+  float minY() { return 0; }
+  float maxY();
+};
+
+
+#endif
@@ -0,0 +1,338 @@
+// shmEnv.cpp
+
+
+#include "shmEnv.h"
+#include "vecEnv.h"
+
+#include <new>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+// Spin on 'counter' until done(value) is true, yielding the CPU after
+// every SHM_SPIN tries.  Returns the last value read.
+
+template <class Done>
+uint64_t waitFor( atomic<uint64_t> &counter, Done done )
+
+{
+  for (;;) {
+    for (int i=0; i<SHM_SPIN; i++) {
+      uint64_t v = counter.load( memory_order_acquire );
+      if (done( v ))
+        return v;
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+    sched_yield();
+  }
+}
+
+
+// ---------------- ShmEnv ----------------
+
+
+ShmEnv::ShmEnv( int n, float dt, bool lockstepMode, int numThreads, Landscape *sharedLandscape )
+
+  : pool( numThreads )
+
+{
+  numEnvs   = max( 1, n );
+  deltaT    = dt;
+  lockstep  = lockstepMode;
+  landscape = (sharedLandscape ? sharedLandscape : new Landscape());
+  ownLandscape = (sharedLandscape == NULL);
+
+  for (int i=0; i<numEnvs; i++)
+    sessions.push_back( new Session( landscape ) );
+
+  rngs.resize( numEnvs );
+  controls.assign( numEnvs, CONTROL_NONE );
+
+  base    = NULL;
+  header  = NULL;
+  frame   = NULL;
+  skipped = 0;
+}
+
+
+ShmEnv::~ShmEnv()
+
+{
+  if (base) {
+    header->open.store( 0, memory_order_release );
+    munmap( base, header->size );
+    shm_unlink( name.c_str() );
+  }
+
+  for (int i=0; i<numEnvs; i++)
+    delete sessions[i];
+
+  if (ownLandscape)
+    delete landscape;
+}
+
+
+bool ShmEnv::create( const char *regionName, unsigned int seed )
+
+{
+  // Layout: the header, the frames (each starting on a cache line),
+  // then the actions
+
+  uint64_t frameBytes   = (numEnvs * sizeof(ShmObservation) + 63) & ~(uint64_t) 63;
+  uint64_t frameOffset  = (sizeof(ShmHeader) + 63) & ~(uint64_t) 63;
+  uint64_t actionOffset = frameOffset + SHM_RING_FRAMES * frameBytes;
+  uint64_t size         = actionOffset + numEnvs;
+
+  shm_unlink( regionName );
+
+  int fd = shm_open( regionName, O_RDWR | O_CREAT | O_EXCL, 0600 );
+  if (fd < 0)
+    return false;
+
+  void *p = MAP_FAILED;
+  if (ftruncate( fd, size ) == 0)
+    p = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close( fd );
+
+  if (p == MAP_FAILED) {
+    shm_unlink( regionName );
+    return false;
+  }
+
+  name = regionName;
+  base = (char *) p;		// (zeroed by ftruncate())
+
+  header = new (base) ShmHeader;
+  header->version      = SHM_VERSION;
+  header->numEnvs      = numEnvs;
+  header->ringFrames   = SHM_RING_FRAMES;
+  header->flags        = (lockstep ? SHM_LOCKSTEP : 0);
+  header->deltaT       = deltaT;
+  header->frameOffset  = frameOffset;
+  header->frameBytes   = frameBytes;
+  header->actionOffset = actionOffset;
+  header->size         = size;
+  header->open.store( 1 );
+  header->published.store( 0 );
+  header->consumed.store( 0 );
+
+  for (int i=0; i<numEnvs; i++)
+    new (base + actionOffset + i) atomic<uint8_t>( CONTROL_NONE );
+
+  // Start every environment and publish frame 0.  The magic goes last,
+  // so that an agent attaching meanwhile sees a region that is not
+  // ready.
+
+  startFrame();
+
+  for (int i=0; i<numEnvs; i++) {
+    rngs[i].seed( seed * 1000003u + i + 1 );
+    VecEnv::randomStart( *sessions[i], rngs[i] );
+    observe( i, 0, 0 );
+  }
+
+  publish();
+
+  atomic_thread_fence( memory_order_release );
+  header->magic = SHM_MAGIC;
+
+  return true;
+}
+
+
+// Pick the slot for the next frame, or skip it if the ring is full
+
+bool ShmEnv::startFrame()
+
+{
+  uint64_t t = header->published.load( memory_order_relaxed );
+
+  if (t - header->consumed.load( memory_order_acquire ) >= SHM_RING_FRAMES) {
+    frame = NULL;
+    skipped++;
+    return false;
+  }
+
+  frame = (ShmObservation *) (base + header->frameOffset + (t % SHM_RING_FRAMES) * header->frameBytes);
+
+  return true;
+}
+
+
+void ShmEnv::publish()
+
+{
+  if (frame)
+    header->published.fetch_add( 1, memory_order_release );
+}
+
+
+void ShmEnv::observe( int i, uint8_t flags, int lossReason )
+
+{
+  if (!frame)
+    return;
+
+  Session        *s = sessions[i];
+  Lander         *l = s->getLander();
+  ShmObservation &o = frame[i];
+
+  vec3 p = l->centrePosition(), v = l->getVelocity();
+
+  o.x = p.x;
+  o.y = p.y;
+  o.vx = v.x;
+  o.vy = v.y;
+  o.orientation = l->getOrientation();
+  o.fuel = l->fuel();
+  o.flags = flags;
+  o.lossReason = lossReason;
+  o.pad = 0;
+
+  // The session's altitude and segment are from its last step, so
+  // find them here for a new episode
+
+  if (flags & SHM_ENDED || s->getSegmentBelow() < 0) {
+    o.segment  = landscape->findSegmentBelow( p );
+    o.altitude = landscape->findLanderAltitude( o.segment, p, l->getDimensions().y );
+  }
+  else {
+    o.segment  = s->getSegmentBelow();
+    o.altitude = s->getAltitude();
+  }
+}
+
+
+void ShmEnv::stepRange( int first, int last )
+
+{
+  for (int i=first; i<last; i++) {
+
+    Session *s = sessions[i];
+
+    s->step( controls[i], deltaT );
+
+    if (s->running())
+      observe( i, 0, 0 );
+    else {
+      uint8_t flags = SHM_ENDED | (s->won() ? SHM_WON : 0);
+      int     reason = s->getLossReason();
+      VecEnv::randomStart( *s, rngs[i] );
+      observe( i, flags, reason );
+    }
+  }
+}
+
+
+void ShmEnv::stepTask( void *env, int chunk )
+
+{
+  ShmEnv *e = (ShmEnv *) env;
+
+  e->stepRange( chunk * SHM_CHUNK, min( e->numEnvs, (chunk + 1) * SHM_CHUNK ) );
+}
+
+
+void ShmEnv::step()
+
+{
+  if (!base)
+    return;
+
+  if (lockstep) {
+    uint64_t t = header->published.load( memory_order_relaxed );
+    waitFor( header->consumed, [t]( uint64_t c ) { return c >= t; } );
+  }
+  else
+    atomic_thread_fence( memory_order_acquire ); // (for the actions of the last answer)
+
+  // Take the actions once, so that a free-running agent changing them
+  // meanwhile does not change them mid-step
+
+  atomic<uint8_t> *actions = (atomic<uint8_t> *) (base + header->actionOffset);
+
+  for (int i=0; i<numEnvs; i++)
+    controls[i] = actions[i].load( memory_order_relaxed ) & (CONTROL_ROTATE_CW | CONTROL_ROTATE_CCW | CONTROL_THRUST);
+
+  startFrame();
+  pool.run( stepTask, this, (numEnvs + SHM_CHUNK - 1) / SHM_CHUNK );
+  publish();
+}
+
+
+// ---------------- ShmAgent ----------------
+
+
+ShmAgent::~ShmAgent()
+
+{
+  if (base)
+    munmap( base, header->size );
+}
+
+
+bool ShmAgent::attach( const char *regionName )
+
+{
+  int fd = shm_open( regionName, O_RDWR, 0 );
+  if (fd < 0)
+    return false;
+
+  // Map the header to find the size, then the whole region
+
+  void *p = mmap( NULL, sizeof(ShmHeader), PROT_READ, MAP_SHARED, fd, 0 );
+  if (p == MAP_FAILED) {
+    close( fd );
+    return false;
+  }
+
+  ShmHeader *h = (ShmHeader *) p;
+  bool ready = (h->magic == SHM_MAGIC && h->version == SHM_VERSION);
+  uint64_t size = h->size;
+  munmap( p, sizeof(ShmHeader) );
+
+  p = (ready ? mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) : MAP_FAILED);
+  close( fd );
+
+  if (p == MAP_FAILED)
+    return false;
+
+  atomic_thread_fence( memory_order_acquire );
+
+  base    = (char *) p;
+  header  = (ShmHeader *) base;
+  actions = (atomic<uint8_t> *) (base + header->actionOffset);
+  current = header->consumed.load( memory_order_acquire );
+
+  return true;
+}
+
+
+const ShmObservation *ShmAgent::next()
+
+{
+  uint64_t answered = header->consumed.load( memory_order_relaxed );
+  uint64_t published;
+
+  // Wait for an unanswered frame, looking at 'open' now and then
+
+  for (;;) {
+    published = header->published.load( memory_order_acquire );
+    if (published > answered)
+      break;
+    if (!header->open.load( memory_order_acquire ))
+      return NULL;
+    int tries = 0;
+    published = waitFor( header->published, [answered, &tries]( uint64_t v ) { return v > answered || ++tries > 64 * SHM_SPIN; } );
+    if (published > answered)
+      break;
+  }
+
+  current = published - 1;
+
+  return (const ShmObservation *) (base + header->frameOffset + (current % header->ringFrames) * header->frameBytes);
+}
@@ -0,0 +1,192 @@
+// shmEnv.h
+//
+// Lander environments shared with another process through a POSIX
+// shared memory region, so that a controller outside the game can
+// drive thousands of landers with no syscall or copy per step.
+//
+// The region holds a ShmHeader, a ring of SHM_RING_FRAMES frames of
+// observations (one ShmObservation per environment) and an action
+// byte per environment.  The simulator (ShmEnv) is the only writer of
+// frames and the controller (ShmAgent) the only writer of actions,
+// and each side publishes with one counter in the header:
+//
+//   published  frames written, stored with release order after the
+//              frame (frame t is in slot t % SHM_RING_FRAMES)
+//
+//   consumed   frames answered, stored with release order after the
+//              actions
+//
+// The controller reads the newest frame in place, writes actions and
+// stores 'consumed'.  The simulator only writes a frame while fewer
+// than SHM_RING_FRAMES are unanswered, so it never writes over a frame
+// the controller may still be reading.  In lockstep mode it waits for
+// each frame to be answered before the next step, so the results do
+// not depend on timing; otherwise it steps on with the latest actions
+// and skips the frames that find the ring full (so a controller that
+// falls behind misses their SHM_ENDED marks).
+//
+// A wait spins on the other side's counter and only yields the CPU (a
+// syscall) after SHM_SPIN tries, so while both sides keep up a step
+// makes no syscalls.  Linux only (shm_open() and mmap()).
+
+
+#ifndef SHMENV_H
+#define SHMENV_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "threadPool.h"
+#include <atomic>
+#include <random>
+#include <stdint.h>
+
+
+#define SHM_NAME "/llshm"	// default region name
+#define SHM_MAGIC 0x4d53484c	// "LHSM"
+#define SHM_VERSION 1
+
+#define SHM_RING_FRAMES 4	// frames in the ring
+#define SHM_SPIN 256		// tries of a counter before yielding the CPU
+#define SHM_CHUNK 256		// environments per thread pool task
+
+#define SHM_LOCKSTEP 0x01	// ShmHeader flags
+
+#define SHM_ENDED 0x01		// ShmObservation flags: an episode ended at this step,
+#define SHM_WON   0x02		// with a landing; this is the start of the next one
+
+
+// Observation of one environment
+
+struct ShmObservation {
+  float    x, y;		// position (m)
+  float    vx, vy;		// velocity (m/s)
+  float    orientation;		// radians CCW
+  float    altitude;		// of the base above the terrain (m)
+  int32_t  fuel;
+  int32_t  segment;		// index of the landscape segment below (-1 if none)
+  uint8_t  flags;		// SHM_*
+  uint8_t  lossReason;		// of the episode that ended, as Session::getLossReason()
+  uint16_t pad;
+};
+
+
+// Start of the region.  The counters are on their own cache lines,
+// so that each side writes only its own.
+
+struct ShmHeader {
+  uint32_t magic, version;
+  uint32_t numEnvs;
+  uint32_t ringFrames;
+  uint32_t flags;
+  float    deltaT;		// of each step (s)
+  uint64_t frameOffset;		// of frame 0 from the start of the region (bytes)
+  uint64_t frameBytes;		// between frames
+  uint64_t actionOffset;	// of the actions
+  uint64_t size;		// of the region
+
+  atomic<uint32_t> open;	// cleared when the simulator stops
+
+  alignas(64) atomic<uint64_t> published;
+  alignas(64) atomic<uint64_t> consumed;
+};
+
+
+// The simulator side: owns the region and the sessions
+
+class ShmEnv {
+
+  int        numEnvs;
+  float      deltaT;
+  bool       lockstep;
+  Landscape *landscape;
+  bool       ownLandscape;
+
+  vector<Session *>   sessions;
+  vector<minstd_rand> rngs;	// for the starts of each environment
+  vector<Controls>    controls;	// of the step in progress
+
+  ThreadPool pool;
+
+  string     name;
+  char      *base;		// the mapped region (NULL until create())
+  ShmHeader *header;
+  ShmObservation *frame;	// being written (NULL if skipped)
+  long       skipped;		// frames skipped with the ring full
+
+  void observe( int i, uint8_t flags, int lossReason );
+  void stepRange( int first, int last );
+  bool startFrame();
+  void publish();
+
+  static void stepTask( void *env, int chunk );
+
+ public:
+
+  // 'numThreads' as for ThreadPool (0 for one per core).  If
+  // 'sharedLandscape' is NULL, the environments share a new one.
+
+  ShmEnv( int n, float dt = 1/60.0, bool lockstepMode = true, int numThreads = 0, Landscape *sharedLandscape = NULL );
+  ~ShmEnv();
+
+  // Create the region 'regionName' (replacing any left by an earlier
+  // run), start every environment from a start drawn from 'seed', and
+  // publish the first frame.  Returns false if the region cannot be
+  // made.
+
+  bool create( const char *regionName, unsigned int seed );
+
+  // Apply the latest actions for one step and publish the next frame.
+  // In lockstep mode, first wait until the last frame is answered.
+
+  void step();
+
+  int  size()    { return numEnvs; }
+  int  threads() { return pool.size(); }
+  long frames()  { return header ? (long) header->published.load() : 0; }
+  long framesSkipped() { return skipped; }
+
+  Session *session( int i ) { return sessions[i]; }
+};
+
+
+// The controller side
+
+class ShmAgent {
+
+  char      *base;		// the mapped region (NULL until attach())
+  ShmHeader *header;
+  atomic<uint8_t> *actions;
+  uint64_t   current;		// frame being answered
+
+ public:
+
+  ShmAgent() { base = NULL; header = NULL; actions = NULL; current = 0; }
+  ~ShmAgent();
+
+  // Map the region 'regionName'.  Returns false if there is none.
+
+  bool attach( const char *regionName );
+
+  int  size()     { return header->numEnvs; }
+  bool lockstep() { return header->flags & SHM_LOCKSTEP; }
+
+  // Wait for a frame that has not been answered and return the newest
+  // (a free-running simulator may have written several).  Returns NULL
+  // if the simulator has stopped.
+
+  const ShmObservation *next();
+
+  uint64_t frameNumber() { return current; }
+
+  // Set the controls of environment 'i' (they stay set until changed)
+
+  void setAction( int i, Controls c ) { actions[i].store( c, memory_order_relaxed ); }
+
+  // Hand the actions for the frame from next() to the simulator
+
+  void answer() { header->consumed.store( current + 1, memory_order_release ); }
+};
+
+
+#endif
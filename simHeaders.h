@@ -0,0 +1,46 @@
+// The standard headers included by all simulation files
+//
+// These are the headers of headers.h without OpenGL or GLFW, so the
+// simulation core (lander, landscape, session, input) can be built
+// and run on machines without a window system.
+
+
+#ifndef SIMHEADERS_H
+#define SIMHEADERS_H
+
+#ifdef LINUX
+  #include <sys/timeb.h>	// includes ftime (to return current time)
+  #include <unistd.h>		// includes usleep (to sleep for some time)
+  #include <values.h>           // includes MAX_FLOAT
+  #define sprintf_s sprintf
+  #define _strdup strdup
+  #define sscanf_s sscanf
+#endif
+
+#ifdef _WIN32
+  //#include <typeinfo>
+  #define MAXFLOAT FLT_MAX
+  //#define rint(x) floor((x)+0.5)
+  #pragma warning(disable : 4244 4305 4996 4838)
+#endif
+
+#ifdef __APPLE_CC__
+#endif
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+using namespace std;
+
+#include <cmath>
+
+#ifndef M_PI			// (MSVC defines it only with _USE_MATH_DEFINES)
+  #define M_PI 3.14159265358979323846
+#endif
+
+#include "linalg.h"
+
+#define randIn01() (rand() / (float) RAND_MAX)   // random number in [0,1]
+
+#endif
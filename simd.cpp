@@ -0,0 +1,41 @@
+// simd.cpp
+
+
+#include "simd.h"
+
+
+bool cpuHasAVX2()
+
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" );
+#else
+  return false;
+#endif
+}
+
+
+SimdKernel bestSimdKernel()
+
+{
+  static SimdKernel best = (cpuHasAVX2() ? SIMD_AVX2 :
+#ifdef HAVE_SSE2
+                            SIMD_SSE2
+#else
+                            SIMD_SCALAR
+#endif
+                            );
+  return best;
+}
+
+
+const char *simdKernelName( SimdKernel k )
+
+{
+  switch (k) {
+  case SIMD_AVX2: return "avx2";
+  case SIMD_SSE2: return "sse2";
+  default:        return "scalar";
+  }
+}
@@ -0,0 +1,207 @@
+// simd.h
+//
+// Thin wrappers over SSE2 and AVX2 intrinsics, so that a kernel can
+// be written once as a template and compiled for either width.
+//
+// SSE2 is part of every x86-64 CPU.  The AVX2 wrappers are only
+// defined when the file is compiled with AVX2 enabled (the Makefile
+// builds the *Avx2.cpp files with -mavx2 -mfma), and callers should
+// check cpuHasAVX2() before calling into those files.
+
+
+#ifndef SIMD_H
+#define SIMD_H
+
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP) && _M_IX86_FP >= 2
+  #define HAVE_SSE2
+  #include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+  #define HAVE_AVX2
+  #include <immintrin.h>
+#endif
+
+
+// Kernels that can be selected at runtime
+
+typedef enum { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 } SimdKernel;
+
+bool cpuHasAVX2();		// true if this CPU (and OS) supports AVX2 and FMA
+SimdKernel bestSimdKernel();	// widest kernel this build and CPU support
+const char *simdKernelName( SimdKernel k );
+
+
+#ifdef HAVE_SSE2
+
+struct SimdSSE2 {
+
+  typedef __m128  F;		// 4 floats
+  typedef __m128i I;		// 4 ints
+
+  enum { WIDTH = 4 };
+
+  static inline F load( const float *p )      { return _mm_loadu_ps( p ); }
+  static inline void store( float *p, F a )   { _mm_storeu_ps( p, a ); }
+  static inline I loadi( const int *p )       { return _mm_loadu_si128( (const __m128i *) p ); }
+  static inline void storei( int *p, I a )    { _mm_storeu_si128( (__m128i *) p, a ); }
+
+  static inline I loadBytes( const unsigned char *p ) { // zero-extend 4 bytes to 4 ints
+    int b; memcpy( &b, p, 4 );
+    __m128i z = _mm_setzero_si128();
+    return _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( b ), z ), z );
+  }
+
+  static inline F set1( float a )  { return _mm_set1_ps( a ); }
+  static inline I set1i( int a )   { return _mm_set1_epi32( a ); }
+  static inline I iota()           { return _mm_setr_epi32( 0, 1, 2, 3 ); }
+
+  static inline F add( F a, F b )  { return _mm_add_ps( a, b ); }
+  static inline F sub( F a, F b )  { return _mm_sub_ps( a, b ); }
+  static inline F mul( F a, F b )  { return _mm_mul_ps( a, b ); }
+  static inline F fmadd( F a, F b, F c ) { return _mm_add_ps( _mm_mul_ps( a, b ), c ); } // a*b+c
+  static inline F min( F a, F b )  { return _mm_min_ps( a, b ); }
+  static inline F max( F a, F b )  { return _mm_max_ps( a, b ); }
+
+  static inline F andf( F a, F b )    { return _mm_and_ps( a, b ); }
+  static inline F xorf( F a, F b )    { return _mm_xor_ps( a, b ); }
+  static inline F select( F mask, F a, F b ) { // mask ? a : b
+    return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+  }
+
+  static inline F lt( F a, F b )   { return _mm_cmplt_ps( a, b ); }
+  static inline F gt( F a, F b )   { return _mm_cmpgt_ps( a, b ); }
+
+  static inline I addi( I a, I b ) { return _mm_add_epi32( a, b ); }
+  static inline I subi( I a, I b ) { return _mm_sub_epi32( a, b ); }
+  static inline I andi( I a, I b ) { return _mm_and_si128( a, b ); }
+  static inline I ori( I a, I b )  { return _mm_or_si128( a, b ); }
+  static inline I xori( I a, I b ) { return _mm_xor_si128( a, b ); }
+  static inline I gti( I a, I b )  { return _mm_cmpgt_epi32( a, b ); }
+  static inline I eqi( I a, I b )  { return _mm_cmpeq_epi32( a, b ); }
+  static inline I slli( I a, int n ) { return _mm_slli_epi32( a, n ); }
+  static inline I srai( I a, int n ) { return _mm_sra_epi32( a, _mm_cvtsi32_si128( n ) ); } // arithmetic
+  static inline I selecti( I mask, I a, I b ) { // mask ? a : b
+    return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+  }
+  static inline I madd16( I a, I b ) { return _mm_madd_epi16( a, b ); } // a and b as int16 pairs: a0*b0 + a1*b1 per int
+
+  static inline F asF( I a )       { return _mm_castsi128_ps( a ); }
+  static inline I asI( F a )       { return _mm_castps_si128( a ); }
+  static inline I roundToInt( F a ) { return _mm_cvtps_epi32( a ); } // round to nearest
+  static inline F toF( I a )       { return _mm_cvtepi32_ps( a ); }
+
+  static inline bool any( F mask ) { return _mm_movemask_ps( mask ) != 0; }
+  static inline bool anyi( I mask ) { return _mm_movemask_epi8( mask ) != 0; }
+};
+
+#endif
+
+
+#ifdef HAVE_AVX2
+
+struct SimdAVX2 {
+
+  typedef __m256  F;		// 8 floats
+  typedef __m256i I;		// 8 ints
+
+  enum { WIDTH = 8 };
+
+  static inline F load( const float *p )      { return _mm256_loadu_ps( p ); }
+  static inline void store( float *p, F a )   { _mm256_storeu_ps( p, a ); }
+  static inline I loadi( const int *p )       { return _mm256_loadu_si256( (const __m256i *) p ); }
+  static inline void storei( int *p, I a )    { _mm256_storeu_si256( (__m256i *) p, a ); }
+
+  static inline I loadBytes( const unsigned char *p ) { // zero-extend 8 bytes to 8 ints
+    return _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i *) p ) );
+  }
+
+  static inline F set1( float a )  { return _mm256_set1_ps( a ); }
+  static inline I set1i( int a )   { return _mm256_set1_epi32( a ); }
+  static inline I iota()           { return _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ); }
+
+  static inline F add( F a, F b )  { return _mm256_add_ps( a, b ); }
+  static inline F sub( F a, F b )  { return _mm256_sub_ps( a, b ); }
+  static inline F mul( F a, F b )  { return _mm256_mul_ps( a, b ); }
+  static inline F fmadd( F a, F b, F c ) { return _mm256_fmadd_ps( a, b, c ); } // a*b+c
+  static inline F min( F a, F b )  { return _mm256_min_ps( a, b ); }
+  static inline F max( F a, F b )  { return _mm256_max_ps( a, b ); }
+
+  static inline F andf( F a, F b )    { return _mm256_and_ps( a, b ); }
+  static inline F xorf( F a, F b )    { return _mm256_xor_ps( a, b ); }
+  static inline F select( F mask, F a, F b ) { return _mm256_blendv_ps( b, a, mask ); } // mask ? a : b
+
+  static inline F lt( F a, F b )   { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+  static inline F gt( F a, F b )   { return _mm256_cmp_ps( a, b, _CMP_GT_OQ ); }
+
+  static inline I addi( I a, I b ) { return _mm256_add_epi32( a, b ); }
+  static inline I subi( I a, I b ) { return _mm256_sub_epi32( a, b ); }
+  static inline I andi( I a, I b ) { return _mm256_and_si256( a, b ); }
+  static inline I ori( I a, I b )  { return _mm256_or_si256( a, b ); }
+  static inline I xori( I a, I b ) { return _mm256_xor_si256( a, b ); }
+  static inline I gti( I a, I b )  { return _mm256_cmpgt_epi32( a, b ); }
+  static inline I eqi( I a, I b )  { return _mm256_cmpeq_epi32( a, b ); }
+  static inline I slli( I a, int n ) { return _mm256_slli_epi32( a, n ); }
+  static inline I srai( I a, int n ) { return _mm256_sra_epi32( a, _mm_cvtsi32_si128( n ) ); } // arithmetic
+  static inline I selecti( I mask, I a, I b ) { return _mm256_blendv_epi8( b, a, mask ); } // mask ? a : b
+  static inline I madd16( I a, I b ) { return _mm256_madd_epi16( a, b ); } // a and b as int16 pairs: a0*b0 + a1*b1 per int
+
+  static inline F asF( I a )       { return _mm256_castsi256_ps( a ); }
+  static inline I asI( F a )       { return _mm256_castps_si256( a ); }
+  static inline I roundToInt( F a ) { return _mm256_cvtps_epi32( a ); } // round to nearest
+  static inline F toF( I a )       { return _mm256_cvtepi32_ps( a ); }
+
+  static inline bool any( F mask ) { return _mm256_movemask_ps( mask ) != 0; }
+  static inline bool anyi( I mask ) { return _mm256_movemask_epi8( mask ) != 0; }
+};
+
+#endif
+
+
+// sin and cos of each lane of 'x', to about 1e-7 for |x| < 8000.
+//
+// The argument is reduced to [-pi/4,pi/4] by subtracting a multiple
+// of pi/2 (in three parts, to keep the precision of the remainder),
+// then the Cephes single-precision polynomials are used and the
+// results are swapped and negated according to the quadrant.
+
+template <class S>
+inline void simdSinCos( typename S::F x, typename S::F &sinX, typename S::F &cosX )
+
+{
+  typedef typename S::F F;
+  typedef typename S::I I;
+
+  I q = S::roundToInt( S::mul( x, S::set1( 0.63661977236758134f ) ) ); // x / (pi/2)
+  F y = S::toF( q );
+
+  F r = S::fmadd( y, S::set1( -1.5703125f ), x );
+  r = S::fmadd( y, S::set1( -4.837512969970703125e-4f ), r );
+  r = S::fmadd( y, S::set1( -7.54978995489188216e-8f ), r );
+
+  F z = S::mul( r, r );
+
+  F s = S::fmadd( S::set1( -1.9515295891e-4f ), z, S::set1( 8.3321608736e-3f ) );
+  s = S::fmadd( s, z, S::set1( -1.6666654611e-1f ) );
+  s = S::fmadd( S::mul( s, z ), r, r );
+
+  F c = S::fmadd( S::set1( 2.443315711809948e-5f ), z, S::set1( -1.388731625493765e-3f ) );
+  c = S::fmadd( c, z, S::set1( 4.166664568298827e-2f ) );
+  c = S::fmadd( S::mul( c, z ), z, S::fmadd( S::set1( -0.5f ), z, S::set1( 1.0f ) ) );
+
+  // Odd quadrants swap sin and cos.  sin is negated in quadrants 2,3
+  // and cos in quadrants 1,2.
+
+  F swap = S::asF( S::eqi( S::andi( q, S::set1i( 1 ) ), S::set1i( 1 ) ) );
+  F sinSign = S::asF( S::slli( S::andi( q, S::set1i( 2 ) ), 30 ) );
+  F cosSign = S::asF( S::slli( S::andi( S::addi( q, S::set1i( 1 ) ), S::set1i( 2 ) ), 30 ) );
+
+  sinX = S::xorf( S::select( swap, c, s ), sinSign );
+  cosX = S::xorf( S::select( swap, s, c ), cosSign );
+}
+
+
+#endif
@@ -0,0 +1,146 @@
+// terrainCursor.cpp
+
+
+#include "terrainCursor.h"
+#include "segmentBVH.h"
+
+
+// Find the segment below 'position' by walking from the segment below
+// the last position.  This gives the same answer as
+// Landscape::findSegmentBelow(): the last segment whose left end is
+// at or left of 'position'.
+
+
+int TerrainCursor::findSegmentBelow( vec3 position )
+
+{
+  int last = landscape->numSegments() - 1;
+
+  if (!valid || fabs( position.x - lastX ) > CURSOR_MAX_JUMP) {
+    below = landscape->findSegmentBelow( position );
+    lastX = position.x;
+    valid = true;
+    return below;
+  }
+
+  int i = below;
+  int walked = 0;
+
+  while (i < last && x(i+1) <= position.x && walked < CURSOR_MAX_WALK) {
+    i++;
+    walked++;
+  }
+
+  while (i > 0 && x(i) > position.x && walked < CURSOR_MAX_WALK) {
+    i--;
+    walked++;
+  }
+
+  // At the ends of the landscape, or after a long walk, let the
+  // landscape decide (it also skips vertical segments at the right end)
+
+  if (walked == CURSOR_MAX_WALK || i == last && x(i+1) <= position.x)
+    i = landscape->findSegmentBelow( position );
+
+  below = i;
+  lastX = position.x;
+
+  return below;
+}
+
+
+// Find the closest point on the landscape to 'position'.
+//
+// The segment closest to the last position is usually still closest
+// (or nearly), so its distance is a good bound to start with.  Then
+// walk outward in both directions from the segment below 'position'.
+// Since the segments are in x order, a segment whose x range is
+// further away horizontally than the closest segment found so far
+// cannot be closer, and neither can any segment beyond it, so each
+// walk stops there.  If the walks get long (e.g. when the lander is
+// high above a detailed landscape), finish with the landscape's BVH,
+// which the bound lets skip most of the landscape.
+
+
+vec3 TerrainCursor::findClosestPoint( vec3 position )
+
+{
+  bool  wasValid = valid;
+  int   numSegs  = landscape->numSegments();
+  int   start    = findSegmentBelow( position );
+
+  int   best = -1;
+  float bestDist2 = MAXFLOAT;
+  float t;
+
+  if (wasValid && closest >= 0 && closest < numSegs) {
+    vec3 a = landscape->vertex( closest );
+    vec3 b = landscape->vertex( closest+1 );
+    best = closest;
+    bestDist2 = pointSegmentDist2( position.x, position.y, a.x, a.y, b.x, b.y, t );
+  }
+
+  int left  = start;	// next segment to try on each side
+  int right = start + 1;
+  int walked = 0;
+
+  bool goLeft  = true;
+  bool goRight = true;
+
+  while ((goLeft || goRight) && walked < CURSOR_MAX_WALK) {
+
+    if (goLeft)
+      if (left < 0)
+        goLeft = false;
+      else {
+        vec3 a = landscape->vertex( left );
+        vec3 b = landscape->vertex( left+1 );
+        float gap = position.x - b.x;
+        if (gap > 0 && gap*gap >= bestDist2)
+          goLeft = false;
+        else {
+          float d2 = pointSegmentDist2( position.x, position.y, a.x, a.y, b.x, b.y, t );
+          if (d2 < bestDist2 || d2 == bestDist2 && left < best) {
+            bestDist2 = d2;
+            best = left;
+          }
+          left--;
+          walked++;
+        }
+      }
+
+    if (goRight)
+      if (right >= numSegs)
+        goRight = false;
+      else {
+        vec3 a = landscape->vertex( right );
+        vec3 b = landscape->vertex( right+1 );
+        float gap = a.x - position.x;
+        if (gap > 0 && gap*gap >= bestDist2)
+          goRight = false;
+        else {
+          float d2 = pointSegmentDist2( position.x, position.y, a.x, a.y, b.x, b.y, t );
+          if (d2 < bestDist2 || d2 == bestDist2 && right < best) {
+            bestDist2 = d2;
+            best = right;
+          }
+          right++;
+          walked++;
+        }
+      }
+  }
+
+  if (goLeft || goRight) {
+    float dist2;
+    int i = landscape->findClosestSegment( position, dist2, bestDist2 );
+    if (i >= 0)
+      best = i;
+  }
+
+  if (best < 0)			// no segments
+    return landscape->findClosestPoint( position );
+
+  closest = best;
+
+  return landscape->findClosestPoint( position, landscape->vertex( best ), landscape->vertex( best+1 ) );
+}
@@ -0,0 +1,51 @@
+// terrainCursor.h
+//
+// Landscape queries for a point that moves a little between calls
+// (e.g. the lander from one step to the next).  The cursor remembers
+// the segments found last time and walks from them to the new
+// answer, which usually takes a step or two.  After a jump (reset,
+// wraparound) or a long walk it falls back to the landscape's own
+// indexes.
+
+
+#ifndef TERRAINCURSOR_H
+#define TERRAINCURSOR_H
+
+
+#include "landscape.h"
+
+
+#define CURSOR_MAX_JUMP 50	// a point that moves further than this (m) is looked up afresh
+#define CURSOR_MAX_WALK 16	// most segments to walk before using the landscape index
+
+
+class TerrainCursor {
+
+  Landscape *landscape;
+  bool       valid;		// false until the first query, and after reset()
+  float      lastX;		// x of the last query
+  int        below;		// segment below the last query point
+  int        closest;		// segment closest to the last query point
+
+  float x( int i ) { return landscape->vertex( i ).x; }
+
+ public:
+
+  TerrainCursor( Landscape *l = NULL ) {
+    landscape = l;
+    valid = false;
+    closest = -1;
+  }
+
+  // Forget the last position (e.g. when the lander is reset)
+
+  void reset() { valid = false; }
+
+  // The same as the Landscape functions of the same names
+
+  int  findSegmentBelow( vec3 position );
+  vec3 findClosestPoint( vec3 position );
+};
+
+
+#endif
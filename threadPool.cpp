@@ -0,0 +1,101 @@
+// threadPool.cpp
+
+
+#include "threadPool.h"
+
+
+ThreadPool::ThreadPool( int numThreads )
+
+{
+  if (numThreads < 1)
+    numThreads = thread::hardware_concurrency();
+  if (numThreads < 1)
+    numThreads = 1;
+
+  generation = 0;
+  running    = 0;
+  quitting   = false;
+  numTasks   = 0;
+  nextTask   = 0;
+
+  for (int t=1; t<numThreads; t++)
+    workers.push_back( thread( &ThreadPool::work, this ) );
+}
+
+
+ThreadPool::~ThreadPool()
+
+{
+  {
+    unique_lock<mutex> l( lock );
+    quitting = true;
+  }
+  wake.notify_all();
+
+  for (unsigned int t=0; t<workers.size(); t++)
+    workers[t].join();
+}
+
+
+// Take tasks until there are none left
+
+void ThreadPool::runTasks()
+
+{
+  for (int i=nextTask++; i<numTasks; i=nextTask++)
+    task( taskData, i );
+}
+
+
+void ThreadPool::work()
+
+{
+  long seen = 0;
+
+  for (;;) {
+    {
+      unique_lock<mutex> l( lock );
+      while (generation == seen && !quitting)
+        wake.wait( l );
+      if (quitting)
+        return;
+      seen = generation;
+    }
+
+    runTasks();
+
+    {
+      unique_lock<mutex> l( lock );
+      if (--running == 0)
+        finished.notify_one();
+    }
+  }
+}
+
+
+void ThreadPool::run( PoolTask f, void *data, int n )
+
+{
+  if (workers.empty() || n <= 1) {
+    for (int i=0; i<n; i++)
+      f( data, i );
+    return;
+  }
+
+  {
+    unique_lock<mutex> l( lock );
+    task     = f;
+    taskData = data;
+    numTasks = n;
+    nextTask = 0;
+    running  = workers.size();
+    generation++;
+  }
+  wake.notify_all();
+
+  runTasks();
+
+  unique_lock<mutex> l( lock );
+  while (running > 0)
+    finished.wait( l );
+}
@@ -0,0 +1,58 @@
+// threadPool.h
+//
+// A fixed set of worker threads that run numbered tasks together
+// with the calling thread.  The threads are started once and wait
+// between calls, so a call costs a wake-up rather than a thread
+// start, and nothing is allocated per call.
+
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+typedef void (*PoolTask)( void *data, int task );
+
+
+class ThreadPool {
+
+  vector<thread>     workers;
+  mutex              lock;
+  condition_variable wake, finished;
+  long               generation;	// calls of run() so far
+  int                running;		// workers still in this call
+  bool               quitting;
+
+  PoolTask    task;			// this call
+  void       *taskData;
+  int         numTasks;
+  atomic<int> nextTask;
+
+  void work();
+  void runTasks();
+
+ public:
+
+  // 'numThreads' counts the calling thread; 0 uses one per core
+
+  ThreadPool( int numThreads = 0 );
+  ~ThreadPool();
+
+  int size() { return workers.size() + 1; }
+
+  // Call f(data,i) for each i in [0,n), spread over the threads, and
+  // return when all have returned
+
+  void run( PoolTask f, void *data, int n );
+};
+
+
+#endif
@@ -0,0 +1,160 @@
+// vecEnv.cpp
+
+
+#include "vecEnv.h"
+
+
+VecEnv::VecEnv( int n, float dt, int numThreads, Landscape *sharedLandscape, int maxEpisodeSteps )
+
+  : pool( numThreads )
+
+{
+  numEnvs   = max( 1, n );
+  deltaT    = dt;
+  maxSteps  = maxEpisodeSteps;
+  landscape = (sharedLandscape ? sharedLandscape : new Landscape());
+  ownLandscape = (sharedLandscape == NULL);
+  actions   = NULL;
+
+  for (int i=0; i<numEnvs; i++)
+    sessions.push_back( new Session( landscape ) );
+
+  rngs.resize( numEnvs );
+  stepCount.assign( numEnvs, 0 );
+
+  obs.assign( numEnvs * ENV_OBS_SIZE, 0 );
+  reward.assign( numEnvs, 0 );
+  terminated.assign( numEnvs, 0 );
+  truncated.assign( numEnvs, 0 );
+  episodeLength.assign( numEnvs, 0 );
+
+  reset( 0 );
+}
+
+
+VecEnv::~VecEnv()
+
+{
+  for (int i=0; i<numEnvs; i++)
+    delete sessions[i];
+
+  if (ownLandscape)
+    delete landscape;
+}
+
+
+// A new game from a random start, as llsim -seed starts them:
+// anywhere across the world at 70% of its height, with a horizontal
+// speed of up to 30 m/s
+
+void VecEnv::randomStart( Session &s, minstd_rand &rng )
+
+{
+  uniform_real_distribution<float> in01( 0, 1 );
+
+  float x  = (0.05 + 0.9 * in01( rng )) * s.maxX();
+  float vx = 60 * in01( rng ) - 30;
+
+  s.HardReset();
+  s.getLander()->place( vec3( x, 0.7 * s.maxY(), 0 ), vec3( vx, 0, 0 ), 0 );
+}
+
+
+void VecEnv::startEpisode( int i )
+
+{
+  randomStart( *sessions[i], rngs[i] );
+  stepCount[i] = 0;
+}
+
+
+void VecEnv::observation( Session &s, bool fresh, float *o )
+
+{
+  Lander *l = s.getLander();
+  vec3    p = l->centrePosition(), v = l->getVelocity();
+
+  o[ENV_OBS_X]   = p.x / s.maxX();
+  o[ENV_OBS_Y]   = p.y / s.maxY();
+  o[ENV_OBS_VX]  = v.x;
+  o[ENV_OBS_VY]  = v.y;
+  o[ENV_OBS_SIN] = sin( l->getOrientation() );
+  o[ENV_OBS_COS] = cos( l->getOrientation() );
+  o[ENV_OBS_FUEL] = l->fuel() / (float) INITIAL_FUEL;
+
+  // The session's altitude is from its last step, so find it here
+  // for a new episode
+
+  Landscape *landscape = s.getLandscape();
+
+  o[ENV_OBS_ALTITUDE] = (!fresh ? s.getAltitude() :
+                         landscape->findLanderAltitude( landscape->findSegmentBelow( p ), p, l->getDimensions().y ));
+}
+
+
+void VecEnv::observe( int i )
+
+{
+  observation( *sessions[i], stepCount[i] == 0, &obs[i * ENV_OBS_SIZE] );
+}
+
+
+void VecEnv::reset( unsigned int seed )
+
+{
+  for (int i=0; i<numEnvs; i++) {
+    rngs[i].seed( seed * 1000003u + i + 1 );
+    startEpisode( i );
+    observe( i );
+    reward[i] = 0;
+    terminated[i] = truncated[i] = 0;
+    episodeLength[i] = 0;
+  }
+}
+
+
+void VecEnv::stepRange( int first, int last )
+
+{
+  for (int i=first; i<last; i++) {
+
+    Session *s = sessions[i];
+    int fuel = s->getLander()->fuel();
+
+    s->step( actions[i] & (CONTROL_ROTATE_CW | CONTROL_ROTATE_CCW | CONTROL_THRUST), deltaT );
+    stepCount[i]++;
+
+    float r = ENV_STEP_REWARD + ENV_FUEL_REWARD * (fuel - s->getLander()->fuel());
+
+    terminated[i] = !s->running();
+    truncated[i]  = !terminated[i] && stepCount[i] >= maxSteps;
+    episodeLength[i] = (terminated[i] || truncated[i] ? stepCount[i] : 0);
+
+    if (terminated[i])
+      r += (s->won() ? ENV_LAND_REWARD : ENV_CRASH_REWARD);
+
+    reward[i] = r;
+
+    if (terminated[i] || truncated[i])
+      startEpisode( i );
+
+    observe( i );
+  }
+}
+
+
+void VecEnv::stepTask( void *env, int chunk )
+
+{
+  VecEnv *e = (VecEnv *) env;
+
+  e->stepRange( chunk * ENV_CHUNK, min( e->numEnvs, (chunk + 1) * ENV_CHUNK ) );
+}
+
+
+void VecEnv::step( const Controls *a )
+
+{
+  actions = a;
+  pool.run( stepTask, this, (numEnvs + ENV_CHUNK - 1) / ENV_CHUNK );
+}
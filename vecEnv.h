@@ -0,0 +1,121 @@
+// vecEnv.h
+//
+// A batch of lander environments for training controllers, in the
+// style of a vectorized Gym environment: reset(seed), then step() with
+// one action per environment, which writes each environment's
+// observation, reward and whether its episode ended.  Each environment
+// is a Session (the game the World shows, without the window), and
+// the environments are stepped in chunks on a thread pool.
+//
+// The output buffers are allocated once and written in place, so
+// step() allocates nothing.  An environment whose episode ends is
+// reset at once, and its observation is the first of the next episode
+// (as with Gym's vector environments).  Starts depend only on the
+// seed, the environment and the episode, not on the threads.
+
+
+#ifndef VECENV_H
+#define VECENV_H
+
+
+#include "simHeaders.h"
+#include "session.h"
+#include "threadPool.h"
+#include <random>
+#include <vector>
+
+
+// Observation of one environment, all floats
+
+#define ENV_OBS_X        0	// position as a fraction of the world width
+#define ENV_OBS_Y        1	// and height
+#define ENV_OBS_VX       2	// velocity (m/s)
+#define ENV_OBS_VY       3
+#define ENV_OBS_SIN      4	// sin and cos of the orientation
+#define ENV_OBS_COS      5
+#define ENV_OBS_ALTITUDE 6	// altitude of the base above the terrain (m)
+#define ENV_OBS_FUEL     7	// fuel as a fraction of INITIAL_FUEL
+#define ENV_OBS_SIZE     8
+
+// Rewards
+
+#define ENV_LAND_REWARD   100	// for a landing
+#define ENV_CRASH_REWARD -100	// for any other end of the game
+#define ENV_FUEL_REWARD  -0.01	// per unit of fuel used
+#define ENV_STEP_REWARD  -0.001	// per step, so that hovering does not pay
+
+#define ENV_MAX_STEPS 18000	// steps before an episode is cut off (5 minutes at 60 Hz)
+#define ENV_CHUNK     256	// environments per thread pool task
+
+
+class VecEnv {
+
+  int   numEnvs;
+  float deltaT;
+  int   maxSteps;
+  Landscape *landscape;
+  bool  ownLandscape;
+
+  vector<Session *>    sessions;
+  vector<minstd_rand>  rngs;	// for the starts of each environment
+  vector<int>          stepCount; // steps in the current episode
+
+  vector<float>         obs;	// numEnvs x ENV_OBS_SIZE
+  vector<float>         reward;
+  vector<unsigned char> terminated; // the game ended this step
+  vector<unsigned char> truncated;  // the episode was cut off at maxSteps
+  vector<int>           episodeLength; // of the episode that ended, if it did
+
+  ThreadPool   pool;
+  const Controls *actions;	// of the step in progress
+
+  void startEpisode( int i );
+  void observe( int i );
+  void stepRange( int first, int last );
+
+  static void stepTask( void *env, int chunk );
+
+ public:
+
+  // 'numThreads' as for ThreadPool (0 for one per core).  If
+  // 'sharedLandscape' is NULL, the environments share a new one.
+
+  VecEnv( int n, float dt = 1/60.0, int numThreads = 0, Landscape *sharedLandscape = NULL, int maxEpisodeSteps = ENV_MAX_STEPS );
+  ~VecEnv();
+
+  int size() { return numEnvs; }
+  int threads() { return pool.size(); }
+
+  // Start a new episode in every environment, with starts drawn from
+  // 'seed', and write the observations
+
+  void reset( unsigned int seed );
+
+  // Apply actions[i] (Controls; see input.h) to environment i for one
+  // step, and write the observations, rewards and ends
+
+  void step( const Controls *actions );
+
+  // The buffers written by reset() and step()
+
+  const float         *observations()   { return &obs[0]; }
+  const float         *rewards()        { return &reward[0]; }
+  const unsigned char *terminations()   { return &terminated[0]; }
+  const unsigned char *truncations()    { return &truncated[0]; }
+  const int           *episodeLengths() { return &episodeLength[0]; }
+
+  Session *session( int i ) { return sessions[i]; }
+
+  // Write the observation of 's' to 'o' (ENV_OBS_SIZE floats).
+  // 'fresh' is true at the start of an episode, before the session has
+  // found its altitude.
+
+  static void observation( Session &s, bool fresh, float *o );
+
+  // Start a new game in 's' from a random start drawn from 'rng'
+
+  static void randomStart( Session &s, minstd_rand &rng );
+};
+
+
+#endif
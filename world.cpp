@@ -2,153 +2,107 @@
 
 
 #include "world.h"
-#include "lander.h"
-#include "ll.h"
 #include "gpuProgram.h"
 #include "strokefont.h"
 
 #include <sstream>
-// defining pi
-#define M_PI 3.1415926535897932384626433832795
-// Global variables for game use
-float gameTime = 0;
-float altitude = 0;
-int score = 0;
-int startfuel = INITIAL_FUEL;
-float zoomFactor = 2.0;
-bool gameRunning = true;
-bool gameWin = false;
-int lossReason = 0;
+
 
 void World::updateState(float elapsedTime)
 
-{	// Checking if the game is currently running
-	if (gameRunning) {
-		// Increment the time counter
-		gameTime += elapsedTime;
-
-		// See if any keys are pressed for thrust
-
-		if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) // right arrow
-			lander->rotateCW(elapsedTime);
-
-		if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) // left arrow
-			lander->rotateCCW(elapsedTime);
-
-		if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) // down arrow
-			lander->addThrust(elapsedTime);
-
-		// Update the position and velocity
-
-		lander->updatePose(elapsedTime);
-
-		// See if the lander has touched the terrain
-
-		vec3 closestTerrainPoint = landscape->findClosestPoint(lander->centrePosition());
-		float closestDistance = (closestTerrainPoint - lander->centrePosition()).length();
-
-		// Find if the view should be zoomed
-
-		zoomView = (closestDistance < ZOOM_RADIUS);
-
-		// Check for landing or collision and let the user know
-		int segmentIndex = landscape->findSegmentBelow(lander->centrePosition());
-		// Getting the altitude for current position
-		altitude = landscape->findLanderAltitude(segmentIndex, lander->centrePosition(), lander->getDimensions().y);
-		// Check if altitude is close enough to land
-		if (abs(altitude) < 10e-2) {
-			// check speed
-			vec3 v = lander->getVelocity();
-			if (abs(v.x) < 0.5 && abs(v.y) < 1) {
-				// check segment is flat and lander is contained
-				lossReason = landscape->isSegmentGoodToLand(segmentIndex, lander->getOrientation(), lander->centrePosition(), lander->getDimensions().x);
-				if (lossReason == 0) {
-					lander->stopLander();
-					GameWin();
-				}
-				else {
-					// Report why they lost
-					switch (lossReason) {
-					case 1:
-						GameOver("You attempted to land on a segment that was not flat");
-						break;
-					case 2:
-					case 3:
-						GameOver("You did not fit on the surface");
-						break;
-					default:
-						GameOver("You crashed");
-						break;
-					}
-				}
-			}
-			else {
-				// game over
-				GameOver("You were moving too fast");
-			}
-		}
-		else if (altitude < 0) {
-			// game over
-			GameOver("You crashed");
+{
+	// Simulate in steps of stepTime, carrying any remainder over to
+	// the next frame, so that the outcome does not depend on the
+	// frame rate.
+
+	if (elapsedTime > MAX_FRAME_TIME)
+		elapsedTime = MAX_FRAME_TIME;
+
+	accumulator += elapsedTime;
+
+	while (accumulator >= stepTime) {
+
+		prevPosition = lander->centrePosition();
+		prevOrientation = lander->getOrientation();
+
+		// While 'b' is held, go back through the recent steps
+		// instead.  Play continues from there when it is released.
+
+		if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS) {
+			rewind->seek(*session, rewind->position() - REWIND_SPEED);
+			accumulator -= stepTime;
+			continue;
 		}
-	}
-	else {		
-		// wait for key
-		if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS) {
-			// start new game
-			HardReset();
+
+		// Step the game with the current keyboard controls (or the
+		// autopilot's)
+
+		bool wasRunning = session->running();
+
+		Controls controls = input->controls(*session, stepTime);
+
+		if (autopilotOn)
+			controls = (controls & ~(CONTROL_ROTATE_CW | CONTROL_ROTATE_CCW | CONTROL_THRUST)) | autopilot->controls(*session, stepTime);
+
+		if (resetRequested) {
+			controls |= CONTROL_RESET;
+			resetRequested = false;
 		}
-		else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-			if (startfuel != 0) {
-				// continue
-				SoftReset();
-			}
+
+		rewind->record(*session, controls);
+
+		if (recording) {
+			recording->steps.resize(rewind->position() - 1); // (forgetting any steps rewound over)
+			recording->add(controls);
 		}
+
+		session->step(controls, stepTime);
+
+		// Reset zoom factor to default when a new landing starts
+
+		if (!wasRunning && session->running())
+			zoomFactor = 2;
+
+		accumulator -= stepTime;
 	}
 
-}
+	// Find if the view should be zoomed
 
-void World::SoftReset() {
-	// Set the starting fuel to current fuel
-	startfuel = lander->fuel();
-	// Reset zoom factor to default
-	zoomFactor = 2;
-	// Reset game time
-	gameTime = 0;
-	// reset the lander velocity and position
-	lander->reset();
-	// set game to run again
-	gameRunning = true;
+	zoomView = (session->distanceToTerrain() < ZOOM_RADIUS);
 }
 
-void World::HardReset() {
-	// Soft reset
-	SoftReset();
-	// reset the score
-	score = 0;
-	// reset the fuel
-	startfuel = INITIAL_FUEL;
-	lander->resetFuel();
-}
 
-void World::GameWin() {
-	// Game needs to stop
-	gameRunning = false;
-	gameWin = true;
-	// Calculate and add score, score is split 30% for time to land, 30% for fuel used, 40% for size of platform landed on
-	score += 300 - gameTime  + 300 * (startfuel - lander->fuel()) / startfuel*10 + 400 * lander->getDimensions().y / landscape->getSegmentWidth(landscape->findSegmentBelow(lander->centrePosition()));
-}
+// Find the lander pose to draw: part way from the pose before the
+// last step to the current one, by the fraction of a step that has
+// not been simulated yet.
+
+void World::interpolatedPose( vec3 &pos, float &orientation )
 
-void World::GameOver(string reason) {
-	// Game needs to stop
-	gameRunning = false;
-	gameWin = false;
+{
+	float alpha = accumulator / stepTime;
+
+	pos = lander->centrePosition();
+	orientation = lander->getOrientation();
+
+	// Don't interpolate across a jump (wraparound or reset)
+
+	if ((pos - prevPosition).length() > MAX_LERP_DIST)
+		return;
+
+	pos = prevPosition + alpha * (pos - prevPosition);
+	orientation = prevOrientation + alpha * (orientation - prevOrientation);
 }
 
+
 void World::draw()
 
 {
   mat4 worldToViewTransform;
+
+  vec3  landerPos;
+  float landerOrientation;
+  interpolatedPose( landerPos, landerOrientation );
+
   //zoomView = true;
   if (!zoomView) {
 
@@ -165,7 +119,7 @@ void World::draw()
 		worldToViewTransform
 			= translate(0, BOTTOM_SPACE, 0)
 			* scale(s, s, 1)
-			* translate(-lander->centrePosition().x, -lander->centrePosition().y, 0);
+			* translate(-landerPos.x, -landerPos.y, 0);
 	}
 	else {
 		worldToViewTransform
@@ -190,7 +144,7 @@ void World::draw()
 	  worldToViewTransform
 		  = translate(0, BOTTOM_SPACE, 0)
 		  * scale(s, s, 1)
-		  * translate(-lander->centrePosition().x, -lander->centrePosition().y, 0);
+		  * translate(-landerPos.x, -landerPos.y, 0);
 
   }
 
@@ -198,7 +152,9 @@ void World::draw()
   // so that they can append their own transforms before passing the
   // complete transform to the vertex shader.
   landscape->draw( worldToViewTransform);
-  lander->draw(worldToViewTransform);
+  if (heatmap && heatmapView > 0)
+    heatmap->draw( worldToViewTransform, heatmapView == 2 );
+  lander->draw(worldToViewTransform, landerPos, landerOrientation);
 
   // Draw the heads-up display (i.e. all text).
 
@@ -211,12 +167,12 @@ void World::draw()
   // Draw the score with placeholder 0's
   ss << "SCORE ";
   for (int i = 1000; i >= 1; i /= 10) {
-	  ss << (score % (i * 10)) / i;
+	  ss << (session->getScore() % (i * 10)) / i;
   };
   drawStrokeString( ss.str(), -0.95, 0.75, 0.05, glGetUniformLocation( myGPUProgram->id(), "MVP") );
   // finding the number of minutes and seconds
-  int m = (int)(gameTime / 60);
-  int s = (int)gameTime % 60;
+  int m = (int)(session->getTime() / 60);
+  int s = (int)session->getTime() % 60;
   stringstream time;
   // Draw the time with place holder 0's and split for minutes
   time << "TIME ";
@@ -241,7 +197,7 @@ void World::draw()
   ss.str(std::string());
   ss.precision(2);
   // Draw the altitude with percision 2 as it helps player see how close they are
-  ss << "ALTITUDE " << altitude;
+  ss << "ALTITUDE " << session->getAltitude();
   drawStrokeString(ss.str(), 0.1, 0.75, 0.05, glGetUniformLocation(myGPUProgram->id(), "MVP"));
 
   ss.str(std::string());
@@ -290,10 +246,10 @@ void World::draw()
   // Check if the game is in running mode
   float pos = -0.4;
   float size = 0.05;
-  if (!gameRunning) {
+  if (!session->running()) {
 	  ss.str(std::string());
 	  // display win screen
-	  if (gameWin) {
+	  if (session->won()) {
 		  ss << "Game Win";
 		  pos = -0.3;
 		  size = 0.1;
@@ -301,7 +257,7 @@ void World::draw()
 	  // display loss screen
 	  else {
 		  ss << "Game Loss:";
-		  switch (lossReason) {
+		  switch (session->getLossReason()) {
 		  case 1:
 			  ss << "You attempted to land on a segment that was not flat";
 			  break;
@@ -317,7 +273,7 @@ void World::draw()
 	  drawStrokeString(ss.str(), pos, 0.35, size, glGetUniformLocation(myGPUProgram->id(), "MVP"));
 	  // Print the game options for continue game or new game
 	  ss.str(std::string());
-	  if (startfuel == 0) {
+	  if (session->getStartFuel() == 0) {
 		  ss << "Out of fuel. Press 'n' to start new game.";
 	  }
 	  else {
@@ -6,55 +6,159 @@
 
 
 #include "headers.h"
-#include "landscape.h"
-#include "lander.h"
+#include "session.h"
+#include "keyboardInput.h"
+#include "replay.h"
+#include "rewind.h"
+#include "heatmap.h"
+#include "controllers.h"
+#include "mpcAutopilot.h"
 #include "ll.h"
 
 
-#define BOTTOM_SPACE 0.1f // amount of blank space below terrain (in viewing coordinates) 
+#define SIM_RATE       60    // default simulation steps per second
+#define MAX_FRAME_TIME 0.25  // longest frame that is simulated (s); longer frames slow the game
+#define MAX_LERP_DIST  20    // lander moves further than this in a step only when it jumps (m)
+#define REWIND_SPEED   2     // steps rewound per step while 'b' is held
+#define HEATMAP_CELLS_X 64   // heatmap overlay cells (see heatmap.h)
+#define HEATMAP_CELLS_Y 32
 
 
+// The world steps its session at a fixed rate, independent of the
+// frame rate, and draws the lander interpolated between the last two
+// steps.
+
 class World {
 
-  Landscape *landscape;
-  Lander    *lander;
+  Session     *session;	 // the game being shown
+  InputSource *input;	 // where the lander controls come from
+  Landscape   *landscape; // (the session's landscape and lander)
+  Lander      *lander;
+  DistanceField *field;	 // optional, for the zoom decision
+  ConfigObstacle *obstacle; // optional, for collisions of the whole outline
   bool       zoomView; // show zoomed view when lander is close to landscape
+  float      zoomFactor; // current zoom (2 = whole landscape)
   GLFWwindow *window;
 
+  float      stepTime;	   // duration of one simulation step (s)
+  float      accumulator;  // time not yet simulated (s), in [0,stepTime)
+  vec3       prevPosition; // lander pose before the last step
+  float      prevOrientation;
+  bool       resetRequested; // reset the lander on the next step
+
+  RewindBuffer *rewind;	   // recent states, for rewinding
+  Replay     *recording;   // optional, the steps so far
+  LandingHeatmap *heatmap; // optional, computed in the background
+  int        heatmapView;  // 0 = hidden, 1 = landing success, 2 = fuel used
+  MpcTerrain *mpcTerrain;  // for the autopilot
+  MpcAutopilot *autopilot; // flies the lander in place of the keyboard when on
+  bool       autopilotOn;
+  const char *recordPath;
+
+  void interpolatedPose( vec3 &pos, float &orientation );
+
  public:
 
-  World( GLFWwindow *w ) {
-    landscape = new Landscape();
-    lander    = new Lander( maxX(), maxY() ); // provide world size to help position lander
+  World( GLFWwindow *w, float simRate = SIM_RATE, bool useDistanceField = false, bool useShape = false, const char *replayPath = NULL,
+         int heatmapSamples = 0 ) {
+    session   = new Session();
+    input     = new KeyboardInput( w );
+    landscape = session->getLandscape();
+    lander    = session->getLander();
+    field     = NULL;
+    if (useDistanceField) {
+      field = new DistanceField( landscape, minX(), maxX(), minY(), maxY() );
+      session->setDistanceField( field );
+    }
+    obstacle  = NULL;
+    if (useShape) {
+      obstacle = new ConfigObstacle( landscape, lander->getVertices() );
+      session->setConfigObstacle( obstacle );
+    }
     zoomView  = false;
+    zoomFactor = 2.0;
     window    = w;
+
+    stepTime    = 1.0 / simRate;
+    accumulator = 0;
+    prevPosition    = lander->centrePosition();
+    prevOrientation = lander->getOrientation();
+    resetRequested  = false;
+
+    rewind     = new RewindBuffer( stepTime );
+    recording  = NULL;
+    recordPath = replayPath;
+    if (recordPath) {
+      recording = new Replay();
+      recording->begin( *session, stepTime );
+    }
+
+    // Work out the landing heatmap on all but one core, for the
+    // descent controller at this step rate
+
+    heatmap     = NULL;
+    heatmapView = 0;
+    if (heatmapSamples > 0) {
+      heatmap = new LandingHeatmap( landscape, HEATMAP_CELLS_X, HEATMAP_CELLS_Y, heatmapSamples );
+      heatmap->controller = descentController;
+      heatmap->deltaT     = stepTime;
+      heatmap->setupVAO();
+      heatmap->start( max( 1, (int) thread::hardware_concurrency() - 1 ) );
+      heatmapView = 1;
+    }
+
+    mpcTerrain  = new MpcTerrain( landscape, lander->getDimensions() );
+    autopilot   = new MpcAutopilot( mpcTerrain );
+    autopilotOn = false;
+
+    landscape->setupVAO();
+    lander->setupVAO();
   }
 
   void draw();
 
   void updateState( float elapsedTime );
 
-  void SoftReset();
+  void RenderScore();
 
-  void HardReset();
+  // The reset is applied as a control of the next step, so that it
+  // is in the recording
 
-  void GameWin();
+  void resetLander() {
+    resetRequested = true;
+  }
 
-  void GameOver(string reason);
+  // Show the heatmap's landing success, then its fuel used, then
+  // nothing
 
-  void RenderScore();
+  void cycleHeatmap() {
+    heatmapView = (heatmapView + 1) % 3;
+  }
 
-  void resetLander() {
-    lander->reset();
+  // Fly the lander with the autopilot, or stop.  The keyboard still
+  // starts new games.
+
+  void toggleAutopilot() {
+    autopilotOn = !autopilotOn;
+    autopilot->restart();
+  }
+
+  // Write the recording, if any
+
+  void saveRecording() {
+    if (recording) {
+      recording->finish( *session );
+      recording->write( recordPath );
+    }
   }
 
   // World extremes (in world coordinates)
 
-  float minX() { return 0; }
-  float maxX() { return landscape->maxX(); }
+  float minX() { return session->minX(); }
+  float maxX() { return session->maxX(); }
 
-  float minY() { return 0; }
-  float maxY() { return (landscape->maxX() - landscape->minX()) / SCREEN_ASPECT * (2 - BOTTOM_SPACE) / 2; }
+  float minY() { return session->minY(); }
+  float maxY() { return session->maxY(); }
 };
 
 